@@ -33,6 +33,7 @@ For discussion please visit http://box2d.org/forum
 
 #include <Box2D/Common/b2Settings.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Task.h>
 #include <Box2D/Common/b2Timer.h>
 
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
@@ -104,6 +104,9 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Rebuild the embedded tree top down. See b2DynamicTree::RebuildTopDown.
+	void RebuildTree(b2TaskExecutor* executor = NULL);
+
 private:
 
 	friend class b2DynamicTree;
@@ -254,4 +257,9 @@ inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 	m_tree.ShiftOrigin(newOrigin);
 }
 
+inline void b2BroadPhase::RebuildTree(b2TaskExecutor* executor)
+{
+	m_tree.RebuildTopDown(executor);
+}
+
 #endif
@@ -17,7 +17,118 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2Task.h>
 #include <memory.h>
+#include <algorithm>
+
+// Binned SAH settings for RebuildTopDown.
+#define b2_treeBuildBins 16
+#define b2_treeBuildMaxSahDepth 48
+#define b2_treeBuildMaxSplitDepth 8
+#define b2_minParallelTreeBuild 4096
+
+struct b2TreeBuildJob
+{
+	int32 begin, end;
+	int32 slot;
+	int32 depth;
+};
+
+/// The subtrees below the first splits of a top down build, each built by one worker.
+class b2TreeBuildTask : public b2Task
+{
+public:
+	b2TreeBuildTask(b2DynamicTree* tree, int32* leaves, const int32* internalNodes, int32 splitDepth)
+	{
+		m_tree = tree;
+		m_leaves = leaves;
+		m_internalNodes = internalNodes;
+		m_splitDepth = splitDepth;
+		m_jobs = (b2TreeBuildJob*)b2Alloc((1 << splitDepth) * sizeof(b2TreeBuildJob));
+		m_jobCount = 0;
+		m_topNodes = (int32*)b2Alloc((1 << splitDepth) * sizeof(int32));
+		m_topCount = 0;
+	}
+
+	~b2TreeBuildTask()
+	{
+		b2Free(m_topNodes);
+		b2Free(m_jobs);
+	}
+
+	void Execute(int32 begin, int32 end, int32 workerIndex)
+	{
+		B2_NOT_USED(workerIndex);
+		for (int32 i = begin; i < end; ++i)
+		{
+			const b2TreeBuildJob& job = m_jobs[i];
+			m_tree->BuildTopDown(m_leaves, m_internalNodes, job.begin, job.end, job.slot, job.depth, NULL);
+		}
+	}
+
+	b2DynamicTree* m_tree;
+	int32* m_leaves;
+	const int32* m_internalNodes;
+	int32 m_splitDepth;
+
+	// Ranges left for the workers.
+	b2TreeBuildJob* m_jobs;
+	int32 m_jobCount;
+
+	// Nodes above the jobs in preorder, finished once the jobs are done.
+	int32* m_topNodes;
+	int32 m_topCount;
+};
+
+namespace
+{
+	struct b2CentroidBin
+	{
+		b2CentroidBin(const b2TreeNode* nodes, int32 axis, float32 lower, float32 scale)
+			: nodes(nodes), axis(axis), lower(lower), scale(scale) {}
+
+		int32 operator()(int32 leaf) const
+		{
+			const b2AABB& aabb = nodes[leaf].aabb;
+			float32 c = aabb.lowerBound(axis) + aabb.upperBound(axis);
+			int32 bin = (int32)((c - lower) * scale);
+			return b2Clamp(bin, 0, b2_treeBuildBins - 1);
+		}
+
+		const b2TreeNode* nodes;
+		int32 axis;
+		float32 lower;
+		float32 scale;
+	};
+
+	struct b2BinBelow
+	{
+		b2BinBelow(const b2CentroidBin& bin, int32 split) : bin(bin), split(split) {}
+
+		bool operator()(int32 leaf) const
+		{
+			return bin(leaf) <= split;
+		}
+
+		b2CentroidBin bin;
+		int32 split;
+	};
+
+	struct b2CentroidLess
+	{
+		b2CentroidLess(const b2TreeNode* nodes, int32 axis) : nodes(nodes), axis(axis) {}
+
+		bool operator()(int32 a, int32 b) const
+		{
+			const b2AABB& aabbA = nodes[a].aabb;
+			const b2AABB& aabbB = nodes[b].aabb;
+			return aabbA.lowerBound(axis) + aabbA.upperBound(axis) < aabbB.lowerBound(axis) + aabbB.upperBound(axis);
+		}
+
+		const b2TreeNode* nodes;
+		int32 axis;
+	};
+}
 
 b2DynamicTree::b2DynamicTree()
 {
@@ -767,6 +878,247 @@ void b2DynamicTree::RebuildBottomUp()
 	Validate();
 }
 
+void b2DynamicTree::RebuildTopDown(b2TaskExecutor* executor)
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	int32* leaves = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count] = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	// A range of k leaves uses k - 1 internal nodes. Allocate them all up front so the node
+	// pool cannot grow while subtrees are being built.
+	int32* internalNodes = (int32*)b2Alloc(b2Max(count - 1, 1) * sizeof(int32));
+	for (int32 i = 0; i < count - 1; ++i)
+	{
+		internalNodes[i] = AllocateNode();
+	}
+
+	int32 workerCount = executor != NULL ? executor->GetWorkerCount() : 1;
+	if (workerCount > 1 && count >= b2_minParallelTreeBuild)
+	{
+		int32 splitDepth = 0;
+		while ((1 << splitDepth) < 4 * workerCount && splitDepth < b2_treeBuildMaxSplitDepth)
+		{
+			++splitDepth;
+		}
+
+		b2TreeBuildTask task(this, leaves, internalNodes, splitDepth);
+		m_root = BuildTopDown(leaves, internalNodes, 0, count, 0, 0, &task);
+		executor->Run(&task, task.m_jobCount);
+
+		// Children come after their parent in preorder.
+		for (int32 i = task.m_topCount - 1; i >= 0; --i)
+		{
+			FinishNode(task.m_topNodes[i]);
+		}
+	}
+	else
+	{
+		m_root = BuildTopDown(leaves, internalNodes, 0, count, 0, 0, NULL);
+	}
+
+	b2Free(internalNodes);
+	b2Free(leaves);
+
+	Validate();
+}
+
+// Reorder leaves[begin, end) so that [begin, mid) and [mid, end) are the two children of the
+// node above them, and return mid.
+int32 b2DynamicTree::PartitionLeaves(int32* leaves, int32 begin, int32 end, int32 depth) const
+{
+	int32 count = end - begin;
+	if (count == 2)
+	{
+		return begin + 1;
+	}
+
+	// Split along the longest axis of the centroids. Centroids are kept doubled.
+	b2Vec2 lower = m_nodes[leaves[begin]].aabb.lowerBound + m_nodes[leaves[begin]].aabb.upperBound;
+	b2Vec2 upper = lower;
+	for (int32 i = begin + 1; i < end; ++i)
+	{
+		const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+		b2Vec2 c = aabb.lowerBound + aabb.upperBound;
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2Vec2 extent = upper - lower;
+	int32 axis = extent.x >= extent.y ? 0 : 1;
+	int32 mid = begin + count / 2;
+
+	if (extent(axis) <= b2_epsilon || depth >= b2_treeBuildMaxSahDepth)
+	{
+		// Degenerate or too deep: a median split keeps the tree balanced.
+		std::nth_element(leaves + begin, leaves + mid, leaves + end, b2CentroidLess(m_nodes, axis));
+		return mid;
+	}
+
+	b2CentroidBin bin(m_nodes, axis, lower(axis), b2_treeBuildBins / extent(axis));
+
+	int32 binCounts[b2_treeBuildBins];
+	b2AABB binBoxes[b2_treeBuildBins];
+	for (int32 i = 0; i < b2_treeBuildBins; ++i)
+	{
+		binCounts[i] = 0;
+	}
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+		int32 b = bin(leaves[i]);
+		if (binCounts[b] == 0)
+		{
+			binBoxes[b] = aabb;
+		}
+		else
+		{
+			binBoxes[b].Combine(aabb);
+		}
+		++binCounts[b];
+	}
+
+	// Sweep from the right to get the cost of everything above each split, then from the left.
+	float32 rightCosts[b2_treeBuildBins];
+	int32 rightCount = 0;
+	b2AABB rightBox;
+	for (int32 i = b2_treeBuildBins - 1; i > 0; --i)
+	{
+		if (binCounts[i] > 0)
+		{
+			if (rightCount == 0)
+			{
+				rightBox = binBoxes[i];
+			}
+			else
+			{
+				rightBox.Combine(binBoxes[i]);
+			}
+			rightCount += binCounts[i];
+		}
+		rightCosts[i - 1] = rightCount > 0 ? rightCount * rightBox.GetPerimeter() : 0.0f;
+	}
+
+	float32 minCost = b2_maxFloat;
+	int32 split = -1;
+	int32 leftCount = 0;
+	b2AABB leftBox;
+	for (int32 i = 0; i < b2_treeBuildBins - 1; ++i)
+	{
+		if (binCounts[i] > 0)
+		{
+			if (leftCount == 0)
+			{
+				leftBox = binBoxes[i];
+			}
+			else
+			{
+				leftBox.Combine(binBoxes[i]);
+			}
+			leftCount += binCounts[i];
+		}
+
+		if (leftCount == 0 || leftCount == count)
+		{
+			continue;
+		}
+
+		float32 cost = leftCount * leftBox.GetPerimeter() + rightCosts[i];
+		if (cost < minCost)
+		{
+			minCost = cost;
+			split = i;
+		}
+	}
+
+	if (split < 0)
+	{
+		std::nth_element(leaves + begin, leaves + mid, leaves + end, b2CentroidLess(m_nodes, axis));
+		return mid;
+	}
+
+	return (int32)(std::partition(leaves + begin, leaves + end, b2BinBelow(bin, split)) - leaves);
+}
+
+// Build the subtree over leaves[begin, end) using internalNodes[slot, slot + end - begin - 1)
+// and return its root. With a task, ranges at the task's split depth are queued as jobs and
+// the nodes above them are left for the caller to finish.
+int32 b2DynamicTree::BuildTopDown(int32* leaves, const int32* internalNodes, int32 begin, int32 end,
+								  int32 slot, int32 depth, b2TreeBuildTask* task)
+{
+	if (end - begin == 1)
+	{
+		return leaves[begin];
+	}
+
+	int32 index = internalNodes[slot];
+	if (task != NULL && depth == task->m_splitDepth)
+	{
+		b2TreeBuildJob& job = task->m_jobs[task->m_jobCount++];
+		job.begin = begin;
+		job.end = end;
+		job.slot = slot;
+		job.depth = depth;
+		return index;
+	}
+
+	if (task != NULL)
+	{
+		task->m_topNodes[task->m_topCount++] = index;
+	}
+
+	int32 mid = PartitionLeaves(leaves, begin, end, depth);
+	int32 child1 = BuildTopDown(leaves, internalNodes, begin, mid, slot + 1, depth + 1, task);
+	int32 child2 = BuildTopDown(leaves, internalNodes, mid, end, slot + mid - begin, depth + 1, task);
+
+	b2TreeNode* node = m_nodes + index;
+	node->child1 = child1;
+	node->child2 = child2;
+	m_nodes[child1].parent = index;
+	m_nodes[child2].parent = index;
+
+	if (task == NULL)
+	{
+		FinishNode(index);
+	}
+
+	return index;
+}
+
+void b2DynamicTree::FinishNode(int32 index)
+{
+	b2TreeNode* node = m_nodes + index;
+	const b2TreeNode* child1 = m_nodes + node->child1;
+	const b2TreeNode* child2 = m_nodes + node->child2;
+	node->aabb.Combine(child1->aabb, child2->aabb);
+	node->height = 1 + b2Max(child1->height, child2->height);
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -24,6 +24,9 @@
 
 #define b2_nullNode (-1)
 
+class b2TaskExecutor;
+class b2TreeBuildTask;
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -118,6 +121,14 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Rebuild the tree from scratch, splitting the leaves top down with a binned surface
+	/// area heuristic. This is O(n log n) and gives a much better tree than incremental
+	/// insertion after many proxies are created at once, such as when a level loads.
+	/// Proxy ids and fat AABBs are unchanged. When an executor is given, the subtrees
+	/// below the first few splits are built on its workers; the result does not depend
+	/// on the number of workers.
+	void RebuildTopDown(b2TaskExecutor* executor = NULL);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -139,6 +150,13 @@ private:
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	friend class b2TreeBuildTask;
+
+	int32 PartitionLeaves(int32* leaves, int32 begin, int32 end, int32 depth) const;
+	int32 BuildTopDown(int32* leaves, const int32* internalNodes, int32 begin, int32 end,
+					   int32 slot, int32 depth, b2TreeBuildTask* task);
+	void FinishNode(int32 index);
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
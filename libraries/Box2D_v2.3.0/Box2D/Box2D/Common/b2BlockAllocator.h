@@ -32,20 +32,27 @@ struct b2Chunk;
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+/// It is not thread safe. A world can be given a derived allocator that is;
+/// see b2World::b2World.
 class b2BlockAllocator
 {
 public:
 	b2BlockAllocator();
-	~b2BlockAllocator();
+	virtual ~b2BlockAllocator();
 
 	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
-	void* Allocate(int32 size);
+	virtual void* Allocate(int32 size);
 
 	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
-	void Free(void* p, int32 size);
+	virtual void Free(void* p, int32 size);
 
 	void Clear();
 
+protected:
+
+	static int32 s_blockSizes[b2_blockSizes];
+	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
+
 private:
 
 	b2Chunk* m_chunks;
@@ -54,8 +61,6 @@ private:
 
 	b2Block* m_freeLists[b2_blockSizes];
 
-	static int32 s_blockSizes[b2_blockSizes];
-	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
 };
 
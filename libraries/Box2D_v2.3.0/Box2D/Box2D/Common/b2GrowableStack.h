@@ -20,6 +20,7 @@
 #define B2_GROWABLE_STACK_H
 #include <Box2D/Common/b2Settings.h>
 #include <memory.h>
+#include <string.h>
 
 /// This is a growable LIFO stack with an initial capacity of N.
 /// If the stack size exceeds the initial capacity, the heap is used
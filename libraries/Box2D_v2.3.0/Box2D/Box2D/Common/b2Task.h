@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TASK_H
+#define B2_TASK_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A unit of parallel work. Execute is called with disjoint [begin, end) ranges that together
+/// cover the whole task, along with the index of the worker running the range.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	virtual void Execute(int32 begin, int32 end, int32 workerIndex) = 0;
+};
+
+/// Runs tasks for the world on the application's threads. Install one with
+/// b2World::SetTaskExecutor to solve islands in parallel.
+class b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// The number of workers that may run a task at once. Worker indices passed to
+	/// b2Task::Execute are less than this.
+	virtual int32 GetWorkerCount() const = 0;
+
+	/// Run task over [0, count) and return once every item is done.
+	virtual void Run(b2Task* task, int32 count) = 0;
+};
+
+#endif
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideContactBatch;
 
 struct b2VelocityConstraintPoint
 {
@@ -64,6 +65,10 @@ struct b2ContactSolverDef
 	b2Position* positions;
 	b2Velocity* velocities;
 	b2StackAllocator* allocator;
+
+	/// Island indices of each contact's bodies, two per contact. When NULL the bodies'
+	/// own island indices are used, which are only valid for the island being built.
+	const int32* indices;
 };
 
 class b2ContactSolver
@@ -81,6 +86,13 @@ public:
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	/// Pack the velocity constraints into batches of four that share no dynamic body,
+	/// so the velocity iterations can solve a batch's lanes at once. Called from
+	/// InitializeVelocityConstraints when m_step.wideContacts is set.
+	void PrepareWideConstraints();
+	void SolveWideVelocityConstraints();
+	void StoreWideImpulses();
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -89,6 +101,8 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+	b2WideContactBatch* m_wideBatches;
+	int32 m_wideBatchCount;
 };
 
 #endif
@@ -0,0 +1,562 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_WIDE_SSE2 1
+#include <emmintrin.h>
+#else
+#define B2_WIDE_SSE2 0
+#endif
+
+// Four lanes of float32. Without SSE2 the same operations are done a lane at a time,
+// so the batched solver still runs, just without the speedup.
+#if B2_WIDE_SSE2
+
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2SplatW(float32 x) { return _mm_set1_ps(x); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+
+// Masks have every bit of a lane set where the comparison holds.
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+
+// Lanes of a where mask is set, otherwise lanes of b.
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+#else
+
+struct b2FloatW
+{
+	float32 x[4];
+};
+
+inline b2FloatW b2LoadW(const float32* p)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i) { r.x[i] = p[i]; }
+	return r;
+}
+
+inline void b2StoreW(float32* p, b2FloatW a)
+{
+	for (int32 i = 0; i < 4; ++i) { p[i] = a.x[i]; }
+}
+
+inline b2FloatW b2SplatW(float32 x)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i) { r.x[i] = x; }
+	return r;
+}
+
+#define B2_WIDE_BINARY(name, expression) \
+	inline b2FloatW name(b2FloatW a, b2FloatW b) \
+	{ \
+		b2FloatW r; \
+		for (int32 i = 0; i < 4; ++i) { float32 x = a.x[i], y = b.x[i]; r.x[i] = (expression); } \
+		return r; \
+	}
+
+B2_WIDE_BINARY(b2AddW, x + y)
+B2_WIDE_BINARY(b2SubW, x - y)
+B2_WIDE_BINARY(b2MulW, x * y)
+B2_WIDE_BINARY(b2MinW, b2Min(x, y))
+B2_WIDE_BINARY(b2MaxW, b2Max(x, y))
+
+// Masks hold 1 where the comparison holds and 0 otherwise.
+B2_WIDE_BINARY(b2GreaterEqualW, x >= y ? 1.0f : 0.0f)
+B2_WIDE_BINARY(b2AndW, x != 0.0f && y != 0.0f ? 1.0f : 0.0f)
+
+#undef B2_WIDE_BINARY
+
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i) { r.x[i] = mask.x[i] != 0.0f ? a.x[i] : b.x[i]; }
+	return r;
+}
+
+#endif
+
+inline b2FloatW b2MulAddW(b2FloatW a, b2FloatW b, b2FloatW c) { return b2AddW(a, b2MulW(b, c)); }
+inline b2FloatW b2MulSubW(b2FloatW a, b2FloatW b, b2FloatW c) { return b2SubW(a, b2MulW(b, c)); }
+
+const int32 b2_wideLanes = 4;
+
+struct b2WideContactPoint
+{
+	float32 rAx[b2_wideLanes], rAy[b2_wideLanes];
+	float32 rBx[b2_wideLanes], rBy[b2_wideLanes];
+	float32 normalImpulse[b2_wideLanes];
+	float32 tangentImpulse[b2_wideLanes];
+	float32 normalMass[b2_wideLanes];
+	float32 tangentMass[b2_wideLanes];
+	float32 velocityBias[b2_wideLanes];
+};
+
+// Up to four velocity constraints with the same point count, laid out by lane. Unused
+// lanes have a constraint of -1 and zero masses, so they solve to zero impulse.
+struct b2WideContactBatch
+{
+	int32 constraints[b2_wideLanes];
+	int32 indexA[b2_wideLanes], indexB[b2_wideLanes];
+	int32 pointCount;
+	float32 invMassA[b2_wideLanes], invIA[b2_wideLanes];
+	float32 invMassB[b2_wideLanes], invIB[b2_wideLanes];
+	float32 normalX[b2_wideLanes], normalY[b2_wideLanes];
+	float32 friction[b2_wideLanes];
+	float32 tangentSpeed[b2_wideLanes];
+	b2WideContactPoint points[b2_maxManifoldPoints];
+
+	// Block solver terms, only used when pointCount is 2. K is symmetric.
+	float32 k11[b2_wideLanes], k12[b2_wideLanes], k22[b2_wideLanes];
+	float32 normalMass11[b2_wideLanes], normalMass12[b2_wideLanes];
+	float32 normalMass21[b2_wideLanes], normalMass22[b2_wideLanes];
+};
+
+// A batch still accepting constraints while lanes are being assigned.
+struct b2OpenWideBatch
+{
+	int32 batch;
+	int32 laneCount;
+	int32 bodies[2 * b2_wideLanes];
+	int32 bodyCount;
+};
+
+// How many recent batches a constraint may be placed in before a new one is started.
+const int32 b2_wideWindow = 8;
+
+inline bool b2IsMovable(float32 invMass, float32 invI)
+{
+	return invMass > 0.0f || invI > 0.0f;
+}
+
+// Greedily assigns each velocity constraint to the first recent batch of its point count
+// that holds neither of its movable bodies. Static and kinematic bodies may repeat
+// within a batch because the solver never changes their velocities. Returns the number
+// of batches, and fills them in when batches is not NULL, so the same assignment can be
+// counted and then built.
+static int32 b2AssignWideLanes(const b2ContactVelocityConstraint* constraints, int32 count, b2WideContactBatch* batches)
+{
+	b2OpenWideBatch open[b2_maxManifoldPoints][b2_wideWindow];
+	int32 openCount[b2_maxManifoldPoints] = {0};
+	int32 batchCount = 0;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = constraints + i;
+		int32 bodies[2];
+		int32 bodyCount = 0;
+		if (b2IsMovable(vc->invMassA, vc->invIA))
+		{
+			bodies[bodyCount++] = vc->indexA;
+		}
+		if (b2IsMovable(vc->invMassB, vc->invIB))
+		{
+			bodies[bodyCount++] = vc->indexB;
+		}
+
+		b2OpenWideBatch* window = open[vc->pointCount - 1];
+		int32& windowCount = openCount[vc->pointCount - 1];
+
+		int32 slot = -1;
+		for (int32 j = 0; j < windowCount && slot == -1; ++j)
+		{
+			bool conflict = false;
+			for (int32 k = 0; k < window[j].bodyCount && conflict == false; ++k)
+			{
+				for (int32 m = 0; m < bodyCount; ++m)
+				{
+					conflict = conflict || window[j].bodies[k] == bodies[m];
+				}
+			}
+
+			if (conflict == false)
+			{
+				slot = j;
+			}
+		}
+
+		if (slot == -1)
+		{
+			if (windowCount == b2_wideWindow)
+			{
+				// Leave the oldest batch partly filled.
+				for (int32 j = 1; j < windowCount; ++j)
+				{
+					window[j - 1] = window[j];
+				}
+				--windowCount;
+			}
+
+			slot = windowCount++;
+			window[slot].batch = batchCount++;
+			window[slot].laneCount = 0;
+			window[slot].bodyCount = 0;
+
+			if (batches)
+			{
+				b2WideContactBatch* batch = batches + window[slot].batch;
+				memset(batch, 0, sizeof(b2WideContactBatch));
+				batch->pointCount = vc->pointCount;
+				for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+				{
+					batch->constraints[lane] = -1;
+				}
+			}
+		}
+
+		b2OpenWideBatch* target = window + slot;
+		if (batches)
+		{
+			int32 lane = target->laneCount;
+			b2WideContactBatch* batch = batches + target->batch;
+			batch->constraints[lane] = i;
+			batch->indexA[lane] = vc->indexA;
+			batch->indexB[lane] = vc->indexB;
+			batch->invMassA[lane] = vc->invMassA;
+			batch->invIA[lane] = vc->invIA;
+			batch->invMassB[lane] = vc->invMassB;
+			batch->invIB[lane] = vc->invIB;
+			batch->normalX[lane] = vc->normal.x;
+			batch->normalY[lane] = vc->normal.y;
+			batch->friction[lane] = vc->friction;
+			batch->tangentSpeed[lane] = vc->tangentSpeed;
+
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				const b2VelocityConstraintPoint* vcp = vc->points + j;
+				b2WideContactPoint* wcp = batch->points + j;
+				wcp->rAx[lane] = vcp->rA.x;
+				wcp->rAy[lane] = vcp->rA.y;
+				wcp->rBx[lane] = vcp->rB.x;
+				wcp->rBy[lane] = vcp->rB.y;
+				wcp->normalImpulse[lane] = vcp->normalImpulse;
+				wcp->tangentImpulse[lane] = vcp->tangentImpulse;
+				wcp->normalMass[lane] = vcp->normalMass;
+				wcp->tangentMass[lane] = vcp->tangentMass;
+				wcp->velocityBias[lane] = vcp->velocityBias;
+			}
+
+			if (vc->pointCount == 2)
+			{
+				batch->k11[lane] = vc->K.ex.x;
+				batch->k12[lane] = vc->K.ex.y;
+				batch->k22[lane] = vc->K.ey.y;
+				batch->normalMass11[lane] = vc->normalMass.ex.x;
+				batch->normalMass21[lane] = vc->normalMass.ex.y;
+				batch->normalMass12[lane] = vc->normalMass.ey.x;
+				batch->normalMass22[lane] = vc->normalMass.ey.y;
+			}
+		}
+
+		for (int32 m = 0; m < bodyCount; ++m)
+		{
+			target->bodies[target->bodyCount++] = bodies[m];
+		}
+
+		if (++target->laneCount == b2_wideLanes)
+		{
+			for (int32 j = slot + 1; j < windowCount; ++j)
+			{
+				window[j - 1] = window[j];
+			}
+			--windowCount;
+		}
+	}
+
+	return batchCount;
+}
+
+void b2ContactSolver::PrepareWideConstraints()
+{
+	m_wideBatchCount = b2AssignWideLanes(m_velocityConstraints, m_count, NULL);
+	if (m_wideBatchCount == 0)
+	{
+		return;
+	}
+
+	m_wideBatches = (b2WideContactBatch*)m_allocator->Allocate(m_wideBatchCount * sizeof(b2WideContactBatch));
+	b2AssignWideLanes(m_velocityConstraints, m_count, m_wideBatches);
+}
+
+// Velocities of one side of the contacts in a batch.
+struct b2WideBody
+{
+	b2FloatW vx, vy, w;
+};
+
+// Applies impulse (px, py) at the contact point, mirroring the scalar solver:
+// vA -= mA * P, wA -= iA * cross(rA, P), vB += mB * P, wB += iB * cross(rB, P).
+inline void b2ApplyWide(b2WideBody& A, b2WideBody& B, b2FloatW mA, b2FloatW iA, b2FloatW mB, b2FloatW iB,
+						b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy, b2FloatW px, b2FloatW py)
+{
+	A.vx = b2MulSubW(A.vx, mA, px);
+	A.vy = b2MulSubW(A.vy, mA, py);
+	A.w = b2MulSubW(A.w, iA, b2SubW(b2MulW(rAx, py), b2MulW(rAy, px)));
+
+	B.vx = b2MulAddW(B.vx, mB, px);
+	B.vy = b2MulAddW(B.vy, mB, py);
+	B.w = b2MulAddW(B.w, iB, b2SubW(b2MulW(rBx, py), b2MulW(rBy, px)));
+}
+
+// Relative velocity at a contact point: vB + cross(wB, rB) - vA - cross(wA, rA).
+inline void b2RelativeVelocityWide(const b2WideBody& A, const b2WideBody& B,
+								   b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy,
+								   b2FloatW& dvx, b2FloatW& dvy)
+{
+	dvx = b2SubW(b2SubW(b2AddW(B.vx, b2MulW(b2SubW(b2SplatW(0.0f), B.w), rBy)), A.vx), b2MulW(b2SubW(b2SplatW(0.0f), A.w), rAy));
+	dvy = b2SubW(b2SubW(b2AddW(B.vy, b2MulW(B.w, rBx)), A.vy), b2MulW(A.w, rAx));
+}
+
+void b2ContactSolver::SolveWideVelocityConstraints()
+{
+	const b2FloatW zero = b2SplatW(0.0f);
+
+	for (int32 i = 0; i < m_wideBatchCount; ++i)
+	{
+		b2WideContactBatch* batch = m_wideBatches + i;
+
+		// Gather body velocities. Unused lanes read zero.
+		float32 vAx[b2_wideLanes], vAy[b2_wideLanes], wA[b2_wideLanes];
+		float32 vBx[b2_wideLanes], vBy[b2_wideLanes], wB[b2_wideLanes];
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			if (batch->constraints[lane] == -1)
+			{
+				vAx[lane] = vAy[lane] = wA[lane] = 0.0f;
+				vBx[lane] = vBy[lane] = wB[lane] = 0.0f;
+				continue;
+			}
+
+			const b2Velocity& velocityA = m_velocities[batch->indexA[lane]];
+			const b2Velocity& velocityB = m_velocities[batch->indexB[lane]];
+			vAx[lane] = velocityA.v.x;
+			vAy[lane] = velocityA.v.y;
+			wA[lane] = velocityA.w;
+			vBx[lane] = velocityB.v.x;
+			vBy[lane] = velocityB.v.y;
+			wB[lane] = velocityB.w;
+		}
+
+		b2WideBody A, B;
+		A.vx = b2LoadW(vAx);
+		A.vy = b2LoadW(vAy);
+		A.w = b2LoadW(wA);
+		B.vx = b2LoadW(vBx);
+		B.vy = b2LoadW(vBy);
+		B.w = b2LoadW(wB);
+
+		b2FloatW mA = b2LoadW(batch->invMassA);
+		b2FloatW iA = b2LoadW(batch->invIA);
+		b2FloatW mB = b2LoadW(batch->invMassB);
+		b2FloatW iB = b2LoadW(batch->invIB);
+		b2FloatW normalX = b2LoadW(batch->normalX);
+		b2FloatW normalY = b2LoadW(batch->normalY);
+
+		// tangent = b2Cross(normal, 1.0f)
+		b2FloatW tangentX = normalY;
+		b2FloatW tangentY = b2SubW(zero, normalX);
+		b2FloatW friction = b2LoadW(batch->friction);
+		b2FloatW tangentSpeed = b2LoadW(batch->tangentSpeed);
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		for (int32 j = 0; j < batch->pointCount; ++j)
+		{
+			b2WideContactPoint* wcp = batch->points + j;
+			b2FloatW rAx = b2LoadW(wcp->rAx), rAy = b2LoadW(wcp->rAy);
+			b2FloatW rBx = b2LoadW(wcp->rBx), rBy = b2LoadW(wcp->rBy);
+
+			b2FloatW dvx, dvy;
+			b2RelativeVelocityWide(A, B, rAx, rAy, rBx, rBy, dvx, dvy);
+
+			b2FloatW vt = b2SubW(b2AddW(b2MulW(dvx, tangentX), b2MulW(dvy, tangentY)), tangentSpeed);
+			b2FloatW lambda = b2MulW(b2LoadW(wcp->tangentMass), b2SubW(zero, vt));
+
+			b2FloatW maxFriction = b2MulW(friction, b2LoadW(wcp->normalImpulse));
+			b2FloatW oldImpulse = b2LoadW(wcp->tangentImpulse);
+			b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxFriction), b2MinW(b2AddW(oldImpulse, lambda), maxFriction));
+			lambda = b2SubW(newImpulse, oldImpulse);
+			b2StoreW(wcp->tangentImpulse, newImpulse);
+
+			b2ApplyWide(A, B, mA, iA, mB, iB, rAx, rAy, rBx, rBy, b2MulW(lambda, tangentX), b2MulW(lambda, tangentY));
+		}
+
+		// Solve normal constraints
+		if (batch->pointCount == 1)
+		{
+			b2WideContactPoint* wcp = batch->points + 0;
+			b2FloatW rAx = b2LoadW(wcp->rAx), rAy = b2LoadW(wcp->rAy);
+			b2FloatW rBx = b2LoadW(wcp->rBx), rBy = b2LoadW(wcp->rBy);
+
+			b2FloatW dvx, dvy;
+			b2RelativeVelocityWide(A, B, rAx, rAy, rBx, rBy, dvx, dvy);
+
+			b2FloatW vn = b2AddW(b2MulW(dvx, normalX), b2MulW(dvy, normalY));
+			b2FloatW lambda = b2MulW(b2SubW(zero, b2LoadW(wcp->normalMass)), b2SubW(vn, b2LoadW(wcp->velocityBias)));
+
+			b2FloatW oldImpulse = b2LoadW(wcp->normalImpulse);
+			b2FloatW newImpulse = b2MaxW(b2AddW(oldImpulse, lambda), zero);
+			lambda = b2SubW(newImpulse, oldImpulse);
+			b2StoreW(wcp->normalImpulse, newImpulse);
+
+			b2ApplyWide(A, B, mA, iA, mB, iB, rAx, rAy, rBx, rBy, b2MulW(lambda, normalX), b2MulW(lambda, normalY));
+		}
+		else
+		{
+			// The block solver of b2ContactSolver::SolveVelocityConstraints. Every lane
+			// may take a different case, so all four are computed and the first valid
+			// one is selected per lane.
+			b2WideContactPoint* cp1 = batch->points + 0;
+			b2WideContactPoint* cp2 = batch->points + 1;
+			b2FloatW r1Ax = b2LoadW(cp1->rAx), r1Ay = b2LoadW(cp1->rAy);
+			b2FloatW r1Bx = b2LoadW(cp1->rBx), r1By = b2LoadW(cp1->rBy);
+			b2FloatW r2Ax = b2LoadW(cp2->rAx), r2Ay = b2LoadW(cp2->rAy);
+			b2FloatW r2Bx = b2LoadW(cp2->rBx), r2By = b2LoadW(cp2->rBy);
+
+			b2FloatW ax = b2LoadW(cp1->normalImpulse);
+			b2FloatW ay = b2LoadW(cp2->normalImpulse);
+
+			b2FloatW dv1x, dv1y, dv2x, dv2y;
+			b2RelativeVelocityWide(A, B, r1Ax, r1Ay, r1Bx, r1By, dv1x, dv1y);
+			b2RelativeVelocityWide(A, B, r2Ax, r2Ay, r2Bx, r2By, dv2x, dv2y);
+
+			b2FloatW vn1 = b2AddW(b2MulW(dv1x, normalX), b2MulW(dv1y, normalY));
+			b2FloatW vn2 = b2AddW(b2MulW(dv2x, normalX), b2MulW(dv2y, normalY));
+
+			// b = vn - velocityBias - K * a
+			b2FloatW k11 = b2LoadW(batch->k11), k12 = b2LoadW(batch->k12), k22 = b2LoadW(batch->k22);
+			b2FloatW bx = b2SubW(b2SubW(vn1, b2LoadW(cp1->velocityBias)), b2AddW(b2MulW(k11, ax), b2MulW(k12, ay)));
+			b2FloatW by = b2SubW(b2SubW(vn2, b2LoadW(cp2->velocityBias)), b2AddW(b2MulW(k12, ax), b2MulW(k22, ay)));
+
+			// Case 1: vn = 0, x = -inv(K) * b
+			b2FloatW x1x = b2SubW(zero, b2AddW(b2MulW(b2LoadW(batch->normalMass11), bx), b2MulW(b2LoadW(batch->normalMass12), by)));
+			b2FloatW x1y = b2SubW(zero, b2AddW(b2MulW(b2LoadW(batch->normalMass21), bx), b2MulW(b2LoadW(batch->normalMass22), by)));
+			b2FloatW valid1 = b2AndW(b2GreaterEqualW(x1x, zero), b2GreaterEqualW(x1y, zero));
+
+			// Case 2: vn1 = 0 and x2 = 0
+			b2FloatW x2x = b2MulW(b2SubW(zero, b2LoadW(cp1->normalMass)), bx);
+			b2FloatW vn2Case2 = b2AddW(b2MulW(k12, x2x), by);
+			b2FloatW valid2 = b2AndW(b2GreaterEqualW(x2x, zero), b2GreaterEqualW(vn2Case2, zero));
+
+			// Case 3: vn2 = 0 and x1 = 0
+			b2FloatW x3y = b2MulW(b2SubW(zero, b2LoadW(cp2->normalMass)), by);
+			b2FloatW vn1Case3 = b2AddW(b2MulW(k12, x3y), bx);
+			b2FloatW valid3 = b2AndW(b2GreaterEqualW(x3y, zero), b2GreaterEqualW(vn1Case3, zero));
+
+			// Case 4: x = 0
+			b2FloatW valid4 = b2AndW(b2GreaterEqualW(bx, zero), b2GreaterEqualW(by, zero));
+
+			// With no valid case the impulse is left unchanged.
+			b2FloatW xx = b2SelectW(valid4, zero, ax);
+			b2FloatW xy = b2SelectW(valid4, zero, ay);
+			xx = b2SelectW(valid3, zero, xx);
+			xy = b2SelectW(valid3, x3y, xy);
+			xx = b2SelectW(valid2, x2x, xx);
+			xy = b2SelectW(valid2, zero, xy);
+			xx = b2SelectW(valid1, x1x, xx);
+			xy = b2SelectW(valid1, x1y, xy);
+
+			// Apply the incremental impulse d = x - a of both points at once.
+			b2FloatW dx = b2SubW(xx, ax);
+			b2FloatW dy = b2SubW(xy, ay);
+			b2FloatW p1x = b2MulW(dx, normalX), p1y = b2MulW(dx, normalY);
+			b2FloatW p2x = b2MulW(dy, normalX), p2y = b2MulW(dy, normalY);
+			b2FloatW px = b2AddW(p1x, p2x), py = b2AddW(p1y, p2y);
+
+			A.vx = b2MulSubW(A.vx, mA, px);
+			A.vy = b2MulSubW(A.vy, mA, py);
+			A.w = b2MulSubW(A.w, iA, b2AddW(b2SubW(b2MulW(r1Ax, p1y), b2MulW(r1Ay, p1x)), b2SubW(b2MulW(r2Ax, p2y), b2MulW(r2Ay, p2x))));
+
+			B.vx = b2MulAddW(B.vx, mB, px);
+			B.vy = b2MulAddW(B.vy, mB, py);
+			B.w = b2MulAddW(B.w, iB, b2AddW(b2SubW(b2MulW(r1Bx, p1y), b2MulW(r1By, p1x)), b2SubW(b2MulW(r2Bx, p2y), b2MulW(r2By, p2x))));
+
+			b2StoreW(cp1->normalImpulse, xx);
+			b2StoreW(cp2->normalImpulse, xy);
+		}
+
+		// Scatter. No movable body appears twice in a batch, and the others keep their velocity.
+		b2StoreW(vAx, A.vx);
+		b2StoreW(vAy, A.vy);
+		b2StoreW(wA, A.w);
+		b2StoreW(vBx, B.vx);
+		b2StoreW(vBy, B.vy);
+		b2StoreW(wB, B.w);
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			if (batch->constraints[lane] == -1)
+			{
+				continue;
+			}
+
+			if (b2IsMovable(batch->invMassA[lane], batch->invIA[lane]))
+			{
+				b2Velocity& velocityA = m_velocities[batch->indexA[lane]];
+				velocityA.v.Set(vAx[lane], vAy[lane]);
+				velocityA.w = wA[lane];
+			}
+
+			if (b2IsMovable(batch->invMassB[lane], batch->invIB[lane]))
+			{
+				b2Velocity& velocityB = m_velocities[batch->indexB[lane]];
+				velocityB.v.Set(vBx[lane], vBy[lane]);
+				velocityB.w = wB[lane];
+			}
+		}
+	}
+}
+
+void b2ContactSolver::StoreWideImpulses()
+{
+	for (int32 i = 0; i < m_wideBatchCount; ++i)
+	{
+		const b2WideContactBatch* batch = m_wideBatches + i;
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			if (batch->constraints[lane] == -1)
+			{
+				continue;
+			}
+
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + batch->constraints[lane];
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = batch->points[j].normalImpulse[lane];
+				vc->points[j].tangentImpulse = batch->points[j].tangentImpulse[lane];
+			}
+		}
+	}
+}
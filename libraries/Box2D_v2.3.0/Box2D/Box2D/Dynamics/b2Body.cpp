@@ -171,7 +171,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return NULL;
 	}
 
-	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
+	b2BlockAllocator* allocator = m_world->m_blockAllocator;
 
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
 	b2Fixture* fixture = new (memory) b2Fixture;
@@ -258,7 +258,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		}
 	}
 
-	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
+	b2BlockAllocator* allocator = m_world->m_blockAllocator;
 
 	if (m_flags & e_activeFlag)
 	{
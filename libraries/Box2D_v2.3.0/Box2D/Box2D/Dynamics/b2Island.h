@@ -74,6 +74,10 @@ public:
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	/// Island indices of each contact's bodies, two per contact, for islands that are solved
+	/// after other islands have reassigned the island index of a shared static body.
+	const int32* m_contactIndices;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
@@ -43,6 +43,10 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	float32 linearSleepTolerance;
+	float32 angularSleepTolerance;
+	float32 timeToSleep;
+	bool wideContacts;
 };
 
 /// This is an internal structure.
@@ -34,8 +34,10 @@
 #include <Box2D/Common/b2Timer.h>
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2BlockAllocator* allocator)
 {
+	m_blockAllocator = allocator ? allocator : &m_defaultBlockAllocator;
+
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
 
@@ -51,14 +53,22 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_stepComplete = true;
 
+	m_taskExecutor = NULL;
+	m_workerAllocators = NULL;
+	m_workerCount = 0;
+
 	m_allowSleep = true;
+	m_linearSleepTolerance = b2_linearSleepTolerance;
+	m_angularSleepTolerance = b2_angularSleepTolerance;
+	m_timeToSleep = b2_timeToSleep;
+	m_wideContactSolving = false;
 	m_gravity = gravity;
 
 	m_flags = e_clearForces;
 
 	m_inv_dt0 = 0.0f;
 
-	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_allocator = m_blockAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
@@ -76,12 +86,14 @@ b2World::~b2World()
 		{
 			b2Fixture* fNext = f->m_next;
 			f->m_proxyCount = 0;
-			f->Destroy(&m_blockAllocator);
+			f->Destroy(m_blockAllocator);
 			f = fNext;
 		}
 
 		b = bNext;
 	}
+
+	SetTaskExecutor(NULL);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -112,7 +124,7 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 		return NULL;
 	}
 
-	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
+	void* mem = m_blockAllocator->Allocate(sizeof(b2Body));
 	b2Body* b = new (mem) b2Body(def, this);
 
 	// Add to world doubly linked list.
@@ -129,6 +141,79 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 }
 
 void b2World::DestroyBody(b2Body* b)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	DetachBody(b);
+	DestroyDetachedBody(b);
+}
+
+b2Body* b2World::CreateDetachedBody(const b2BodyDef* def, const b2FixtureDef* fixtureDefs, int32 fixtureCount)
+{
+	void* mem = m_blockAllocator->Allocate(sizeof(b2Body));
+	b2Body* b = new (mem) b2Body(def, this);
+	b->m_prev = NULL;
+	b->m_next = NULL;
+
+	bool hasMass = false;
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		void* memory = m_blockAllocator->Allocate(sizeof(b2Fixture));
+		b2Fixture* fixture = new (memory) b2Fixture;
+		fixture->Create(m_blockAllocator, b, fixtureDefs + i);
+		fixture->m_next = b->m_fixtureList;
+		b->m_fixtureList = fixture;
+		++b->m_fixtureCount;
+		hasMass = hasMass || fixture->m_density > 0.0f;
+	}
+
+	if (hasMass)
+	{
+		b->ResetMassData();
+	}
+
+	return b;
+}
+
+void b2World::AttachBody(b2Body* b)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Add to world doubly linked list.
+	b->m_prev = NULL;
+	b->m_next = m_bodyList;
+	if (m_bodyList)
+	{
+		m_bodyList->m_prev = b;
+	}
+	m_bodyList = b;
+	++m_bodyCount;
+
+	if (b->m_flags & b2Body::e_activeFlag)
+	{
+		b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->CreateProxies(broadPhase, b->m_xf);
+		}
+	}
+
+	if (b->m_fixtureList)
+	{
+		// New contacts are created at the beginning of the next time step.
+		m_flags |= e_newFixture;
+	}
+}
+
+void b2World::DetachBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
 	b2Assert(IsLocked() == false);
@@ -165,28 +250,16 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_contactList = NULL;
 
-	// Delete the attached fixtures. This destroys broad-phase proxies.
-	b2Fixture* f = b->m_fixtureList;
-	while (f)
+	// Destroy the broad-phase proxies of the attached fixtures.
+	for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
 	{
-		b2Fixture* f0 = f;
-		f = f->m_next;
-
 		if (m_destructionListener)
 		{
-			m_destructionListener->SayGoodbye(f0);
+			m_destructionListener->SayGoodbye(f);
 		}
 
-		f0->DestroyProxies(&m_contactManager.m_broadPhase);
-		f0->Destroy(&m_blockAllocator);
-		f0->~b2Fixture();
-		m_blockAllocator.Free(f0, sizeof(b2Fixture));
-
-		b->m_fixtureList = f;
-		b->m_fixtureCount -= 1;
+		f->DestroyProxies(&m_contactManager.m_broadPhase);
 	}
-	b->m_fixtureList = NULL;
-	b->m_fixtureCount = 0;
 
 	// Remove world body list.
 	if (b->m_prev)
@@ -204,9 +277,29 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	b->m_prev = NULL;
+	b->m_next = NULL;
 	--m_bodyCount;
+}
+
+void b2World::DestroyDetachedBody(b2Body* b)
+{
+	// Delete the attached fixtures.
+	b2Fixture* f = b->m_fixtureList;
+	while (f)
+	{
+		b2Fixture* f0 = f;
+		f = f->m_next;
+
+		f0->Destroy(m_blockAllocator);
+		f0->~b2Fixture();
+		m_blockAllocator->Free(f0, sizeof(b2Fixture));
+	}
+	b->m_fixtureList = NULL;
+	b->m_fixtureCount = 0;
+
 	b->~b2Body();
-	m_blockAllocator.Free(b, sizeof(b2Body));
+	m_blockAllocator->Free(b, sizeof(b2Body));
 }
 
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
@@ -217,7 +310,7 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 		return NULL;
 	}
 
-	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+	b2Joint* j = b2Joint::Create(def, m_blockAllocator);
 
 	// Connect to the world list.
 	j->m_prev = NULL;
@@ -341,7 +434,7 @@ void b2World::DestroyJoint(b2Joint* j)
 	j->m_edgeB.prev = NULL;
 	j->m_edgeB.next = NULL;
 
-	b2Joint::Destroy(j, &m_blockAllocator);
+	b2Joint::Destroy(j, m_blockAllocator);
 
 	b2Assert(m_jointCount > 0);
 	--m_jointCount;
@@ -365,6 +458,37 @@ void b2World::DestroyJoint(b2Joint* j)
 }
 
 //
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	b2Assert(IsLocked() == false);
+
+	for (int32 i = 0; i < m_workerCount; ++i)
+	{
+		m_workerAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_workerAllocators);
+	m_workerAllocators = NULL;
+	m_workerCount = 0;
+
+	m_taskExecutor = executor;
+	if (executor)
+	{
+		m_workerCount = executor->GetWorkerCount();
+		m_workerAllocators = (b2StackAllocator*)b2Alloc(m_workerCount * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < m_workerCount; ++i)
+		{
+			new (m_workerAllocators + i) b2StackAllocator();
+		}
+	}
+}
+
+void b2World::SetSleepTolerances(float32 linearTolerance, float32 angularTolerance, float32 timeToSleep)
+{
+	m_linearSleepTolerance = linearTolerance;
+	m_angularSleepTolerance = angularTolerance;
+	m_timeToSleep = timeToSleep;
+}
+
 void b2World::SetAllowSleeping(bool flag)
 {
 	if (flag == m_allowSleep)
@@ -389,13 +513,6 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
-
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
@@ -410,6 +527,50 @@ void b2World::Solve(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
+	if (m_taskExecutor != NULL && m_workerCount > 1)
+	{
+		SolveIslandsInParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
+
+	{
+		b2Timer timer;
+		// Synchronize fixtures, check for out of range bodies.
+		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		{
+			// If a body was not in an island then it did not move.
+			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				continue;
+			}
+
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Update fixtures (for broad-phase).
+			b->SynchronizeFixtures();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+void b2World::SolveIslands(const b2TimeStep& step)
+{
+	// Size the island for the worst case.
+	b2Island island(m_bodyCount,
+					m_contactManager.m_contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					m_contactManager.m_contactListener);
+
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
@@ -546,31 +707,306 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+}
+
+// The bodies, contacts and joints of one island, as ranges of the arrays built by
+// SolveIslandsInParallel.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+};
+
+// Captures post solve impulses so they can be reported in island order once every island is
+// solved.
+class b2ImpulseRecorder : public b2ContactListener
+{
+public:
+	b2ImpulseRecorder(b2ContactImpulse* impulses) : m_impulses(impulses), m_count(0) {}
 
+	void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		B2_NOT_USED(contact);
+		m_impulses[m_count++] = *impulse;
+	}
+
+	b2ContactImpulse* m_impulses;
+	int32 m_count;
+};
+
+class b2IslandSolveTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 workerIndex)
+	{
+		for (int32 i = begin; i < end; ++i)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			// Joints read island indices straight from their bodies, which a shared static
+			// body cannot provide for two islands at once; those islands are solved serially.
+			if (islands[i].jointCount == 0)
 			{
-				continue;
+				Solve(islands[i], allocators + workerIndex, profiles + workerIndex);
 			}
+		}
+	}
+
+	void Solve(const b2IslandRange& range, b2StackAllocator* allocator, b2Profile* profile)
+	{
+		b2ImpulseRecorder recorder(impulses + range.contactStart);
+		b2Island island(range.bodyCount, range.contactCount, range.jointCount, allocator, &recorder);
+		for (int32 i = 0; i < range.bodyCount; ++i)
+		{
+			island.m_bodies[i] = bodies[range.bodyStart + i];
+		}
+		for (int32 i = 0; i < range.contactCount; ++i)
+		{
+			island.m_contacts[i] = contacts[range.contactStart + i];
+		}
+		for (int32 i = 0; i < range.jointCount; ++i)
+		{
+			island.m_joints[i] = joints[range.jointStart + i];
+		}
+		island.m_bodyCount = range.bodyCount;
+		island.m_contactCount = range.contactCount;
+		island.m_jointCount = range.jointCount;
+		island.m_contactIndices = indices + 2 * range.contactStart;
+
+		b2Profile islandProfile;
+		island.Solve(&islandProfile, step, gravity, allowSleep);
+		profile->solveInit += islandProfile.solveInit;
+		profile->solveVelocity += islandProfile.solveVelocity;
+		profile->solvePosition += islandProfile.solvePosition;
+	}
+
+	b2TimeStep step;
+	b2Vec2 gravity;
+	bool allowSleep;
+	const b2IslandRange* islands;
+	b2Body** bodies;
+	b2Contact** contacts;
+	b2Joint** joints;
+	const int32* indices;
+	b2ContactImpulse* impulses;
+	b2StackAllocator* allocators;
+	b2Profile* profiles;
+};
+
+// Builds every island up front, in the same order as SolveIslands, then solves them on the task
+// executor. Islands only share static bodies, which solving leaves untouched, so the result does
+// not depend on how islands are spread across workers. Post solve callbacks are reported
+// afterwards on the calling thread, in island order.
+void b2World::SolveIslandsInParallel(const b2TimeStep& step)
+{
+	// A static body can join one island per contact or joint that touches it.
+	int32 contactCapacity = m_contactManager.m_contactCount;
+	int32 bodyCapacity = m_bodyCount + contactCapacity + m_jointCount;
+
+	b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(m_workerCount * sizeof(b2Profile));
+	b2IslandRange* islands = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+	int32* indices = (int32*)m_stackAllocator.Allocate(2 * contactCapacity * sizeof(int32));
+	b2ContactImpulse* impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCapacity * sizeof(b2ContactImpulse));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+
+	int32 islandCount = 0;
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsActive() == false)
+		{
+			continue;
+		}
+
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2IslandRange* island = islands + islandCount++;
+		island->bodyStart = bodyCount;
+		island->contactStart = contactCount;
+		island->jointStart = jointCount;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsActive() == true);
+			b2Assert(bodyCount < bodyCapacity);
+			b->m_islandIndex = bodyCount - island->bodyStart;
+			bodies[bodyCount++] = b;
+
+			b->SetAwake(true);
 
 			if (b->GetType() == b2_staticBody)
 			{
 				continue;
 			}
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
+				{
+					continue;
+				}
+
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
+
+				contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				b2Body* other = je->other;
+
+				if (other->IsActive() == false)
+				{
+					continue;
+				}
+
+				joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		island->bodyCount = bodyCount - island->bodyStart;
+		island->contactCount = contactCount - island->contactStart;
+		island->jointCount = jointCount - island->jointStart;
+
+		// Record island indices now, while every static body still has its index for this island.
+		for (int32 i = island->contactStart; i < contactCount; ++i)
+		{
+			indices[2 * i] = contacts[i]->m_fixtureA->m_body->m_islandIndex;
+			indices[2 * i + 1] = contacts[i]->m_fixtureB->m_body->m_islandIndex;
+		}
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = island->bodyStart; i < bodyCount; ++i)
+		{
+			if (bodies[i]->GetType() == b2_staticBody)
+			{
+				bodies[i]->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
+	}
+	m_stackAllocator.Free(stack);
+
+	for (int32 i = 0; i < m_workerCount; ++i)
+	{
+		memset(profiles + i, 0, sizeof(b2Profile));
+	}
+
+	b2IslandSolveTask task;
+	task.step = step;
+	task.gravity = m_gravity;
+	task.allowSleep = m_allowSleep;
+	task.islands = islands;
+	task.bodies = bodies;
+	task.contacts = contacts;
+	task.joints = joints;
+	task.indices = indices;
+	task.impulses = impulses;
+	task.allocators = m_workerAllocators;
+	task.profiles = profiles;
+
+	if (islandCount > 1)
+	{
+		m_taskExecutor->Run(&task, islandCount);
+	}
+	else
+	{
+		task.Execute(0, islandCount, 0);
+	}
+
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		if (islands[i].jointCount > 0)
+		{
+			for (int32 j = 0; j < islands[i].bodyCount; ++j)
+			{
+				bodies[islands[i].bodyStart + j]->m_islandIndex = j;
+			}
+			task.Solve(islands[i], &m_stackAllocator, profiles);
+		}
+	}
+
+	for (int32 i = 0; i < m_workerCount; ++i)
+	{
+		m_profile.solveInit += profiles[i].solveInit;
+		m_profile.solveVelocity += profiles[i].solveVelocity;
+		m_profile.solvePosition += profiles[i].solvePosition;
+	}
+
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	if (listener)
+	{
+		for (int32 i = 0; i < contactCount; ++i)
+		{
+			listener->PostSolve(contacts[i], impulses + i);
+		}
 	}
+
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(impulses);
+	m_stackAllocator.Free(indices);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(profiles);
 }
 
 // Find TOI contacts and solve them.
@@ -860,6 +1296,10 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.linearSleepTolerance = step.linearSleepTolerance;
+		subStep.angularSleepTolerance = step.angularSleepTolerance;
+		subStep.timeToSleep = step.timeToSleep;
+		subStep.wideContacts = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -923,6 +1363,10 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.linearSleepTolerance = m_linearSleepTolerance;
+	step.angularSleepTolerance = m_angularSleepTolerance;
+	step.timeToSleep = m_timeToSleep;
+	step.wideContacts = m_wideContactSolving;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -1279,6 +1723,17 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
 }
 
+void b2World::RebuildBroadPhase()
+{
+	b2Assert((m_flags & e_locked) == 0);
+	if ((m_flags & e_locked) == e_locked)
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.RebuildTree(m_taskExecutor);
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
@@ -22,6 +22,7 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Task.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
@@ -29,6 +30,7 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
@@ -43,7 +45,9 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator the allocator for bodies, fixtures, contacts and joints, or NULL
+	/// for the world's own. It is owned by you and must outlive the world.
+	b2World(const b2Vec2& gravity, b2BlockAllocator* allocator = NULL);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -77,6 +81,24 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyBody(b2Body* body);
 
+	/// Create a rigid body and its fixtures without adding them to the world. This reads
+	/// nothing the world changes while stepping, so when the world's block allocator is
+	/// thread safe it may be called on another thread, even during a time step.
+	b2Body* CreateDetachedBody(const b2BodyDef* def, const b2FixtureDef* fixtureDefs, int32 fixtureCount);
+
+	/// Add a body made by CreateDetachedBody to the world and the broad-phase.
+	/// @warning This function is locked during callbacks.
+	void AttachBody(b2Body* body);
+
+	/// Remove a body from the world without freeing it. Its joints, contacts and broad-phase
+	/// proxies are destroyed as in DestroyBody. Free it with DestroyDetachedBody.
+	/// @warning This function is locked during callbacks.
+	void DetachBody(b2Body* body);
+
+	/// Free a body that is not in the world, along with its fixtures. Like
+	/// CreateDetachedBody, this may be called on another thread.
+	void DestroyDetachedBody(b2Body* body);
+
 	/// Create a joint to constrain bodies together. No reference to the definition
 	/// is retained. This may cause the connected bodies to cease colliding.
 	/// @warning This function is locked during callbacks.
@@ -141,10 +163,25 @@ public:
 	b2Contact* GetContactList();
 	const b2Contact* GetContactList() const;
 
+	/// Solve islands in parallel on the given executor, or serially when it is NULL. The world
+	/// does not own the executor, and this must not be called during a time step.
+	/// Results do not depend on the number of workers, and post solve callbacks are still
+	/// reported in island order, after every island is solved.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
 	/// Enable/disable sleep.
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
 
+	/// Set how slowly a body must move, and for how long, before it may sleep.
+	/// Defaults to b2_linearSleepTolerance, b2_angularSleepTolerance and b2_timeToSleep.
+	void SetSleepTolerances(float32 linearTolerance, float32 angularTolerance, float32 timeToSleep);
+
+	/// Enable/disable solving contacts four at a time with SIMD. The order contacts are
+	/// solved in changes, so results differ slightly from the scalar solver. Off by default.
+	void SetWideContactSolving(bool flag) { m_wideContactSolving = flag; }
+	bool GetWideContactSolving() const { return m_wideContactSolving; }
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
@@ -199,6 +236,11 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Rebuild the broad-phase tree from scratch. Incremental insertion gives a poor tree
+	/// when many fixtures are created at once, so call this after loading a level.
+	/// Uses the task executor if one is set.
+	void RebuildBroadPhase();
+
 	/// Get the contact manager for testing.
 	const b2ContactManager& GetContactManager() const;
 
@@ -225,14 +267,21 @@ private:
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsInParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
-	b2BlockAllocator m_blockAllocator;
+	b2BlockAllocator m_defaultBlockAllocator;
+	b2BlockAllocator* m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	b2TaskExecutor* m_taskExecutor;
+	b2StackAllocator* m_workerAllocators;
+	int32 m_workerCount;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
@@ -245,6 +294,10 @@ private:
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
+	float32 m_linearSleepTolerance;
+	float32 m_angularSleepTolerance;
+	float32 m_timeToSleep;
+	bool m_wideContactSolving;
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
@@ -27,8 +27,12 @@ int lws_extension_callback_deflate_frame(
 	 * for deflate-frame, both client and server sides act the same
 	 */
 
-	case LWS_EXT_CALLBACK_CLIENT_CONSTRUCT:
 	case LWS_EXT_CALLBACK_CONSTRUCT:
+		/* another compressing extension may have RSV1 already */
+		if (wsi->count_active_extensions)
+			return 1;
+		/* fallthru */
+	case LWS_EXT_CALLBACK_CLIENT_CONSTRUCT:
 		conn->zs_in.zalloc = conn->zs_out.zalloc = Z_NULL;
 		conn->zs_in.zfree = conn->zs_out.zfree = Z_NULL;
 		conn->zs_in.opaque = conn->zs_out.opaque = Z_NULL;
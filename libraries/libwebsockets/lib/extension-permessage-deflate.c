@@ -0,0 +1,409 @@
+#include "private-libwebsockets.h"
+#include "extension-permessage-deflate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * permessage-deflate, RFC 7692
+ *
+ * Each message is deflated and flushed with Z_SYNC_FLUSH, less the four
+ * bytes 00 00 ff ff the flush ends with, and its first frame carries RSV1.
+ * Unless there is no context takeover, the window carries over from one
+ * message to the next, so what repeats across messages costs a back
+ * reference.  Sent messages must go in one frame.
+ */
+
+static unsigned long long
+lws_pm_deflate_usecs(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (unsigned long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ * go through the parameters the client offered, declining the offer if
+ * we cannot honour them, and say what we accept it with
+ */
+
+static int
+lws_pm_deflate_negotiate(struct lws_ext_pm_deflate_conn *conn,
+			 struct lws_ext_negotiation *negotiation,
+			 int *window_bits)
+{
+	const char *c = negotiation->offer;
+	char param[64];
+	char *value;
+	int offered_bits = 0;
+	int n;
+
+	while (*c) {
+		n = 0;
+		while (*c && *c != ';') {
+			if (*c != ' ' && *c != '\t' && *c != '"' &&
+					      n < (int)sizeof(param) - 1)
+				param[n++] = *c;
+			c++;
+		}
+		param[n] = '\0';
+		if (*c)
+			c++;
+		if (!n)
+			continue;
+
+		value = strchr(param, '=');
+		if (value)
+			*value++ = '\0';
+
+		if (!strcmp(param, "server_no_context_takeover"))
+			conn->no_context_takeover = 1;
+		else if (!strcmp(param, "server_max_window_bits") && value) {
+			offered_bits = atoi(value);
+			/* zlib will not deflate with the smallest window, 8 */
+			if (offered_bits < 9 || offered_bits > 15)
+				return 1;
+		} else if (strcmp(param, "client_no_context_takeover") &&
+			   strcmp(param, "client_max_window_bits")) {
+			/* those two are the client's business: we inflate
+			 * with the biggest window and keep it either way */
+			lwsl_ext("permessage-deflate: unknown %s\n", param);
+			return 1;
+		}
+	}
+
+	if (offered_bits && offered_bits < *window_bits)
+		*window_bits = offered_bits;
+
+	n = 0;
+	if (conn->no_context_takeover)
+		n += sprintf(negotiation->reply, "server_no_context_takeover");
+	if (offered_bits)
+		sprintf(negotiation->reply + n, "%sserver_max_window_bits=%d",
+					       n ? "; " : "", *window_bits);
+
+	return 0;
+}
+
+int lws_extension_callback_pm_deflate(
+		struct libwebsocket_context *context,
+		struct libwebsocket_extension *ext,
+		struct libwebsocket *wsi,
+		enum libwebsocket_extension_callback_reasons reason,
+		void *user, void *in, size_t len)
+{
+	struct lws_ext_pm_deflate_conn *conn =
+				       (struct lws_ext_pm_deflate_conn *)user;
+	struct lws_ext_pm_deflate_options *options;
+	struct lws_tokens *eff_buf = (struct lws_tokens *)in;
+	size_t current_payload, remaining_payload, total_payload;
+	size_t len_so_far;
+	unsigned long long start;
+	int level = PM_DEFLATE_COMPRESSION_LEVEL;
+	int window_bits = PM_DEFLATE_WINDOW_BITS;
+	int mem_level = PM_DEFLATE_MEMLEVEL;
+	int n;
+
+	switch (reason) {
+
+	case LWS_EXT_CALLBACK_CONSTRUCT:
+		/*
+		 * every compressing extension sets RSV1, so only the first
+		 * of them the client offered can be active
+		 */
+		if (wsi->count_active_extensions)
+			return 1;
+
+		options = (struct lws_ext_pm_deflate_options *)
+						ext->per_context_private_data;
+		if (options) {
+			conn->options = &options[wsi->protocol->protocol_index];
+			level = conn->options->level;
+			if (conn->options->window_bits)
+				window_bits = conn->options->window_bits;
+			if (conn->options->mem_level)
+				mem_level = conn->options->mem_level;
+			conn->no_context_takeover =
+					   conn->options->no_context_takeover;
+		}
+		if (in && lws_pm_deflate_negotiate(conn,
+			       (struct lws_ext_negotiation *)in, &window_bits))
+			return 1;
+
+		conn->zs_in.zalloc = conn->zs_out.zalloc = Z_NULL;
+		conn->zs_in.zfree = conn->zs_out.zfree = Z_NULL;
+		conn->zs_in.opaque = conn->zs_out.opaque = Z_NULL;
+		n = inflateInit2(&conn->zs_in, -PM_DEFLATE_WINDOW_BITS);
+		if (n != Z_OK) {
+			lwsl_ext("inflateInit2 returned %d\n", n);
+			return 1;
+		}
+		n = deflateInit2(&conn->zs_out, level, Z_DEFLATED,
+				 -window_bits, mem_level, Z_DEFAULT_STRATEGY);
+		if (n != Z_OK) {
+			lwsl_ext("deflateInit2 returned %d\n", n);
+			(void)inflateEnd(&conn->zs_in);
+			return 1;
+		}
+		conn->buf_in_length = LWS_MAX_SOCKET_IO_BUF;
+		conn->buf_out_length = LWS_MAX_SOCKET_IO_BUF;
+		conn->buf_in = (unsigned char *)
+				malloc(LWS_SEND_BUFFER_PRE_PADDING +
+					       conn->buf_in_length +
+					       LWS_SEND_BUFFER_POST_PADDING);
+		if (!conn->buf_in)
+			goto bail;
+		conn->buf_out = (unsigned char *)
+				malloc(LWS_SEND_BUFFER_PRE_PADDING +
+						conn->buf_out_length +
+						LWS_SEND_BUFFER_POST_PADDING);
+		if (!conn->buf_out)
+			goto bail;
+		lwsl_ext("permessage-deflate level %d window %d%s\n", level,
+			 window_bits, conn->no_context_takeover ?
+					       " no context takeover" : "");
+		break;
+bail:
+		lwsl_err("Out of mem\n");
+		free(conn->buf_in);
+		(void)inflateEnd(&conn->zs_in);
+		(void)deflateEnd(&conn->zs_out);
+		return 1;
+
+	case LWS_EXT_CALLBACK_DESTROY:
+		free(conn->buf_pre);
+		free(conn->buf_in);
+		free(conn->buf_out);
+		(void)inflateEnd(&conn->zs_in);
+		(void)deflateEnd(&conn->zs_out);
+		break;
+
+	case LWS_EXT_CALLBACK_PAYLOAD_RX:
+		/* only the first frame of a message says if it is deflated */
+		if (wsi->u.ws.opcode != LWS_WS_OPCODE_07__CONTINUATION)
+			conn->compressed_in = !!(wsi->u.ws.rsv & 0x40);
+		if (!conn->compressed_in)
+			return 0;
+
+		/*
+		 * gather the whole frame, then inflate it
+		 */
+		current_payload = eff_buf->token_len;
+
+		remaining_payload = wsi->u.ws.rx_packet_length;
+		if (remaining_payload) {
+			total_payload = conn->buf_pre_used +
+					current_payload +
+					remaining_payload;
+
+			if (conn->buf_pre_length < total_payload) {
+				conn->buf_pre = (unsigned char *)realloc(
+					   conn->buf_pre, total_payload + 4);
+				if (!conn->buf_pre) {
+					lwsl_err("Out of memory\n");
+					return -1;
+				}
+				conn->buf_pre_length = total_payload;
+			}
+
+			memcpy(conn->buf_pre + conn->buf_pre_used,
+					      eff_buf->token, current_payload);
+			conn->buf_pre_used += current_payload;
+
+			eff_buf->token = NULL;
+			eff_buf->token_len = 0;
+
+			return 0;
+		}
+		if (conn->buf_pre_used) {
+			total_payload = conn->buf_pre_used +
+					current_payload;
+
+			memcpy(conn->buf_pre + conn->buf_pre_used,
+					      eff_buf->token, current_payload);
+			conn->buf_pre_used = 0;
+
+			conn->zs_in.next_in = conn->buf_pre;
+		} else {
+			total_payload = current_payload;
+
+			conn->zs_in.next_in = (unsigned char *)eff_buf->token;
+		}
+
+		/* the sender left the flush marker off the last frame */
+		conn->zs_in.avail_in = total_payload;
+		if (wsi->u.ws.final) {
+			conn->zs_in.next_in[total_payload + 0] = 0;
+			conn->zs_in.next_in[total_payload + 1] = 0;
+			conn->zs_in.next_in[total_payload + 2] = 0xff;
+			conn->zs_in.next_in[total_payload + 3] = 0xff;
+			conn->zs_in.avail_in += 4;
+		}
+
+		conn->zs_in.next_out =
+				conn->buf_in + LWS_SEND_BUFFER_PRE_PADDING;
+		conn->zs_in.avail_out = conn->buf_in_length;
+
+		start = lws_pm_deflate_usecs();
+		while (1) {
+			n = inflate(&conn->zs_in, Z_SYNC_FLUSH);
+			switch (n) {
+			case Z_NEED_DICT:
+			case Z_STREAM_ERROR:
+			case Z_DATA_ERROR:
+			case Z_MEM_ERROR:
+				/*
+				 * the destroy callback that follows closing
+				 * the connection tidies up
+				 */
+				lwsl_err("zlib error inflate %d: %s\n",
+							   n, conn->zs_in.msg);
+				return -1;
+			}
+
+			if (conn->zs_in.avail_out)
+				break;
+
+			len_so_far = conn->zs_in.next_out -
+				(conn->buf_in + LWS_SEND_BUFFER_PRE_PADDING);
+
+			conn->buf_in_length *= 2;
+			if (conn->buf_in_length > LWS_MAX_ZLIB_CONN_BUFFER) {
+				lwsl_ext("zlib in buffer hit limit %u\n",
+						LWS_MAX_ZLIB_CONN_BUFFER);
+				return -1;
+			}
+			conn->buf_in = (unsigned char *)realloc(conn->buf_in,
+					LWS_SEND_BUFFER_PRE_PADDING +
+						conn->buf_in_length +
+						 LWS_SEND_BUFFER_POST_PADDING);
+			if (!conn->buf_in) {
+				lwsl_err("Out of memory\n");
+				return -1;
+			}
+			conn->zs_in.next_out = conn->buf_in +
+				LWS_SEND_BUFFER_PRE_PADDING + len_so_far;
+			conn->zs_in.avail_out =
+					conn->buf_in_length - len_so_far;
+		}
+
+		/* rewrite the buffer pointers and length */
+		eff_buf->token =
+			(char *)(conn->buf_in + LWS_SEND_BUFFER_PRE_PADDING);
+		eff_buf->token_len = (int)(conn->zs_in.next_out -
+				 (conn->buf_in + LWS_SEND_BUFFER_PRE_PADDING));
+
+		if (conn->options) {
+			conn->options->stats.rx_usecs +=
+					     lws_pm_deflate_usecs() - start;
+			conn->options->stats.rx_bytes_in += total_payload;
+			conn->options->stats.rx_bytes_out +=
+							  eff_buf->token_len;
+			if (wsi->u.ws.final)
+				conn->options->stats.rx_messages++;
+		}
+
+		return 0;
+
+	case LWS_EXT_CALLBACK_PAYLOAD_TX:
+		current_payload = eff_buf->token_len;
+
+		start = lws_pm_deflate_usecs();
+
+		/* room for all of it, so it takes one pass */
+		total_payload = deflateBound(&conn->zs_out,
+						    current_payload) + 16;
+		if (conn->buf_out_length < total_payload) {
+			conn->buf_out = (unsigned char *)realloc(conn->buf_out,
+					LWS_SEND_BUFFER_PRE_PADDING +
+						total_payload +
+						LWS_SEND_BUFFER_POST_PADDING);
+			if (!conn->buf_out) {
+				lwsl_err("Out of memory\n");
+				return -1;
+			}
+			conn->buf_out_length = total_payload;
+		}
+
+		conn->zs_out.next_in = (unsigned char *)eff_buf->token;
+		conn->zs_out.avail_in = current_payload;
+
+		conn->zs_out.next_out =
+				conn->buf_out + LWS_SEND_BUFFER_PRE_PADDING;
+		conn->zs_out.avail_out = conn->buf_out_length;
+
+		while (1) {
+			n = deflate(&conn->zs_out, Z_SYNC_FLUSH);
+			if (n == Z_STREAM_ERROR) {
+				lwsl_ext("zlib error deflate\n");
+				return -1;
+			}
+
+			if (conn->zs_out.avail_out)
+				break;
+
+			len_so_far = (conn->zs_out.next_out -
+					(conn->buf_out +
+						 LWS_SEND_BUFFER_PRE_PADDING));
+			conn->buf_out_length *= 2;
+			conn->buf_out = (unsigned char *)realloc(
+					conn->buf_out,
+					LWS_SEND_BUFFER_PRE_PADDING +
+						  conn->buf_out_length +
+						  LWS_SEND_BUFFER_POST_PADDING);
+			if (!conn->buf_out) {
+				lwsl_err("Out of memory\n");
+				return -1;
+			}
+			conn->zs_out.next_out = (conn->buf_out +
+				     LWS_SEND_BUFFER_PRE_PADDING + len_so_far);
+			conn->zs_out.avail_out =
+					   (conn->buf_out_length - len_so_far);
+		}
+
+		if (conn->no_context_takeover)
+			deflateReset(&conn->zs_out);
+
+		conn->compressed_out = 1;
+
+		/* rewrite the buffer pointers and length, less the marker */
+		eff_buf->token = (char *)(conn->buf_out +
+						LWS_SEND_BUFFER_PRE_PADDING);
+		eff_buf->token_len = (int)(conn->zs_out.next_out -
+			    (conn->buf_out + LWS_SEND_BUFFER_PRE_PADDING)) - 4;
+
+		if (conn->options) {
+			conn->options->stats.tx_usecs +=
+					     lws_pm_deflate_usecs() - start;
+			conn->options->stats.tx_messages++;
+			conn->options->stats.tx_bytes_in += current_payload;
+			conn->options->stats.tx_bytes_out +=
+							  eff_buf->token_len;
+		}
+
+		return 0;
+
+	case LWS_EXT_CALLBACK_PACKET_TX_PRESEND:
+		if (!conn->compressed_out)
+			break;
+		conn->compressed_out = 0;
+		/* a fragment would need the marker kept, and RSV1 once */
+		if (!(*((unsigned char *)eff_buf->token) & 0x80)) {
+			lwsl_err("permessage-deflate cannot send fragments\n");
+			return -1;
+		}
+		*((unsigned char *)eff_buf->token) |= 0x40;
+		break;
+
+	case LWS_EXT_CALLBACK_CHECK_OK_TO_PROPOSE_EXTENSION:
+		/* only the server side is written */
+		return 1;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
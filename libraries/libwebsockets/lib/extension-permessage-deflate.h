@@ -0,0 +1,29 @@
+
+#include <zlib.h>
+
+#define PM_DEFLATE_COMPRESSION_LEVEL 1
+#define PM_DEFLATE_WINDOW_BITS 15
+#define PM_DEFLATE_MEMLEVEL 8
+
+struct lws_ext_pm_deflate_conn {
+	z_stream zs_in;
+	z_stream zs_out;
+	struct lws_ext_pm_deflate_options *options;
+	int no_context_takeover;
+	size_t buf_pre_used;
+	size_t buf_pre_length;
+	size_t buf_in_length;
+	size_t buf_out_length;
+	int compressed_in;
+	int compressed_out;
+	unsigned char *buf_pre;
+	unsigned char *buf_in;
+	unsigned char *buf_out;
+};
+
+extern int lws_extension_callback_pm_deflate(
+		struct libwebsocket_context *context,
+		struct libwebsocket_extension *ext,
+		struct libwebsocket *wsi,
+		enum libwebsocket_extension_callback_reasons reason,
+		void *user, void *in, size_t len);
@@ -2,6 +2,7 @@
 
 #include "extension-deflate-frame.h"
 #include "extension-deflate-stream.h"
+#include "extension-permessage-deflate.h"
 
 struct libwebsocket_extension libwebsocket_internal_extensions[] = {
 #ifdef LWS_EXT_DEFLATE_STREAM
@@ -11,6 +12,11 @@ struct libwebsocket_extension libwebsocket_internal_extensions[] = {
 		sizeof(struct lws_ext_deflate_stream_conn)
 	},
 #else
+	{
+		"permessage-deflate",
+		lws_extension_callback_pm_deflate,
+		sizeof(struct lws_ext_pm_deflate_conn)
+	},
 	{
 		"x-webkit-deflate-frame",
 		lws_extension_callback_deflate_frame,
@@ -238,6 +238,11 @@ enum lws_token_indexes {
 	WSI_TOKEN_ACCEPT,
 	WSI_TOKEN_NONCE,
 	WSI_TOKEN_HTTP,
+
+	/* http requests, for caching and compression */
+	WSI_TOKEN_HTTP_ACCEPT_ENCODING,
+	WSI_TOKEN_HTTP_IF_NONE_MATCH,
+
 	WSI_TOKEN_MUXURL,
 
 	/* use token storage to stash these */
@@ -620,7 +625,9 @@ typedef int (callback_function)(struct libwebsocket_context *context,
  *		just before the server will send back the handshake accepting
  *		the connection with this extension active.  This gives the
  *		extension a chance to initialize its connection context found
- *		in @user.
+ *		in @user.  @in points to a struct lws_ext_negotiation holding
+ *		the parameters the client offered, and room for the ones to
+ *		accept them with.  A nonzero return declines the offer.
  *
  *	LWS_EXT_CALLBACK_CLIENT_CONSTRUCT: same as LWS_EXT_CALLBACK_CONSTRUCT
  *		but called when client is instantiating this extension.  Some
@@ -732,6 +739,72 @@ struct libwebsocket_extension {
 	size_t per_session_data_size;
 	void *per_context_private_data;
 };
+
+/**
+ * struct lws_ext_negotiation -	An extension offer being accepted
+ *
+ * @offer:	Parameters the client sent after the extension name, eg,
+ *		"client_max_window_bits; server_no_context_takeover", or ""
+ * @reply:	Parameters the extension accepts the offer with, which the
+ *		server sends back after the name.  Starts empty.
+ */
+
+struct lws_ext_negotiation {
+	const char *offer;
+	char reply[128];
+};
+
+/**
+ * struct lws_ext_pm_deflate_stats -	What permessage-deflate has done
+ *
+ * @tx_messages:	Messages compressed
+ * @tx_bytes_in:	Their bytes before compression
+ * @tx_bytes_out:	Their bytes after compression
+ * @tx_usecs:		Time spent compressing them
+ * @rx_messages:	Compressed messages received
+ * @rx_bytes_in:	Their bytes as received
+ * @rx_bytes_out:	Their bytes inflated
+ * @rx_usecs:		Time spent inflating them
+ */
+
+struct lws_ext_pm_deflate_stats {
+	unsigned long long tx_messages;
+	unsigned long long tx_bytes_in;
+	unsigned long long tx_bytes_out;
+	unsigned long long tx_usecs;
+	unsigned long long rx_messages;
+	unsigned long long rx_bytes_in;
+	unsigned long long rx_bytes_out;
+	unsigned long long rx_usecs;
+};
+
+/**
+ * struct lws_ext_pm_deflate_options -	permessage-deflate for one protocol
+ *
+ * @level:	zlib compression level, 0 to 9 or Z_DEFAULT_COMPRESSION
+ * @window_bits:	9 to 15, the window the server compresses with, or 0
+ *		for 15.  Smaller windows cost less memory per connection
+ *		and compress less.
+ * @mem_level:	zlib memory level, 1 to 9, or 0 for 8
+ * @no_context_takeover:	Start each message with an empty window,
+ *		which costs compression and saves keeping the window
+ *		between messages.  A client can ask for it too.
+ * @stats:	Totals for every connection of the protocol, counted by the
+ *		service thread
+ *
+ *	To tune permessage-deflate, point the per_context_private_data of
+ *	its extension at an array of these, one per protocol in the order
+ *	of the protocols array.  Which protocols it is allowed on is up to
+ *	LWS_CALLBACK_CONFIRM_EXTENSION_OKAY.
+ */
+
+struct lws_ext_pm_deflate_options {
+	int level;
+	int window_bits;
+	int mem_level;
+	int no_context_takeover;
+	struct lws_ext_pm_deflate_stats stats;
+};
 #endif
 
 /**
@@ -856,6 +929,12 @@ LWS_EXTERN int
 libwebsockets_serve_http_file_fragment(struct libwebsocket_context *context,
 			struct libwebsocket *wsi);
 
+LWS_EXTERN int
+libwebsockets_serve_http_memory(struct libwebsocket_context *context,
+			struct libwebsocket *wsi, const char *headers,
+			size_t headers_len, const unsigned char *buffer,
+							   size_t len);
+
 LWS_EXTERN const struct libwebsocket_protocols *
 libwebsockets_get_protocol(struct libwebsocket *wsi);
 
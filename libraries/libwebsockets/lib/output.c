@@ -486,7 +486,14 @@ int libwebsockets_serve_http_file_fragment(
 	int n;
 
 	while (!lws_send_pipe_choked(wsi)) {
-		n = read(wsi->u.http.fd, context->service_buffer,
+		if (wsi->u.http.buffer) {
+			n = wsi->u.http.filelen - wsi->u.http.filepos;
+			if (n > sizeof(context->service_buffer))
+				n = sizeof(context->service_buffer);
+			memcpy(context->service_buffer,
+			       wsi->u.http.buffer + wsi->u.http.filepos, n);
+		} else
+			n = read(wsi->u.http.fd, context->service_buffer,
 					       sizeof(context->service_buffer));
 		if (n > 0) {
 			libwebsocket_write(wsi, context->service_buffer, n,
@@ -541,6 +548,7 @@ int libwebsockets_serve_http_file(struct libwebsocket_context *context,
 	unsigned char *p = context->service_buffer;
 	int ret = 0;
 
+	wsi->u.http.buffer = NULL;
 	wsi->u.http.fd = open(file, O_RDONLY
 #ifdef WIN32
 			 | _O_BINARY
@@ -578,3 +586,35 @@ int libwebsockets_serve_http_file(struct libwebsocket_context *context,
 	return libwebsockets_serve_http_file_fragment(context, wsi);
 }
 
+/**
+ * libwebsockets_serve_http_memory() - Send a buffer back to the client using http
+ * @context:		libwebsockets context
+ * @wsi:		Websocket instance (available from user callback)
+ * @headers:		The complete http response headers, ending in a blank line
+ * @headers_len:	The length of @headers
+ * @buffer:		The response body
+ * @len:		The length of @buffer
+ *
+ *	Like libwebsockets_serve_http_file(), but the caller writes the headers
+ *	and the body comes from memory, which must stay valid until
+ *	LWS_CALLBACK_HTTP_FILE_COMPLETION or the connection closes.  The return
+ *	value means the same.
+ */
+
+int libwebsockets_serve_http_memory(struct libwebsocket_context *context,
+			struct libwebsocket *wsi, const char *headers,
+			size_t headers_len, const unsigned char *buffer,
+							   size_t len)
+{
+	if (libwebsocket_write(wsi, (unsigned char *)headers, headers_len,
+							      LWS_WRITE_HTTP))
+		return -1;
+
+	wsi->u.http.fd = 0;
+	wsi->u.http.buffer = buffer;
+	wsi->u.http.filepos = 0;
+	wsi->u.http.filelen = len;
+	wsi->state = WSI_STATE_HTTP_ISSUING_FILE;
+
+	return libwebsockets_serve_http_file_fragment(context, wsi);
+}
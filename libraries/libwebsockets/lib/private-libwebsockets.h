@@ -303,6 +303,7 @@ enum pending_timeout {
 
 struct _lws_http_mode_related {
 	int fd;
+	const unsigned char *buffer; /* served instead of fd if set */
 	unsigned long filepos;
 	unsigned long filelen;
 };
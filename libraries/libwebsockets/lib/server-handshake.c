@@ -38,9 +38,12 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 #ifndef LWS_NO_EXTENSIONS
 	char *c;
 	char ext_name[128];
+	char *ext_params;
 	struct libwebsocket_extension *ext;
+	struct lws_ext_negotiation negotiation;
 	int ext_count = 0;
 	int more = 1;
+	int m;
 #endif
 
 	if (!lws_hdr_total_length(wsi, WSI_TOKEN_HOST) ||
@@ -124,10 +127,18 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 		n = 0;
 		while (more) {
 
-			if (*c && (*c != ',' && *c != ' ' && *c != '\t')) {
-				ext_name[n] = *c++;
-				if (n < sizeof(ext_name) - 1)
-					n++;
+			/*
+			 * each offer runs up to the next ',': the extension
+			 * name, then any parameters after a ';'
+			 */
+
+			if (*c && *c != ',') {
+				if (n || (*c != ' ' && *c != '\t')) {
+					ext_name[n] = *c;
+					if (n < sizeof(ext_name) - 1)
+						n++;
+				}
+				c++;
 				continue;
 			}
 			ext_name[n] = '\0';
@@ -139,6 +150,17 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 					continue;
 			}
 
+			negotiation.offer = "";
+			ext_params = strchr(ext_name, ';');
+			if (ext_params) {
+				*ext_params = '\0';
+				negotiation.offer = ext_params + 1;
+			}
+			m = strlen(ext_name);
+			while (m && (ext_name[m - 1] == ' ' ||
+						     ext_name[m - 1] == '\t'))
+				ext_name[--m] = '\0';
+
 			/* check a client's extension against our support */
 
 			ext = wsi->protocol->owning_server->extensions;
@@ -150,6 +172,20 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 					continue;
 				}
 
+				/*
+				 * a client may offer one extension several
+				 * ways, in order of preference: the first
+				 * we take is the one
+				 */
+
+				for (m = 0; m < wsi->count_active_extensions; m++)
+					if (wsi->active_extensions[m] == ext)
+						break;
+				if (m != wsi->count_active_extensions) {
+					ext++;
+					continue;
+				}
+
 				/*
 				 * oh, we do support this one he
 				 * asked for... but let's ask user
@@ -176,16 +212,6 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 					continue;
 				}
 
-				/* apply it */
-
-				if (ext_count)
-					*p++ = ',';
-				else
-					LWS_CPYAPP(p,
-					 "\x0d\x0aSec-WebSocket-Extensions: ");
-				p += sprintf(p, "%s", ext_name);
-				ext_count++;
-
 				/* instantiate the extension on this conn */
 
 				wsi->active_extensions_user[
@@ -204,13 +230,36 @@ handshake_0405(struct libwebsocket_context *context, struct libwebsocket *wsi)
 				wsi->active_extensions[
 					  wsi->count_active_extensions] = ext;
 
-				/* allow him to construct his context */
+				/*
+				 * allow him to construct his context, and to
+				 * decline parameters he can't go along with
+				 */
 
-				ext->callback(wsi->protocol->owning_server,
+				negotiation.reply[0] = '\0';
+				if (ext->callback(wsi->protocol->owning_server,
 						ext, wsi,
 						LWS_EXT_CALLBACK_CONSTRUCT,
 						wsi->active_extensions_user[
-					wsi->count_active_extensions], NULL, 0);
+						wsi->count_active_extensions],
+							     &negotiation, 0)) {
+					free(wsi->active_extensions_user[
+						wsi->count_active_extensions]);
+					ext++;
+					continue;
+				}
+
+				/* apply it */
+
+				if (ext_count)
+					*p++ = ',';
+				else
+					LWS_CPYAPP(p,
+					 "\x0d\x0aSec-WebSocket-Extensions: ");
+				p += sprintf(p, "%s", ext_name);
+				if (negotiation.reply[0])
+					p += sprintf(p, "; %s",
+							   negotiation.reply);
+				ext_count++;
 
 				wsi->count_active_extensions++;
 				lwsl_parser("count_active_extensions <- %d\n",
@@ -244,6 +244,11 @@ dump_handshake_info(struct libwebsocket *wsi)
 		/*[WSI_TOKEN_ACCEPT]		=*/ "Accept",
 		/*[WSI_TOKEN_NONCE]		=*/ "Nonce",
 		/*[WSI_TOKEN_HTTP]		=*/ "Http",
+
+		/* http requests */
+		/*[WSI_TOKEN_HTTP_ACCEPT_ENCODING]	=*/ "Accept-Encoding",
+		/*[WSI_TOKEN_HTTP_IF_NONE_MATCH]	=*/ "If-None-Match",
+
 		/*[WSI_TOKEN_MUXURL]	=*/ "MuxURL",
 	};
 	char buf[256];
@@ -116,6 +116,7 @@ extern void       stb_mixhigh_deinit(void);
 #include <stdlib.h>
 #include <stdio.h>
 #include <memory.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include <stdarg.h>
@@ -166,6 +167,7 @@ static stb_mixint stb__wrap(stb_mixint t)
 
 void *stb__pi1,*stb__pf1;
 
+#ifdef _MSC_VER
 static unsigned int stb__cpuid_features(void)
 {
    unsigned int res;
@@ -176,6 +178,7 @@ static unsigned int stb__cpuid_features(void)
    }
    return res;
 }
+#endif
 
 static int stb__has_sse2, stb__has_sse;
 void stb_mixlow_init(stb_mixint stb__premix_samples)
@@ -188,8 +191,8 @@ void stb_mixlow_init(stb_mixint stb__premix_samples)
    stb__pi1 = stb__premix_int;
    stb__pf1 = stb__premix_float;
 
-   stb__premix_int   = (short *) (((int) stb__premix_int + 15) & ~15);
-   stb__premix_float = (float *) (((int) stb__premix_float + 15) & ~15);
+   stb__premix_int   = (short *) (((size_t) stb__premix_int + 15) & ~15);
+   stb__premix_float = (float *) (((size_t) stb__premix_float + 15) & ~15);
 
    stb__premix_offset = 0;
    stb__premix_time   = 0;
@@ -511,15 +514,15 @@ static void stb__mix_integerize(stb_mixint off, stb_mixint len)
    if (len == 0) return;
    len *= 2;
 
-   while (((int) output | (int) outi) & 0xf) {
+   while (((size_t) output | (size_t) outi) & 0xf) {
       *outi++ = stb__integerize_one(output++);
       if (!--len) break;
    }
 
    i=0;
    if (len) {
-      assert((((int) output) & 0xf) == 0);
-      assert((((int) outi) & 0xf) == 0);
+      assert((((size_t) output) & 0xf) == 0);
+      assert((((size_t) outi) & 0xf) == 0);
    }
    #ifdef _MSC_VER
    if (stb__has_sse2) {
@@ -0,0 +1,310 @@
+#define STB_VORBIS_NO_PULLDATA_API
+#include <stb_vorbis.c>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ambienceplayer.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** Enough for any Ogg page, which pushdata needs whole. */
+    constexpr std::size_t kInputBytes = 64 * 1024;
+
+    /** stb_vorbis allocates everything a stream needs from this; typical files need under half. */
+    constexpr std::size_t kDecoderBytes = 256 * 1024;
+
+    /** About 370 ms at 44.1 kHz. */
+    constexpr std::size_t kRingFrames = 16 * 1024;
+
+    constexpr float kCrossfadeSeconds = 2.0f;
+
+    /** The longest the decoder thread works on one stream before turning to the next. */
+    constexpr auto kDecodeBudget = std::chrono::milliseconds(2);
+
+    /** How long the decoder thread sleeps when every ring is full. */
+    constexpr auto kPollInterval = std::chrono::milliseconds(5);
+
+  }  // namespace
+
+  AmbiencePlayer::AmbiencePlayer(int sample_rate)
+  : sample_rate(sample_rate), streams(), current(), underruns(), statistics_mutex(), totals(),
+    running(), thread() {}
+
+  AmbiencePlayer::~AmbiencePlayer() {
+    running = false;
+    if (thread.joinable()) {
+      thread.join();
+    }
+    for (auto &stream : streams) {
+      Close(stream);
+    }
+  }
+
+  void AmbiencePlayer::Play(const std::string &filename) {
+    if (filename == current) {
+      return;
+    }
+    current = filename;
+    for (auto &stream : streams) {
+      stream.audible.store(false);
+    }
+    if (filename.empty()) {
+      return;
+    }
+    // A stream still fading out is left to finish; coming back starts the file afresh.
+    for (auto &stream : streams) {
+      if (kFree == stream.state.load(std::memory_order_acquire)) {
+        stream.filename = filename;
+        stream.audible.store(true);
+        stream.state.store(kOpening, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  void AmbiencePlayer::Run() {
+    running = true;
+    thread = std::thread(&AmbiencePlayer::Loop, this);
+  }
+
+  void AmbiencePlayer::Mix(float *left, float *right, std::size_t frame_count) {
+    const auto fade_step = 1.0f / (kCrossfadeSeconds * sample_rate);
+    for (auto &stream : streams) {
+      if (kPlaying != stream.state.load(std::memory_order_acquire)) {
+        continue;
+      }
+      const auto target = stream.audible.load() ? 1.0f : 0.0f;
+      const auto read = stream.read.load(std::memory_order_relaxed);
+      const auto available = stream.write.load(std::memory_order_acquire) - read;
+      const auto count = std::min(available, frame_count);
+      if (count < frame_count && target > 0.0f) {
+        ++underruns;
+      }
+      for (std::size_t i = 0; i < frame_count; ++i) {
+        stream.fade = target > stream.fade ? std::min(stream.fade + fade_step, target)
+                                           : std::max(stream.fade - fade_step, target);
+        if (i < count) {
+          // Equal-power, so a crossfade does not dip in the middle.
+          const auto gain = std::sin(stream.fade * static_cast<float>(M_PI) / 2.0f);
+          const auto frame = &stream.ring[2 * ((read + i) % kRingFrames)];
+          left[i] += frame[0] * gain;
+          right[i] += frame[1] * gain;
+        }
+      }
+      stream.read.store(read + count, std::memory_order_release);
+      if (0.0f == stream.fade && 0.0f == target) {
+        stream.state.store(kFinished, std::memory_order_release);
+      }
+    }
+  }
+
+  bool AmbiencePlayer::active() const {
+    for (const auto &stream : streams) {
+      if (kPlaying == stream.state.load(std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  AmbiencePlayer::Statistics AmbiencePlayer::statistics() const {
+    std::lock_guard<std::mutex> lock(statistics_mutex);
+    auto result = totals;
+    result.underruns = underruns;
+    return result;
+  }
+
+  std::size_t AmbiencePlayer::stream_bytes() {
+    return kInputBytes + kDecoderBytes + 2 * sizeof(float) * kRingFrames;
+  }
+
+  void AmbiencePlayer::Close(Stream &stream) {
+    if (stream.decoder) {
+      stb_vorbis_close(stream.decoder);
+      stream.decoder = nullptr;
+    }
+    if (stream.file) {
+      std::fclose(stream.file);
+      stream.file = nullptr;
+    }
+  }
+
+  bool AmbiencePlayer::Decode(Stream &stream, std::chrono::steady_clock::time_point deadline) {
+    // The most frames one decoded Vorbis frame can become after resampling.
+    const auto frame_limit = static_cast<std::size_t>(
+        stb_vorbis_get_info(stream.decoder).max_frame_size / stream.step) + 2;
+    auto progressed = false;
+    while (std::chrono::steady_clock::now() < deadline) {
+      const auto used = stream.write.load(std::memory_order_relaxed)
+          - stream.read.load(std::memory_order_acquire);
+      if (kRingFrames - used < frame_limit) {
+        break;
+      }
+      int channels, count = 0;
+      float **samples;
+      const auto consumed = stb_vorbis_decode_frame_pushdata(
+          stream.decoder, stream.input.data(), static_cast<int>(stream.input_size), &channels,
+          &samples, &count);
+      if (!consumed && !count) {
+        if (!Refill(stream)) {
+          return false;
+        }
+        continue;
+      }
+      stream.input_size -= consumed;
+      std::memmove(stream.input.data(), stream.input.data() + consumed, stream.input_size);
+      if (count) {
+        Resample(stream, samples, count);
+        progressed = true;
+      }
+    }
+    return progressed;
+  }
+
+  void AmbiencePlayer::Loop() {
+    while (running) {
+      auto progressed = false;
+      for (auto &stream : streams) {
+        const auto state = stream.state.load(std::memory_order_acquire);
+        if (kOpening == state) {
+          const auto start = std::chrono::steady_clock::now();
+          auto opened = Open(stream);
+          if (opened) {
+            // Decoding nothing in the budget is fine; the stream only fails if it closed.
+            Decode(stream, start + kDecodeBudget);
+            opened = nullptr != stream.decoder;
+          }
+          const std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - start;
+          std::lock_guard<std::mutex> lock(statistics_mutex);
+          totals.maximum_pass = std::max(totals.maximum_pass, elapsed);
+          if (opened) {
+            ++totals.streams_opened;
+            totals.decoded_frames += stream.write.load(std::memory_order_relaxed);
+            const auto info = stb_vorbis_get_info(stream.decoder);
+            totals.peak_stream_bytes = std::max<std::size_t>(
+                totals.peak_stream_bytes, kInputBytes + 2 * sizeof(float) * kRingFrames +
+                info.setup_memory_required + info.temp_memory_required);
+            stream.state.store(kPlaying, std::memory_order_release);
+          } else {
+            ++totals.streams_failed;
+            Close(stream);
+            stream.state.store(kFree, std::memory_order_release);
+          }
+          progressed = true;
+        } else if (kPlaying == state && stream.decoder) {
+          const auto start = std::chrono::steady_clock::now();
+          const auto before = stream.write.load(std::memory_order_relaxed);
+          if (Decode(stream, start + kDecodeBudget)) {
+            progressed = true;
+          } else if (!stream.decoder) {
+            // It failed; the mixer fades out what is left in the ring.
+            stream.audible.store(false);
+          }
+          const std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - start;
+          std::lock_guard<std::mutex> lock(statistics_mutex);
+          totals.decoded_frames += stream.write.load(std::memory_order_relaxed) - before;
+          totals.decoding += elapsed;
+          totals.maximum_pass = std::max(totals.maximum_pass, elapsed);
+        } else if (kFinished == state) {
+          Close(stream);
+          stream.state.store(kFree, std::memory_order_release);
+        }
+      }
+      if (!progressed) {
+        std::this_thread::sleep_for(kPollInterval);
+      }
+    }
+  }
+
+  bool AmbiencePlayer::Open(Stream &stream) {
+    stream.decoder_memory.resize(kDecoderBytes);
+    stream.input.resize(kInputBytes);
+    stream.ring.resize(2 * kRingFrames);
+    stream.input_size = 0;
+    stream.read.store(0);
+    stream.write.store(0);
+    stream.position = 0.0f;
+    stream.previous_left = stream.previous_right = 0.0f;
+    stream.fade = 0.0f;
+    stream.file = std::fopen(stream.filename.c_str(), "rb");
+    return stream.file && Refill(stream);
+  }
+
+  bool AmbiencePlayer::Refill(Stream &stream) {
+    if (stream.input_size == stream.input.size()) {
+      // Not even a whole buffer was enough: the file is corrupt or has an enormous page.
+      Close(stream);
+      return false;
+    }
+    const auto read = std::fread(stream.input.data() + stream.input_size, 1,
+                                 stream.input.size() - stream.input_size, stream.file);
+    stream.input_size += read;
+    if (!read) {
+      if (!stream.decoder || std::ferror(stream.file)) {
+        Close(stream);
+        return false;
+      }
+      // At the end of the file: start over. What remains of the input cannot complete a frame.
+      stb_vorbis_close(stream.decoder);
+      stream.decoder = nullptr;
+      stream.input_size = 0;
+      std::rewind(stream.file);
+      return Refill(stream);
+    }
+    if (!stream.decoder) {
+      int consumed, error;
+      stb_vorbis_alloc alloc = {stream.decoder_memory.data(),
+                                static_cast<int>(stream.decoder_memory.size())};
+      stream.decoder = stb_vorbis_open_pushdata(stream.input.data(),
+                                                static_cast<int>(stream.input_size), &consumed,
+                                                &error, &alloc);
+      if (!stream.decoder) {
+        // The headers may not all be in yet.
+        return VORBIS_need_more_data == error && Refill(stream);
+      }
+      stream.input_size -= consumed;
+      std::memmove(stream.input.data(), stream.input.data() + consumed, stream.input_size);
+      const auto info = stb_vorbis_get_info(stream.decoder);
+      stream.channels = info.channels;
+      stream.step = static_cast<float>(info.sample_rate) / sample_rate;
+    }
+    return true;
+  }
+
+  // Linear interpolation, carrying the last frame and the fractional position from one decoded
+  // frame to the next so that the joins are seamless; a position of -1 is the carried frame.
+  void AmbiencePlayer::Resample(Stream &stream, float **samples, int count) {
+    const auto left_samples = samples[0];
+    const auto right_samples = samples[stream.channels > 1 ? 1 : 0];
+    auto write = stream.write.load(std::memory_order_relaxed);
+    auto position = stream.position;
+    while (position < count - 1) {
+      const auto index = static_cast<int>(std::floor(position));
+      const auto fraction = position - index;
+      const auto left_a = index < 0 ? stream.previous_left : left_samples[index];
+      const auto right_a = index < 0 ? stream.previous_right : right_samples[index];
+      const auto frame = &stream.ring[2 * (write % kRingFrames)];
+      frame[0] = 32767.0f * (left_a + (left_samples[index + 1] - left_a) * fraction);
+      frame[1] = 32767.0f * (right_a + (right_samples[index + 1] - right_a) * fraction);
+      ++write;
+      position += stream.step;
+    }
+    stream.position = position - count;
+    stream.previous_left = left_samples[count - 1];
+    stream.previous_right = right_samples[count - 1];
+    stream.write.store(write, std::memory_order_release);
+  }
+
+}  // namespace textengine
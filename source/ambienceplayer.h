@@ -0,0 +1,135 @@
+#ifndef __textengine__ambienceplayer__
+#define __textengine__ambienceplayer__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audiosource.h"
+
+struct stb_vorbis;
+
+namespace textengine {
+
+  /**
+   * Loops one Ogg Vorbis file at a time as background ambience, crossfading when it changes.
+   *
+   * A decoder thread reads each file a block at a time and decodes it with the stb_vorbis pushdata
+   * API into a ring buffer, resampling to the output rate, so a file is never loaded whole. Every
+   * stream has fixed input, decoder and ring buffers, and the thread decodes for at most a set
+   * time per pass before moving on to the next stream, so both memory and decoding are bounded.
+   *
+   * Each stream slot is handed between the simulation, decoder and mixer threads through an
+   * atomic state, so none of them takes a lock to play, decode or mix.
+   */
+  class AmbiencePlayer : public AudioSource {
+  public:
+    struct Statistics {
+      std::size_t streams_opened, streams_failed, underruns;
+      std::size_t decoded_frames;
+      std::chrono::duration<double, std::milli> decoding, maximum_pass;
+
+      /** The most any stream has held, counting the input, decoder and ring buffers. */
+      std::size_t peak_stream_bytes;
+    };
+
+    explicit AmbiencePlayer(int sample_rate);
+
+    virtual ~AmbiencePlayer();
+
+    /**
+     * Crossfades to filename, or to silence if it is empty. Simulation thread only.
+     */
+    void Play(const std::string &filename);
+
+    void Run();
+
+    virtual void Mix(float *left, float *right, std::size_t frame_count) override;
+
+    virtual bool active() const override;
+
+    Statistics statistics() const;
+
+    /** The memory held by each stream, whatever it plays. */
+    static std::size_t stream_bytes();
+
+  private:
+    enum State : int {
+      /** Unused; the simulation thread may claim it. */
+      kFree,
+
+      /** Claimed for a file the decoder thread has yet to open. */
+      kOpening,
+
+      /** Decoding into its ring and mixed from it. */
+      kPlaying,
+
+      /** Faded out; the decoder thread closes it. */
+      kFinished
+    };
+
+    static constexpr std::size_t kStreamCount = 4;
+
+    struct Stream {
+      std::atomic<int> state;
+      std::string filename;
+
+      /** Written by the simulation thread, followed by the mixer. */
+      std::atomic<bool> audible;
+
+      // Decoder side.
+      std::FILE *file;
+      stb_vorbis *decoder;
+      std::vector<char> decoder_memory;
+      std::vector<unsigned char> input;
+      std::size_t input_size;
+      int channels;
+      float step, position, previous_left, previous_right;
+
+      /** Stereo frames, written by the decoder thread and read by the mixer thread. */
+      std::vector<float> ring;
+      std::atomic<std::size_t> read, write;
+
+      // Mixer side.
+      float fade;
+    };
+
+    bool Decode(Stream &stream, std::chrono::steady_clock::time_point deadline);
+
+    void Close(Stream &stream);
+
+    void Loop();
+
+    bool Open(Stream &stream);
+
+    /**
+     * Fills the input buffer from the file, restarting the decoder at the end of the file so the
+     * ambience loops. Returns false if the stream cannot go on.
+     */
+    bool Refill(Stream &stream);
+
+    void Resample(Stream &stream, float **samples, int count);
+
+  private:
+    int sample_rate;
+    std::array<Stream, kStreamCount> streams;
+
+    // Simulation side.
+    std::string current;
+
+    std::atomic<std::size_t> underruns;
+    mutable std::mutex statistics_mutex;
+    Statistics totals;
+    std::atomic<bool> running;
+    std::thread thread;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__ambienceplayer__) */
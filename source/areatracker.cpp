@@ -0,0 +1,81 @@
+#include <Box2D/Box2D.h>
+#include <utility>
+#include <vector>
+
+#include "areatracker.h"
+#include "scene.h"
+
+namespace textengine {
+
+  void AreaTracker::Insert(Handle area, const AxisAlignedBoundingBox &aabb) {
+    b2AABB bounds;
+    bounds.lowerBound.Set(aabb.minimum.x, aabb.minimum.y);
+    bounds.upperBound.Set(aabb.maximum.x, aabb.maximum.y);
+    const auto proxy = proxies.find(area);
+    if (proxies.cend() == proxy) {
+      proxies.emplace(area, tree.CreateProxy(bounds, area.ToUserData()));
+    } else {
+      tree.DestroyProxy(proxy->second);
+      proxy->second = tree.CreateProxy(bounds, area.ToUserData());
+    }
+  }
+
+  bool AreaTracker::Inside(Handle area) const {
+    return inside.cend() != inside.find(area);
+  }
+
+  const std::unordered_set<Handle, HandleHash> &AreaTracker::inside_areas() const {
+    return inside;
+  }
+
+  void AreaTracker::Rebuild(b2TaskExecutor *executor) {
+    tree.RebuildTopDown(executor);
+  }
+
+  void AreaTracker::Remove(Handle area) {
+    const auto proxy = proxies.find(area);
+    if (proxies.cend() != proxy) {
+      tree.DestroyProxy(proxy->second);
+      proxies.erase(proxy);
+    }
+  }
+
+  bool AreaTracker::Tracks(Handle area) const {
+    return proxies.cend() != proxies.find(area);
+  }
+
+  void AreaTracker::Update(Scene &scene, glm::vec2 position,
+                           std::vector<Handle> &entered, std::vector<Handle> &exited) {
+    std::swap(inside, previous);
+    inside.clear();
+    b2AABB point;
+    point.lowerBound.Set(position.x, position.y);
+    point.upperBound = point.lowerBound;
+    Query query{tree, scene, position, inside};
+    tree.Query(&query, point);
+    for (const auto area : inside) {
+      if (previous.cend() == previous.find(area)) {
+        entered.push_back(area);
+      }
+    }
+    for (const auto area : previous) {
+      if (inside.cend() == inside.find(area)) {
+        exited.push_back(area);
+      }
+    }
+  }
+
+  std::size_t AreaTracker::size() const {
+    return proxies.size();
+  }
+
+  bool AreaTracker::Query::QueryCallback(int32 proxy) {
+    const auto area = Handle::FromUserData(tree.GetUserData(proxy));
+    const auto object = scene.Find(area);
+    if (object && object->Contains(position)) {
+      inside.insert(area);
+    }
+    return true;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,78 @@
+#ifndef __textengine__areatracker__
+#define __textengine__areatracker__
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "handle.h"
+#include "scene.h"
+
+namespace textengine {
+
+  /**
+   * Tracks which areas contain the player. Areas live in a b2DynamicTree of their own rather than
+   * as Box2D sensors, so membership costs one point query per tick instead of a narrowphase
+   * contact per overlapping area.
+   */
+  class AreaTracker {
+  public:
+    AreaTracker() = default;
+
+    virtual ~AreaTracker() = default;
+
+    /**
+     * Starts tracking an area, or updates its bounds if it is already tracked.
+     */
+    void Insert(Handle area, const AxisAlignedBoundingBox &aabb);
+
+    bool Inside(Handle area) const;
+
+    /**
+     * The areas that contained the player at the last update.
+     */
+    const std::unordered_set<Handle, HandleHash> &inside_areas() const;
+
+    /**
+     * Rebuilds the area tree top down, which queries faster than one built up by Insert.
+     */
+    void Rebuild(b2TaskExecutor *executor = nullptr);
+
+    /**
+     * Stops tracking an area. If the player was inside it, the next Update reports it as exited.
+     */
+    void Remove(Handle area);
+
+    bool Tracks(Handle area) const;
+
+    /**
+     * Finds the areas containing position and appends those the player entered or exited since
+     * the last update.
+     */
+    void Update(Scene &scene, glm::vec2 position,
+                std::vector<Handle> &entered, std::vector<Handle> &exited);
+
+    std::size_t size() const;
+
+  private:
+    struct Query {
+      bool QueryCallback(int32 proxy);
+
+      const b2DynamicTree &tree;
+      Scene &scene;
+      glm::vec2 position;
+      std::unordered_set<Handle, HandleHash> &inside;
+    };
+
+  private:
+    b2DynamicTree tree;
+    std::unordered_map<Handle, int32, HandleHash> proxies;
+    std::unordered_set<Handle, HandleHash> inside, previous;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__areatracker__) */
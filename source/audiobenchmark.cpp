@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audiobenchmark.h"
+#include "audioengine.h"
+#include "audiosink.h"
+#include "checks.h"
+#include "cuemixer.h"
+#include "speechsynthesizer.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr float kUtteranceSeconds = 0.02f;
+    constexpr auto kPollInterval = std::chrono::microseconds(100);
+
+    /** As many frames as the engine mixes at once. */
+    constexpr std::size_t kCueBlockFrames = 512;
+
+    /** Says anything as a moment of silence, without taking any time to. */
+    class InstantSpeechSynthesizer : public SpeechSynthesizer {
+    public:
+      explicit InstantSpeechSynthesizer(int sample_rate) : sample_rate(sample_rate) {}
+
+      virtual ~InstantSpeechSynthesizer() = default;
+
+      virtual bool Synthesize(const std::string &, AudioClip &clip) override {
+        clip.sample_rate = sample_rate;
+        clip.channels = 1;
+        clip.samples.assign(static_cast<std::size_t>(kUtteranceSeconds * sample_rate), 0);
+        return true;
+      }
+
+    private:
+      int sample_rate;
+    };
+
+  }  // namespace
+
+  AudioBenchmark::AudioBenchmark(int sample_rate) : sample_rate(sample_rate) {}
+
+  std::vector<AudioBenchmark::Result> AudioBenchmark::Speak(std::size_t utterance_count) {
+    std::vector<Result> results;
+    InstantSpeechSynthesizer synthesizer(sample_rate);
+    for (const auto paced : {false, true}) {
+      NullAudioSink sink(sample_rate, paced);
+      AudioEngine engine(sink, synthesizer);
+      engine.Run();
+      for (std::size_t i = 0; i < utterance_count; ++i) {
+        engine.Speak("utterance " + std::to_string(i));
+        do {
+          std::this_thread::sleep_for(kPollInterval);
+        } while (engine.busy());
+      }
+      results.push_back({paced ? "paced" : "unpaced", engine.statistics()});
+    }
+    return results;
+  }
+
+  std::vector<AudioBenchmark::CueResult> AudioBenchmark::MixCues(
+      const std::vector<std::size_t> &voice_counts, std::size_t block_count) {
+    std::vector<CueResult> results;
+    std::vector<float> left(kCueBlockFrames), right(kCueBlockFrames);
+    for (const auto voice_count : voice_counts) {
+      for (const auto vectorized : {true, false}) {
+        CueMixer mixer(sample_rate, voice_count, vectorized);
+        CueResult result{voice_count, vectorized, {}, 0.0};
+        for (std::size_t block = 0; block < block_count; ++block) {
+          for (std::size_t key = 0; key < voice_count; ++key) {
+            const auto phase = static_cast<float>(block + key);
+            CHECK_STATE(mixer.Emit(static_cast<long>(key), 0.5f + 0.25f * std::sin(phase),
+                                   std::cos(phase)));
+          }
+          mixer.End();
+          std::fill(left.begin(), left.end(), 0.0f);
+          std::fill(right.begin(), right.end(), 0.0f);
+          const auto start = std::chrono::high_resolution_clock::now();
+          mixer.Mix(left.data(), right.data(), kCueBlockFrames);
+          result.block += std::chrono::high_resolution_clock::now() - start;
+        }
+        result.block /= block_count;
+        result.load = result.block / std::chrono::duration<double, std::micro>(
+            1e6 * kCueBlockFrames / sample_rate);
+        results.push_back(result);
+      }
+    }
+    return results;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,59 @@
+#ifndef __textengine__audiobenchmark__
+#define __textengine__audiobenchmark__
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "audioengine.h"
+
+namespace textengine {
+
+  /**
+   * Runs the audio engine headless, on a NullAudioSink, with a synthesizer that returns a short
+   * silent clip at once. Synthesis then costs nothing, so the latency left is the engine's own:
+   * handing the clip to the mixer and waiting for a block to write it in.
+   *
+   * It also times CueMixer alone, with and without its vectorized inner loop.
+   */
+  class AudioBenchmark {
+  public:
+    struct Result {
+      std::string sink;
+      AudioEngine::Statistics statistics;
+    };
+
+    struct CueResult {
+      std::size_t voice_count;
+      bool vectorized;
+
+      /** Mean time to mix one block of the engine's size, and that as a share of real time. */
+      std::chrono::duration<double, std::micro> block;
+      double load;
+    };
+
+    explicit AudioBenchmark(int sample_rate);
+
+    virtual ~AudioBenchmark() = default;
+
+    /**
+     * Speaks utterance_count lines one after another, each once the last has played, into a
+     * sink that takes audio as fast as it is mixed and then into one paced like a device.
+     */
+    std::vector<Result> Speak(std::size_t utterance_count);
+
+    /**
+     * Mixes block_count blocks from a CueMixer with each of voice_counts voices sounding, with
+     * every gain changing each block so that every voice ramps.
+     */
+    std::vector<CueResult> MixCues(const std::vector<std::size_t> &voice_counts,
+                                   std::size_t block_count);
+
+  private:
+    int sample_rate;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__audiobenchmark__) */
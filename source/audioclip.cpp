@@ -0,0 +1,119 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "audioclip.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr std::uint16_t kPcmFormat = 1;
+    constexpr std::uint16_t kExtensibleFormat = 0xfffe;
+
+    template <typename T>
+    bool Get(std::istream &in, T &value) {
+      in.read(reinterpret_cast<char *>(&value), sizeof(T));
+      return static_cast<std::size_t>(in.gcount()) == sizeof(T);
+    }
+
+    template <typename T>
+    void Put(std::ostream &out, T value) {
+      out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    bool GetTag(std::istream &in, char (&tag)[4]) {
+      in.read(tag, sizeof(tag));
+      return static_cast<std::size_t>(in.gcount()) == sizeof(tag);
+    }
+
+  }  // namespace
+
+  bool ReadWave(const std::string &filename, AudioClip &clip) {
+    std::ifstream in(filename, std::ios_base::binary);
+    char tag[4];
+    std::uint32_t size;
+    if (!GetTag(in, tag) || std::memcmp(tag, "RIFF", 4) || !Get(in, size) ||
+        !GetTag(in, tag) || std::memcmp(tag, "WAVE", 4)) {
+      return false;
+    }
+    auto have_format = false;
+    while (GetTag(in, tag) && Get(in, size)) {
+      // Chunks are padded to an even length.
+      const auto next = in.tellg() + static_cast<std::streamoff>(size + (size & 1));
+      if (!std::memcmp(tag, "fmt ", 4)) {
+        std::uint16_t format, channels, block_align, bits;
+        std::uint32_t sample_rate, byte_rate;
+        if (!Get(in, format) || !Get(in, channels) || !Get(in, sample_rate) ||
+            !Get(in, byte_rate) || !Get(in, block_align) || !Get(in, bits)) {
+          return false;
+        }
+        if ((kPcmFormat != format && kExtensibleFormat != format) || 16 != bits || !channels) {
+          return false;
+        }
+        clip.sample_rate = static_cast<int>(sample_rate);
+        clip.channels = channels;
+        have_format = true;
+      } else if (!std::memcmp(tag, "data", 4)) {
+        if (!have_format) {
+          return false;
+        }
+        clip.samples.resize(size / sizeof(short));
+        in.read(reinterpret_cast<char *>(clip.samples.data()), clip.samples.size() * sizeof(short));
+        clip.samples.resize(static_cast<std::size_t>(in.gcount()) / sizeof(short));
+        return true;
+      }
+      in.seekg(next);
+    }
+    return false;
+  }
+
+  bool WriteWave(const std::string &filename, const AudioClip &clip) {
+    std::ofstream out(filename, std::ios_base::binary);
+    const auto data_size = static_cast<std::uint32_t>(clip.samples.size() * sizeof(short));
+    const auto block_align = static_cast<std::uint16_t>(clip.channels * sizeof(short));
+    out.write("RIFF", 4);
+    Put<std::uint32_t>(out, 36 + data_size);
+    out.write("WAVEfmt ", 8);
+    Put<std::uint32_t>(out, 16);
+    Put<std::uint16_t>(out, kPcmFormat);
+    Put<std::uint16_t>(out, static_cast<std::uint16_t>(clip.channels));
+    Put<std::uint32_t>(out, static_cast<std::uint32_t>(clip.sample_rate));
+    Put<std::uint32_t>(out, static_cast<std::uint32_t>(clip.sample_rate) * block_align);
+    Put<std::uint16_t>(out, block_align);
+    Put<std::uint16_t>(out, 16);
+    out.write("data", 4);
+    Put<std::uint32_t>(out, data_size);
+    out.write(reinterpret_cast<const char *>(clip.samples.data()), data_size);
+    out.close();
+    return !out.fail();
+  }
+
+  void Resample(AudioClip &clip, int sample_rate) {
+    if (sample_rate == clip.sample_rate || !clip.frame_count()) {
+      clip.sample_rate = sample_rate;
+      return;
+    }
+    const auto channels = clip.channels;
+    const auto frames = clip.frame_count();
+    const auto step = static_cast<double>(clip.sample_rate) / sample_rate;
+    const auto count = static_cast<int>(frames / step);
+    std::vector<short> samples(static_cast<std::size_t>(count) * channels);
+    for (auto i = 0; i < count; ++i) {
+      const auto position = i * step;
+      const auto first = static_cast<int>(position);
+      const auto second = first + 1 < frames ? first + 1 : first;
+      const auto fraction = static_cast<float>(position - first);
+      for (auto c = 0; c < channels; ++c) {
+        const float a = clip.samples[first * channels + c];
+        const float b = clip.samples[second * channels + c];
+        samples[i * channels + c] = static_cast<short>(a + (b - a) * fraction);
+      }
+    }
+    clip.samples.swap(samples);
+    clip.sample_rate = sample_rate;
+  }
+
+}  // namespace textengine
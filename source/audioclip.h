@@ -0,0 +1,39 @@
+#ifndef __textengine__audioclip__
+#define __textengine__audioclip__
+
+#include <string>
+#include <vector>
+
+namespace textengine {
+
+  /**
+   * Interleaved signed 16-bit samples.
+   */
+  struct AudioClip {
+    int sample_rate;
+    int channels;
+    std::vector<short> samples;
+
+    int frame_count() const {
+      return channels ? static_cast<int>(samples.size()) / channels : 0;
+    }
+  };
+
+  /**
+   * Reads an uncompressed 16-bit RIFF WAVE file into clip and returns whether that succeeded.
+   */
+  bool ReadWave(const std::string &filename, AudioClip &clip);
+
+  /**
+   * Writes clip as a 16-bit RIFF WAVE file and returns whether that succeeded.
+   */
+  bool WriteWave(const std::string &filename, const AudioClip &clip);
+
+  /**
+   * Converts clip to sample_rate by linear interpolation, keeping its channels.
+   */
+  void Resample(AudioClip &clip, int sample_rate);
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__audioclip__) */
@@ -0,0 +1,264 @@
+#define STB_DEFINE
+#include <stb_audio_mixer.h>
+#undef STB_DEFINE
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audioengine.h"
+#include "audiosink.h"
+#include "audiosource.h"
+#include "speechsynthesizer.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** About 12 ms at 44.1 kHz: how far ahead of the sink the mixer works. */
+    constexpr std::size_t kBlockFrames = 512;
+    constexpr std::size_t kMaxQueuedUtterances = 8;
+
+    /** Sources do not wake the mixer, so while idle with sources it looks this often. */
+    constexpr auto kSourcePollInterval = std::chrono::milliseconds(10);
+
+    /** The effects bus's gain while speech plays, and how long it takes to get there and back. */
+    constexpr float kDuckGain = 0.25f;
+    constexpr float kDuckAttackSeconds = 0.05f;
+    constexpr float kDuckReleaseSeconds = 0.4f;
+
+    short Saturate(float sample) {
+      return static_cast<short>(std::min(std::max(sample, -32768.0f), 32767.0f));
+    }
+
+  }  // namespace
+
+  AudioEngine::AudioEngine(AudioSink &sink, SpeechSynthesizer &synthesizer)
+  : sink(sink), synthesizer(synthesizer), sources(),
+    duck_attack((1.0f - kDuckGain) / (kDuckAttackSeconds * sink.sample_rate())),
+    duck_release((1.0f - kDuckGain) / (kDuckReleaseSeconds * sink.sample_rate())),
+    effects_gain(1.0f), speaking(), spoken(), playbacks(), mutex(), synthesis_condition(),
+    mix_condition(), requests(), ready(), pending(), synthesizing(), totals(), voice_active(),
+    running(), synthesis_thread(), mix_thread() {}
+
+  AudioEngine::~AudioEngine() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+    synthesis_condition.notify_one();
+    mix_condition.notify_one();
+    if (synthesis_thread.joinable()) {
+      synthesis_thread.join();
+    }
+    if (mix_thread.joinable()) {
+      mix_thread.join();
+    }
+  }
+
+  void AudioEngine::AddSource(AudioSource &source) {
+    sources.push_back(&source);
+  }
+
+  void AudioEngine::Play(std::shared_ptr<const AudioClip> clip, float volume, float pan) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.push_back({clip, volume, pan, 0});
+    }
+    mix_condition.notify_one();
+  }
+
+  void AudioEngine::Run() {
+    running = true;
+    synthesis_thread = std::thread(&AudioEngine::SynthesisLoop, this);
+    mix_thread = std::thread(&AudioEngine::MixLoop, this);
+  }
+
+  void AudioEngine::Speak(const std::string &text) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (requests.size() + ready.size() >= kMaxQueuedUtterances) {
+        if (!ready.empty()) {
+          ready.pop_front();
+        } else {
+          requests.pop_front();
+        }
+        ++totals.dropped;
+      }
+      requests.push_back({text, Clock::now(), AudioClip()});
+    }
+    synthesis_condition.notify_one();
+  }
+
+  bool AudioEngine::busy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !requests.empty() || synthesizing || !ready.empty() || voice_active;
+  }
+
+  AudioEngine::Statistics AudioEngine::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+  }
+
+  bool AudioEngine::MixVoice(const std::vector<float> &effects, short *block,
+                             std::size_t frame_count) {
+    const auto started = speaking && !spoken;
+    const auto channels = speaking ? static_cast<std::size_t>(speaking->clip.channels) : 0;
+    const auto clip_frames = speaking ? static_cast<std::size_t>(speaking->clip.frame_count()) : 0;
+    for (std::size_t i = 0; i < frame_count; ++i) {
+      float left = 0.0f, right = 0.0f;
+      if (spoken < clip_frames) {
+        const auto sample = &speaking->clip.samples[spoken * channels];
+        left = sample[0];
+        right = sample[channels - 1];
+        ++spoken;
+      }
+      const auto target = spoken < clip_frames ? kDuckGain : 1.0f;
+      if (effects_gain > target) {
+        effects_gain = std::max(effects_gain - duck_attack, target);
+      } else if (effects_gain < target) {
+        effects_gain = std::min(effects_gain + duck_release, target);
+      }
+      block[2 * i] = Saturate(effects[2 * i] * effects_gain + left);
+      block[2 * i + 1] = Saturate(effects[2 * i + 1] * effects_gain + right);
+    }
+    return started;
+  }
+
+  void AudioEngine::MixLoop() {
+    stb_mixlow_init(kBlockFrames);
+    stb_mixlow_reset(0);
+    stb_mixint time = 0;
+    std::vector<short> block(2 * kBlockFrames);
+    std::vector<float> effects(2 * kBlockFrames);
+    std::vector<float> source_left(kBlockFrames), source_right(kBlockFrames);
+    std::vector<Playback> starting;
+    const auto should_mix = [this] () {
+      return !running || !pending.empty() || !ready.empty() || speaking || !playbacks.empty()
+          || effects_gain < 1.0f
+          || std::any_of(sources.cbegin(), sources.cend(), [] (const AudioSource *source) {
+               return source->active();
+             });
+    };
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      if (!sources.empty()) {
+        while (!mix_condition.wait_for(lock, kSourcePollInterval, should_mix)) {}
+      } else {
+        mix_condition.wait(lock, should_mix);
+      }
+      if (!running) {
+        break;
+      }
+      starting.swap(pending);
+      if (!speaking && !ready.empty()) {
+        speaking.reset(new Utterance(std::move(ready.front())));
+        ready.pop_front();
+        spoken = 0;
+        voice_active = true;
+      }
+      lock.unlock();
+
+      for (auto &playback : starting) {
+        const auto &clip = *playback.clip;
+        const auto frames = clip.frame_count();
+        const auto step = static_cast<float>(clip.sample_rate) / sink.sample_rate();
+        // Resampling interpolates toward the next frame, so it must stop a frame short.
+        const auto duration = 1.0f == step ? frames : static_cast<int>((frames - 1) / step);
+        if (duration > 0) {
+          stb_mixlow_add_playback(const_cast<short *>(clip.samples.data()), frames, 1,
+                                  clip.channels, 0.0f, time, duration, step, STB_FADE_none, 0, 0,
+                                  playback.volume, playback.pan, nullptr);
+          playback.end = time + duration;
+          playbacks.push_back(std::move(playback));
+        }
+      }
+      starting.clear();
+      const auto mixed = static_cast<std::size_t>(
+          std::max(stb_mixlow_mix(block.data(), time, kBlockFrames), 0));
+      std::fill(block.begin() + 2 * mixed, block.end(), 0);
+      std::copy(block.begin(), block.end(), effects.begin());
+      if (!sources.empty()) {
+        std::fill(source_left.begin(), source_left.end(), 0.0f);
+        std::fill(source_right.begin(), source_right.end(), 0.0f);
+        for (const auto source : sources) {
+          source->Mix(source_left.data(), source_right.data(), kBlockFrames);
+        }
+        for (std::size_t i = 0; i < kBlockFrames; ++i) {
+          effects[2 * i] += source_left[i];
+          effects[2 * i + 1] += source_right[i];
+        }
+      }
+      const auto started = MixVoice(effects, block.data(), kBlockFrames);
+      const auto finished =
+          speaking && spoken == static_cast<std::size_t>(speaking->clip.frame_count());
+      time += kBlockFrames;
+      stb_mixlow_set_curtime(time);
+      playbacks.erase(std::remove_if(playbacks.begin(), playbacks.end(),
+                                     [time] (const Playback &playback) {
+                                       return playback.end <= time;
+                                     }), playbacks.end());
+      if (started || finished) {
+        const std::chrono::duration<double, std::milli> latency =
+            Clock::now() - speaking->requested;
+        lock.lock();
+        if (started) {
+          ++totals.utterances;
+          totals.latency += latency;
+          totals.maximum_latency = std::max(totals.maximum_latency, latency);
+        }
+        if (finished) {
+          voice_active = false;
+        }
+        lock.unlock();
+        if (finished) {
+          speaking.reset();
+        }
+      }
+      sink.Write(block.data(), kBlockFrames);
+      lock.lock();
+    }
+    lock.unlock();
+    playbacks.clear();
+    stb_mixlow_deinit();
+  }
+
+  void AudioEngine::SynthesisLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      synthesis_condition.wait(lock, [this] () {
+        return !running || !requests.empty();
+      });
+      if (!running) {
+        break;
+      }
+      auto utterance = std::move(requests.front());
+      requests.pop_front();
+      ++synthesizing;
+      lock.unlock();
+      const auto start = Clock::now();
+      auto synthesized = synthesizer.Synthesize(utterance.text, utterance.clip);
+      if (synthesized) {
+        Resample(utterance.clip, sink.sample_rate());
+        synthesized = utterance.clip.frame_count() > 0;
+      }
+      const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+      lock.lock();
+      --synthesizing;
+      if (synthesized) {
+        totals.synthesis += elapsed;
+        totals.maximum_synthesis = std::max(totals.maximum_synthesis, elapsed);
+        ready.push_back(std::move(utterance));
+        mix_condition.notify_one();
+      } else {
+        ++totals.failed;
+      }
+    }
+  }
+
+}  // namespace textengine
@@ -0,0 +1,115 @@
+#ifndef __textengine__audioengine__
+#define __textengine__audioengine__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audioclip.h"
+
+namespace textengine {
+
+  class AudioSink;
+  class AudioSource;
+  class SpeechSynthesizer;
+
+  /**
+   * Speaks text and plays clips in-process. One thread synthesizes queued utterances while
+   * another mixes, in blocks paced by the sink: clips through stb_audio_mixer on an effects bus,
+   * along with any added sources, and speech, one utterance after another, on a voice bus above
+   * it. While speech plays the effects bus is ducked so the speech stays intelligible.
+   *
+   * stb_audio_mixer keeps its state in globals, so only one engine may run at a time.
+   */
+  class AudioEngine {
+  public:
+    struct Statistics {
+      std::size_t utterances, dropped, failed;
+      std::chrono::duration<double, std::milli> synthesis, maximum_synthesis;
+
+      /** From Speak to the utterance's first sample being written to the sink. */
+      std::chrono::duration<double, std::milli> latency, maximum_latency;
+    };
+
+    AudioEngine(AudioSink &sink, SpeechSynthesizer &synthesizer);
+
+    virtual ~AudioEngine();
+
+    /**
+     * Mixes source into the effects bus. Must be called before Run.
+     */
+    void AddSource(AudioSource &source);
+
+    /**
+     * Plays clip on the effects bus, starting with the next block mixed.
+     */
+    void Play(std::shared_ptr<const AudioClip> clip, float volume = 1.0f, float pan = 0.0f);
+
+    void Run();
+
+    /**
+     * Queues text to be spoken after what is queued already. Speech that has waited behind too
+     * many later utterances is stale, so the oldest is dropped to make room.
+     */
+    void Speak(const std::string &text);
+
+    /**
+     * Whether any speech is waiting to be synthesized or played, or still playing.
+     */
+    bool busy() const;
+
+    Statistics statistics() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Utterance {
+      std::string text;
+      Clock::time_point requested;
+      AudioClip clip;
+    };
+
+    struct Playback {
+      std::shared_ptr<const AudioClip> clip;
+      float volume, pan;
+      unsigned int end;
+    };
+
+    /**
+     * Mixes the voice bus into block over the ducked effects already there, and returns whether
+     * an utterance started in it.
+     */
+    bool MixVoice(const std::vector<float> &effects, short *block, std::size_t frame_count);
+
+    void MixLoop();
+
+    void SynthesisLoop();
+
+  private:
+    AudioSink &sink;
+    SpeechSynthesizer &synthesizer;
+    std::vector<AudioSource *> sources;
+    float duck_attack, duck_release, effects_gain;
+    std::unique_ptr<Utterance> speaking;
+    std::size_t spoken;
+    std::vector<Playback> playbacks;
+
+    mutable std::mutex mutex;
+    std::condition_variable synthesis_condition, mix_condition;
+    std::deque<Utterance> requests, ready;
+    std::vector<Playback> pending;
+    std::size_t synthesizing;
+    Statistics totals;
+    bool voice_active, running;
+    std::thread synthesis_thread, mix_thread;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__audioengine__) */
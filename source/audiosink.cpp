@@ -0,0 +1,37 @@
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#include "audiosink.h"
+
+namespace textengine {
+
+  NullAudioSink::NullAudioSink(int sample_rate, bool paced)
+  : rate(sample_rate), paced(paced), frames(), start() {}
+
+  void NullAudioSink::Write(const short *, std::size_t frame_count) {
+    const auto previous = frames.fetch_add(frame_count);
+    if (!paced) {
+      return;
+    }
+    // Block until all but this write would have played, as a double-buffered device does. After
+    // an underrun the device would have restarted from silence, so the clock restarts too.
+    const auto now = std::chrono::steady_clock::now();
+    const auto due = start + std::chrono::microseconds(
+        previous * 1000000 / static_cast<std::size_t>(rate));
+    if (!previous || now > due) {
+      start += now - due;
+    } else {
+      std::this_thread::sleep_until(due);
+    }
+  }
+
+  int NullAudioSink::sample_rate() const {
+    return rate;
+  }
+
+  std::size_t NullAudioSink::frame_count() const {
+    return frames;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,53 @@
+#ifndef __textengine__audiosink__
+#define __textengine__audiosink__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "interface.h"
+
+namespace textengine {
+
+  /**
+   * Where mixed audio goes: interleaved signed 16-bit stereo at sample_rate.
+   */
+  class AudioSink {
+    DECLARE_INTERFACE(AudioSink);
+
+  public:
+    /**
+     * Queues frame_count frames, blocking while the sink already holds as much as it buffers, so
+     * that the caller is paced by playback.
+     */
+    virtual void Write(const short *samples, std::size_t frame_count) = 0;
+
+    virtual int sample_rate() const = 0;
+  };
+
+  /**
+   * Discards what it is given, for running without an audio device. When paced it blocks as a
+   * device would; otherwise it accepts audio as fast as it is mixed, which suits benchmarks.
+   */
+  class NullAudioSink : public AudioSink {
+  public:
+    NullAudioSink(int sample_rate, bool paced);
+
+    virtual ~NullAudioSink() = default;
+
+    virtual void Write(const short *samples, std::size_t frame_count) override;
+
+    virtual int sample_rate() const override;
+
+    std::size_t frame_count() const;
+
+  private:
+    int rate;
+    bool paced;
+    std::atomic<std::size_t> frames;
+    std::chrono::steady_clock::time_point start;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__audiosink__) */
@@ -0,0 +1,31 @@
+#ifndef __textengine__audiosource__
+#define __textengine__audiosource__
+
+#include <cstddef>
+
+#include "interface.h"
+
+namespace textengine {
+
+  /**
+   * Sound generated block by block on the audio engine's mixer thread, such as cues or ambience.
+   */
+  class AudioSource {
+    DECLARE_INTERFACE(AudioSource);
+
+  public:
+    /**
+     * Adds frame_count frames to left and right. Called only from the mixer thread, so it must
+     * neither block nor allocate.
+     */
+    virtual void Mix(float *left, float *right, std::size_t frame_count) = 0;
+
+    /**
+     * Whether the source has anything to mix, so that an idle engine can sleep. Any thread.
+     */
+    virtual bool active() const = 0;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__audiosource__) */
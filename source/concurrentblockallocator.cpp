@@ -0,0 +1,189 @@
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "concurrentblockallocator.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** The number of blocks moved between a thread's cache and the shared free lists at once. */
+    constexpr std::size_t kBatchSize = 64;
+
+    std::atomic<std::uint64_t> next_allocator_id(1);
+
+    // Allocators are told apart by id rather than address, since a new allocator may reuse the
+    // address of one that was destroyed. An exiting thread looks its allocators up here, under
+    // the lock, so that none is destroyed while the thread hands its caches back.
+    std::mutex live_allocators_mutex;
+    std::unordered_map<std::uint64_t, ConcurrentBlockAllocator *> live_allocators;
+
+  }  // namespace
+
+  /**
+   * The caches of one thread, by allocator id. Entries for allocators since destroyed are pruned
+   * whenever the thread adds a cache.
+   */
+  struct ThreadCaches {
+    ~ThreadCaches() {
+      std::lock_guard<std::mutex> lock(live_allocators_mutex);
+      for (const auto &entry : entries) {
+        const auto allocator = live_allocators.find(entry.first);
+        if (live_allocators.cend() != allocator) {
+          allocator->second->Release(static_cast<ConcurrentBlockAllocator::Cache *>(entry.second));
+        }
+      }
+    }
+
+    std::vector<std::pair<std::uint64_t, void *>> entries;
+  };
+
+  namespace {
+
+    // The last cache used is kept apart, where reaching it needs no check that it was
+    // constructed, since every allocation and free goes through it.
+    thread_local std::uint64_t last_allocator_id;
+    thread_local void *last_cache;
+    thread_local ThreadCaches local_caches;
+
+  }  // namespace
+
+  ConcurrentBlockAllocator::ConcurrentBlockAllocator()
+  : id(next_allocator_id++), mutex(), shared(), caches(), chunks() {
+    std::lock_guard<std::mutex> lock(live_allocators_mutex);
+    live_allocators.emplace(id, this);
+  }
+
+  ConcurrentBlockAllocator::~ConcurrentBlockAllocator() {
+    {
+      std::lock_guard<std::mutex> lock(live_allocators_mutex);
+      live_allocators.erase(id);
+    }
+    for (auto chunk : chunks) {
+      b2Free(chunk);
+    }
+  }
+
+  void *ConcurrentBlockAllocator::Allocate(int32 size) {
+    if (0 == size) {
+      return nullptr;
+    }
+    if (size > b2_maxBlockSize) {
+      return b2Alloc(size);
+    }
+    const auto index = s_blockSizeLookup[size];
+    auto &list = LocalCache().lists[index];
+    if (!list.head) {
+      Refill(list, index);
+    }
+    const auto block = list.head;
+    list.head = block->next;
+    --list.count;
+    return block;
+  }
+
+  void ConcurrentBlockAllocator::Free(void *p, int32 size) {
+    if (0 == size) {
+      return;
+    }
+    if (size > b2_maxBlockSize) {
+      b2Free(p);
+      return;
+    }
+    const auto index = s_blockSizeLookup[size];
+    auto &list = LocalCache().lists[index];
+    const auto block = static_cast<Block *>(p);
+    block->next = list.head;
+    list.head = block;
+    if (++list.count > 4 * kBatchSize) {
+      Spill(list, index);
+    }
+  }
+
+  ConcurrentBlockAllocator::Cache &ConcurrentBlockAllocator::LocalCache() {
+    if (id == last_allocator_id) {
+      return *static_cast<Cache *>(last_cache);
+    }
+    auto &entries = local_caches.entries;
+    const auto entry = std::find_if(entries.cbegin(), entries.cend(),
+                                    [this] (const std::pair<std::uint64_t, void *> &entry) {
+      return id == entry.first;
+    });
+    Cache *cache;
+    if (entries.cend() != entry) {
+      cache = static_cast<Cache *>(entry->second);
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(live_allocators_mutex);
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [] (const std::pair<std::uint64_t, void *> &entry) {
+          return live_allocators.cend() == live_allocators.find(entry.first);
+        }), entries.end());
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      caches.emplace_back(new Cache());
+      cache = caches.back().get();
+      entries.emplace_back(id, cache);
+    }
+    last_allocator_id = id;
+    last_cache = cache;
+    return *cache;
+  }
+
+  void ConcurrentBlockAllocator::Release(Cache *cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int32 index = 0; index < b2_blockSizes; ++index) {
+      Move(cache->lists[index], shared[index], cache->lists[index].count);
+    }
+    caches.erase(std::find_if(caches.begin(), caches.end(),
+                              [cache] (const std::unique_ptr<Cache> &owned) {
+      return cache == owned.get();
+    }));
+  }
+
+  void ConcurrentBlockAllocator::Refill(FreeList &list, int32 index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &from = shared[index];
+    if (!from.head) {
+      const auto block_size = s_blockSizes[index];
+      const auto chunk = static_cast<char *>(b2Alloc(b2_chunkSize));
+      chunks.push_back(chunk);
+      for (auto i = b2_chunkSize / block_size; i-- > 0;) {
+        const auto block = reinterpret_cast<Block *>(chunk + i * block_size);
+        block->next = from.head;
+        from.head = block;
+        ++from.count;
+      }
+    }
+    Move(from, list, std::min(kBatchSize, from.count));
+  }
+
+  void ConcurrentBlockAllocator::Spill(FreeList &list, int32 index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Move(list, shared[index], kBatchSize);
+  }
+
+  void ConcurrentBlockAllocator::Move(FreeList &from, FreeList &to, std::size_t count) {
+    if (!count) {
+      return;
+    }
+    const auto first = from.head;
+    auto last = first;
+    for (std::size_t i = 1; i < count; ++i) {
+      last = last->next;
+    }
+    from.head = last->next;
+    from.count -= count;
+    last->next = to.head;
+    to.head = first;
+    to.count += count;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,69 @@
+#ifndef __textengine__concurrentblockallocator__
+#define __textengine__concurrentblockallocator__
+
+#include <Box2D/Box2D.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace textengine {
+
+  /**
+   * A thread safe b2BlockAllocator with the same size classes. Each thread allocates from and
+   * frees to a cache of its own without locking; a cache refills from, and spills its excess to,
+   * shared free lists a batch at a time. A block may be freed on any thread, not just the one
+   * that allocated it. A thread's caches go back to the shared lists when the thread exits.
+   * Memory is returned to the system only when the allocator is destroyed.
+   */
+  class ConcurrentBlockAllocator : public b2BlockAllocator {
+  public:
+    ConcurrentBlockAllocator();
+
+    virtual ~ConcurrentBlockAllocator();
+
+    virtual void *Allocate(int32 size) override;
+
+    virtual void Free(void *p, int32 size) override;
+
+  private:
+    struct Block {
+      Block *next;
+    };
+
+    struct FreeList {
+      Block *head;
+      std::size_t count;
+    };
+
+    struct Cache {
+      FreeList lists[b2_blockSizes];
+    };
+
+    friend struct ThreadCaches;
+
+    Cache &LocalCache();
+
+    /**
+     * Moves every block in cache to the shared lists and frees the cache, for a thread that exits.
+     */
+    void Release(Cache *cache);
+
+    void Refill(FreeList &list, int32 index);
+
+    void Spill(FreeList &list, int32 index);
+
+    static void Move(FreeList &from, FreeList &to, std::size_t count);
+
+  private:
+    const std::uint64_t id;
+    std::mutex mutex;
+    FreeList shared[b2_blockSizes];
+    std::vector<std::unique_ptr<Cache>> caches;
+    std::vector<void *> chunks;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__concurrentblockallocator__) */
@@ -0,0 +1,121 @@
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "checks.h"
+#include "contactbenchmark.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr float kTimeStep = 1.0f / 60.0f;
+    constexpr float kGravity = -10.0f;
+    constexpr float kPileSpacing = 3.0f;
+    constexpr float kHalfSize = 0.5f;
+
+    /** Every third body in a pile is a circle, so both manifold widths are solved. */
+    constexpr std::size_t kCircleEvery = 3;
+
+    /**
+     * Batching changes the order contacts are solved in, which moves results by about 1e-3 m/s
+     * in a step; a larger difference means the wide solver computed something else.
+     */
+    constexpr float kVelocityTolerance = 5e-3f;
+    constexpr float kPositionTolerance = kVelocityTolerance * kTimeStep;
+
+  }  // namespace
+
+  ContactBenchmark::ContactBenchmark(std::size_t pile_count, std::size_t pile_height,
+                                     const PhysicsSettings &settings)
+  : pile_count(pile_count), pile_height(pile_height), settings(settings) {}
+
+  ContactBenchmark::Comparison ContactBenchmark::Compare(std::size_t settle_step_count) {
+    auto scalar = CreateWorld(), wide = CreateWorld();
+    for (std::size_t step = 0; step < settle_step_count; ++step) {
+      scalar->Step(kTimeStep, settings.velocity_iterations, settings.position_iterations);
+      wide->Step(kTimeStep, settings.velocity_iterations, settings.position_iterations);
+    }
+    wide->SetWideContactSolving(true);
+    scalar->Step(kTimeStep, settings.velocity_iterations, settings.position_iterations);
+    wide->Step(kTimeStep, settings.velocity_iterations, settings.position_iterations);
+    Comparison comparison{0, 0.0f, 0.0f, 0.0f};
+    // Both worlds were built in the same order, so their body lists pair up.
+    for (auto a = scalar->GetBodyList(), b = wide->GetBodyList(); a && b;
+         a = a->GetNext(), b = b->GetNext()) {
+      ++comparison.body_count;
+      comparison.maximum_speed = std::max(comparison.maximum_speed,
+                                          a->GetLinearVelocity().Length());
+      comparison.velocity_difference = std::max(comparison.velocity_difference,
+                                                (a->GetLinearVelocity()
+                                                 - b->GetLinearVelocity()).Length());
+      comparison.position_difference = std::max(
+          comparison.position_difference, (a->GetPosition() - b->GetPosition()).Length());
+    }
+    CHECK_STATE(comparison.velocity_difference <= kVelocityTolerance);
+    CHECK_STATE(comparison.position_difference <= kPositionTolerance);
+    return comparison;
+  }
+
+  std::vector<ContactBenchmark::Result> ContactBenchmark::Run(std::size_t step_count) {
+    std::vector<Result> results;
+    for (const auto wide : {false, true}) {
+      auto world = CreateWorld();
+      world->SetWideContactSolving(wide);
+      Result result{wide ? "wide" : "scalar", 0, 0.0f, {}, {}};
+      for (std::size_t step = 0; step < step_count; ++step) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        world->Step(kTimeStep, settings.velocity_iterations, settings.position_iterations);
+        result.step += std::chrono::high_resolution_clock::now() - start;
+        result.solve_velocity += std::chrono::duration<double, std::milli>(
+            world->GetProfile().solveVelocity);
+      }
+      result.step /= step_count;
+      result.solve_velocity /= step_count;
+      result.contact_count = world->GetContactCount();
+      std::size_t body_count = 0;
+      for (auto body = world->GetBodyList(); body; body = body->GetNext()) {
+        if (b2_dynamicBody == body->GetType()) {
+          result.mean_height += body->GetPosition().y;
+          ++body_count;
+        }
+      }
+      result.mean_height /= std::max<std::size_t>(body_count, 1);
+      results.push_back(result);
+    }
+    return results;
+  }
+
+  std::unique_ptr<b2World> ContactBenchmark::CreateWorld() const {
+    std::unique_ptr<b2World> world(new b2World(b2Vec2(0.0f, kGravity)));
+    // Sleeping piles would skip the solver being measured.
+    world->SetAllowSleeping(false);
+    b2BodyDef ground_definition;
+    b2PolygonShape ground_shape;
+    ground_shape.SetAsBox(kPileSpacing * pile_count, 1.0f);
+    world->CreateBody(&ground_definition)->CreateFixture(&ground_shape, 0.0f);
+    b2PolygonShape box;
+    box.SetAsBox(kHalfSize, kHalfSize);
+    b2CircleShape circle;
+    circle.m_radius = kHalfSize;
+    for (std::size_t pile = 0; pile < pile_count; ++pile) {
+      for (std::size_t level = 0; level < pile_height; ++level) {
+        b2BodyDef definition;
+        definition.type = b2_dynamicBody;
+        // Alternate levels are offset so the piles lean and keep moving while they settle.
+        definition.position.Set(pile * kPileSpacing + (level % 2) * 0.1f,
+                                1.0f + kHalfSize + level * 2.1f * kHalfSize);
+        b2FixtureDef fixture;
+        fixture.shape = level % kCircleEvery ? static_cast<b2Shape *>(&box) : &circle;
+        fixture.density = 1.0f;
+        fixture.friction = 0.6f;
+        world->CreateBody(&definition)->CreateFixture(&fixture);
+      }
+    }
+    return world;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,57 @@
+#ifndef __textengine__contactbenchmark__
+#define __textengine__contactbenchmark__
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gamestate.h"
+
+namespace textengine {
+
+  /**
+   * Compares Box2D's scalar contact solver with the wide one that PhysicsSettings can enable, on
+   * piles of boxes and circles stacked under gravity on a shared ground.
+   */
+  class ContactBenchmark {
+  public:
+    /** The largest differences after one step of each solver from an identical state. */
+    struct Comparison {
+      std::size_t body_count;
+      float maximum_speed, velocity_difference, position_difference;
+    };
+
+    struct Result {
+      std::string solver;
+      int contact_count;
+      float mean_height;
+
+      /** Mean time per step, and the part of it spent in the velocity iterations. */
+      std::chrono::duration<double, std::milli> step, solve_velocity;
+    };
+
+    ContactBenchmark(std::size_t pile_count, std::size_t pile_height,
+                     const PhysicsSettings &settings = PhysicsSettings());
+
+    virtual ~ContactBenchmark() = default;
+
+    /**
+     * Settles two identical worlds with the scalar solver, then steps one of them once more with
+     * each solver. Fails if the results differ by more than the wide solver's reordering explains.
+     */
+    Comparison Compare(std::size_t settle_step_count);
+
+    std::vector<Result> Run(std::size_t step_count);
+
+  private:
+    std::unique_ptr<b2World> CreateWorld() const;
+
+    std::size_t pile_count, pile_height;
+    PhysicsSettings settings;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__contactbenchmark__) */
@@ -0,0 +1,228 @@
+#define STB_DEFINE
+#include <stb_synth.h>
+#undef STB_DEFINE
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "checks.h"
+#include "cuemixer.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr std::size_t kCueCount = 10;
+    constexpr float kPentatonic[] = {0.0f, 2.0f, 4.0f, 7.0f, 9.0f};
+    constexpr float kLowestPitch = 60.0f;
+
+    /** Peak level of one cue at full gain; many sound at once, so each is quiet. */
+    constexpr float kCueAmplitude = 0.15f * 32767.0f;
+    constexpr float kNoteSeconds = 0.12f;
+
+    /** Cues repeat at slightly different periods so that they do not fall into step. */
+    constexpr float kLoopSeconds = 0.5f;
+    constexpr float kLoopSecondsStep = 0.07f;
+
+    /** Changes smaller than this are not worth a command. */
+    constexpr float kEpsilon = 1e-3f;
+
+    /**
+     * Adds samples to left and right with gains that start at left_gain and right_gain and
+     * change by left_step and right_step each frame, four frames at a time if vectorized.
+     */
+    void MixSegment(bool vectorized, const float *samples, std::size_t count, float left_gain,
+                    float left_step, float right_gain, float right_step, float *left,
+                    float *right) {
+      std::size_t i = 0;
+#if defined(__SSE__)
+      const auto offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+      auto left_gains = _mm_add_ps(_mm_set1_ps(left_gain),
+                                   _mm_mul_ps(_mm_set1_ps(left_step), offsets));
+      auto right_gains = _mm_add_ps(_mm_set1_ps(right_gain),
+                                    _mm_mul_ps(_mm_set1_ps(right_step), offsets));
+      const auto left_steps = _mm_set1_ps(4.0f * left_step);
+      const auto right_steps = _mm_set1_ps(4.0f * right_step);
+      for (; vectorized && i + 4 <= count; i += 4) {
+        const auto sample = _mm_loadu_ps(samples + i);
+        _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(sample, left_gains)));
+        _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i),
+                                            _mm_mul_ps(sample, right_gains)));
+        left_gains = _mm_add_ps(left_gains, left_steps);
+        right_gains = _mm_add_ps(right_gains, right_steps);
+      }
+#elif defined(__ARM_NEON)
+      const float offsets[] = {0.0f, 1.0f, 2.0f, 3.0f};
+      auto left_gains = vmlaq_n_f32(vdupq_n_f32(left_gain), vld1q_f32(offsets), left_step);
+      auto right_gains = vmlaq_n_f32(vdupq_n_f32(right_gain), vld1q_f32(offsets), right_step);
+      const auto left_steps = vdupq_n_f32(4.0f * left_step);
+      const auto right_steps = vdupq_n_f32(4.0f * right_step);
+      for (; vectorized && i + 4 <= count; i += 4) {
+        const auto sample = vld1q_f32(samples + i);
+        vst1q_f32(left + i, vmlaq_f32(vld1q_f32(left + i), sample, left_gains));
+        vst1q_f32(right + i, vmlaq_f32(vld1q_f32(right + i), sample, right_gains));
+        left_gains = vaddq_f32(left_gains, left_steps);
+        right_gains = vaddq_f32(right_gains, right_steps);
+      }
+#endif
+      for (; i < count; ++i) {
+        left[i] += samples[i] * (left_gain + i * left_step);
+        right[i] += samples[i] * (right_gain + i * right_step);
+      }
+    }
+
+  }  // namespace
+
+  CueMixer::CueMixer(int sample_rate, std::size_t voice_capacity, bool vectorized)
+  : cues(kCueCount), vectorized(vectorized), emitters(), free_voices(), commands(),
+    voices(voice_capacity), active_voices(), sounding() {
+    CHECK_STATE(voice_capacity > 0);
+    stb_synth_waveform triangle = {0.0f, 0.5f, 0.0f, 0};
+    stb_synth_waveform saw = {0.0f, 0.0f, 0.0f, 1};
+    stb_synth_adsr envelope = {0.005f, 0.08f, 0.4f, 0.15f};
+    for (std::size_t i = 0; i < kCueCount; ++i) {
+      auto &cue = cues[i];
+      cue.resize(static_cast<std::size_t>((kLoopSeconds + i * kLoopSecondsStep) * sample_rate));
+      const auto pitch = kLowestPitch + 12.0f * (i / 5) + kPentatonic[i % 5];
+      stb_synth(cue.data(), static_cast<int>(cue.size()), sample_rate, kNoteSeconds, pitch,
+                kCueAmplitude, &envelope, i % 2 ? &saw : &triangle, nullptr);
+    }
+    for (auto voice = static_cast<std::uint32_t>(voice_capacity); voice > 0; --voice) {
+      free_voices.push_back(voice - 1);
+    }
+    active_voices.reserve(voice_capacity);
+  }
+
+  bool CueMixer::Emit(long key, float gain, float pan) {
+    const auto found = emitters.find(key);
+    if (emitters.cend() == found) {
+      if (free_voices.empty() || !Send(CommandType::kStart, free_voices.back(), key, gain, pan)) {
+        return false;
+      }
+      emitters.emplace(key, Emitter{free_voices.back(), gain, pan, true});
+      free_voices.pop_back();
+      return true;
+    }
+    auto &emitter = found->second;
+    emitter.emitted = true;
+    if ((std::abs(gain - emitter.gain) > kEpsilon || std::abs(pan - emitter.pan) > kEpsilon)
+        && Send(CommandType::kUpdate, emitter.voice, key, gain, pan)) {
+      emitter.gain = gain;
+      emitter.pan = pan;
+    }
+    return true;
+  }
+
+  void CueMixer::End() {
+    for (auto emitter = emitters.begin(); emitters.end() != emitter;) {
+      if (emitter->second.emitted) {
+        emitter->second.emitted = false;
+        ++emitter;
+      } else if (Send(CommandType::kStop, emitter->second.voice, emitter->first, 0.0f, 0.0f)) {
+        free_voices.push_back(emitter->second.voice);
+        emitter = emitters.erase(emitter);
+      } else {
+        ++emitter;
+      }
+    }
+  }
+
+  void CueMixer::Mix(float *left, float *right, std::size_t frame_count) {
+    Command command;
+    while (commands.TryPop(command)) {
+      Apply(command);
+    }
+    const auto ramp = 1.0f / frame_count;
+    for (std::size_t i = 0; i < active_voices.size();) {
+      auto &voice = voices[active_voices[i]];
+      const auto &cue = *voice.cue;
+      const auto left_step = (voice.target_left - voice.left) * ramp;
+      const auto right_step = (voice.target_right - voice.right) * ramp;
+      auto left_gain = voice.left, right_gain = voice.right;
+      for (std::size_t mixed = 0; mixed < frame_count;) {
+        const auto count = std::min(frame_count - mixed, cue.size() - voice.position);
+        MixSegment(vectorized, cue.data() + voice.position, count, left_gain, left_step,
+                   right_gain, right_step, left + mixed, right + mixed);
+        left_gain += count * left_step;
+        right_gain += count * right_step;
+        voice.position = (voice.position + count) % cue.size();
+        mixed += count;
+      }
+      voice.left = voice.target_left;
+      voice.right = voice.target_right;
+      if (voice.stopping) {
+        Deactivate(active_voices[i]);
+      } else {
+        ++i;
+      }
+    }
+    sounding.store(active_voices.size(), std::memory_order_relaxed);
+  }
+
+  bool CueMixer::active() const {
+    return sounding.load(std::memory_order_relaxed) || !commands.empty();
+  }
+
+  std::size_t CueMixer::active_voice_count() const {
+    return sounding.load(std::memory_order_relaxed);
+  }
+
+  std::size_t CueMixer::cue_count() const {
+    return cues.size();
+  }
+
+  void CueMixer::Apply(const Command &command) {
+    auto &voice = voices[command.voice];
+    switch (command.type) {
+      case CommandType::kStart:
+        if (!voice.cue) {
+          // A voice still fading out already has a place in the active list.
+          voice.active_index = static_cast<std::uint32_t>(active_voices.size());
+          active_voices.push_back(command.voice);
+        }
+        voice.cue = &cues[command.cue];
+        // Start voices of the same cue at different points so they do not sound in unison.
+        voice.position = (command.voice * 7919) % voice.cue->size();
+        voice.left = voice.right = 0.0f;
+        voice.target_left = command.left;
+        voice.target_right = command.right;
+        voice.stopping = false;
+        break;
+      case CommandType::kUpdate:
+        voice.target_left = command.left;
+        voice.target_right = command.right;
+        break;
+      case CommandType::kStop:
+        voice.target_left = voice.target_right = 0.0f;
+        voice.stopping = true;
+        break;
+    }
+  }
+
+  void CueMixer::Deactivate(std::uint32_t voice) {
+    const auto index = voices[voice].active_index;
+    active_voices[index] = active_voices.back();
+    voices[active_voices[index]].active_index = index;
+    active_voices.pop_back();
+    voices[voice].stopping = false;
+    voices[voice].cue = nullptr;
+  }
+
+  bool CueMixer::Send(CommandType type, std::uint32_t voice, long key, float gain, float pan) {
+    // Equal-power panning keeps a cue's loudness steady as it moves across.
+    const auto angle =
+        (std::min(std::max(pan, -1.0f), 1.0f) + 1.0f) * static_cast<float>(M_PI) / 4.0f;
+    const auto cue = static_cast<std::uint32_t>(static_cast<unsigned long>(key) % cues.size());
+    return commands.TryPush(
+        Command{type, voice, cue, gain * std::cos(angle), gain * std::sin(angle)});
+  }
+
+}  // namespace textengine
@@ -0,0 +1,108 @@
+#ifndef __textengine__cuemixer__
+#define __textengine__cuemixer__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "audiosource.h"
+#include "spscqueue.h"
+
+namespace textengine {
+
+  /**
+   * Mixes looping procedural cues, one voice per sounding item, for the audio engine's effects
+   * bus. The cues are synthesized once with stb_synth.
+   *
+   * Each tick the simulation thread calls Emit for every audible item and then End, and voices
+   * whose item was not emitted fade out. Only changes cross to the mixer, through a lock-free
+   * queue, so the simulation never waits on audio. A change that does not fit is retried on the
+   * next tick.
+   *
+   * Gains ramp across each block to avoid zipper noise, and the inner loop mixes four frames at
+   * a time with SSE or NEON unless vectorized is false, which is there for comparison.
+   */
+  class CueMixer : public AudioSource {
+  public:
+    CueMixer(int sample_rate, std::size_t voice_capacity, bool vectorized = true);
+
+    virtual ~CueMixer() = default;
+
+    /**
+     * Sounds the cue for key at gain, from 0 to 1, panned from -1 at left to 1 at right. Returns
+     * false if no voice is free. Simulation thread only.
+     */
+    bool Emit(long key, float gain, float pan);
+
+    /**
+     * Finishes a tick, silencing keys not emitted since the last End. Simulation thread only.
+     */
+    void End();
+
+    virtual void Mix(float *left, float *right, std::size_t frame_count) override;
+
+    /**
+     * Whether any voice sounds or any change waits to be mixed.
+     */
+    virtual bool active() const override;
+
+    std::size_t active_voice_count() const;
+
+    std::size_t cue_count() const;
+
+  private:
+    enum class CommandType : std::uint8_t {
+      kStart,
+      kUpdate,
+      kStop
+    };
+
+    struct Command {
+      CommandType type;
+      std::uint32_t voice, cue;
+      float left, right;
+    };
+
+    struct Emitter {
+      std::uint32_t voice;
+      float gain, pan;
+      bool emitted;
+    };
+
+    struct Voice {
+      const std::vector<float> *cue;
+      std::size_t position;
+      float left, right, target_left, target_right;
+      std::uint32_t active_index;
+      bool stopping;
+    };
+
+    static constexpr std::size_t kCommandCapacity = 4096;
+
+    void Apply(const Command &command);
+
+    void Deactivate(std::uint32_t voice);
+
+    bool Send(CommandType type, std::uint32_t voice, long key, float gain, float pan);
+
+  private:
+    std::vector<std::vector<float>> cues;
+    bool vectorized;
+
+    // Simulation side.
+    std::unordered_map<long, Emitter> emitters;
+    std::vector<std::uint32_t> free_voices;
+
+    SpscQueue<Command, kCommandCapacity> commands;
+
+    // Mixer side.
+    std::vector<Voice> voices;
+    std::vector<std::uint32_t> active_voices;
+    std::atomic<std::size_t> sounding;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__cuemixer__) */
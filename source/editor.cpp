@@ -8,7 +8,6 @@
 #include <iostream>
 #include <limits>
 #include <memory>
-#include <unordered_set>
 
 #include "editor.h"
 #include "keyboard.h"
@@ -22,21 +21,22 @@ namespace textengine {
   : width(width), height(height), current_state(initial_state), keyboard(keyboard), mouse(mouse),
   scene(scene), start(), stop(), moving(), naming(), ready(), placing() {
     keyboard.AddKeyDownListener([this] (int key) {
-      if (naming && current_state.selected_item) {
+      const auto description = this->scene.FindDescription(current_state.selected_item);
+      if (naming && description) {
         if (GLFW_KEY_A <= key && key <= GLFW_KEY_Z) {
-          current_state.selected_item->name += static_cast<char>(key - GLFW_KEY_A) + 'a';
+          description->name += static_cast<char>(key - GLFW_KEY_A) + 'a';
         }
         if (GLFW_KEY_0 <= key && key <= GLFW_KEY_9) {
-          current_state.selected_item->name += static_cast<char>(key - GLFW_KEY_0) + '0';
+          description->name += static_cast<char>(key - GLFW_KEY_0) + '0';
         }
         if (GLFW_KEY_SPACE == key) {
-          current_state.selected_item->name += ' ';
+          description->name += ' ';
         }
         if (GLFW_KEY_MINUS == key) {
-          current_state.selected_item->name += '-';
+          description->name += '-';
         }
-        if (GLFW_KEY_BACKSPACE == key && current_state.selected_item->name.size()) {
-          current_state.selected_item->name.resize(current_state.selected_item->name.size() - 1);
+        if (GLFW_KEY_BACKSPACE == key && description->name.size()) {
+          description->name.resize(description->name.size() - 1);
         }
       }
     });
@@ -68,6 +68,8 @@ namespace textengine {
 
   void Editor::Update() {
     ready = !(moving || naming || placing);
+    // A body is rebuilt only when an item's shape, kind or size changes; moves just reposition it.
+    auto geometry_changed = false, moved = false;
     const auto d = keyboard.IsKeyDown(GLFW_KEY_LEFT_SHIFT) ? 1.0 : 0.25;
     const auto dx = glm::vec2(d, 0) / current_state.zoom;
     const auto dy = glm::vec2(0, d) / current_state.zoom;
@@ -85,54 +87,50 @@ namespace textengine {
     }
     if (ready && keyboard.GetKeyVelocity(GLFW_KEY_Q) > 0) {
       current_state.selected_item = scene.AddArea();
+      geometry_changed = true;
     }
     if (ready && keyboard.GetKeyVelocity(GLFW_KEY_E) > 0) {
       current_state.selected_item = scene.AddObject();
+      geometry_changed = true;
     }
     if (ready && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_ENTER) > 0) {
       naming = true;
-      current_state.selected_item->name.clear();
+      scene.FindDescription(current_state.selected_item)->name.clear();
     } else if (naming && keyboard.GetKeyVelocity(GLFW_KEY_ENTER) > 0) {
       naming = false;
     }
     if (!naming && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_SPACE) > 0) {
-      if (Shape::kAxisAlignedBoundingBox == current_state.selected_item->shape) {
-        current_state.selected_item->shape = Shape::kCircle;
+      auto selected_item = scene.Find(current_state.selected_item);
+      if (Shape::kAxisAlignedBoundingBox == selected_item->shape) {
+        selected_item->shape = Shape::kCircle;
       } else {
-        current_state.selected_item->shape = Shape::kAxisAlignedBoundingBox;
+        selected_item->shape = Shape::kAxisAlignedBoundingBox;
       }
+      geometry_changed = true;
     }
     if (!naming && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_T) > 0) {
-      auto removal_criterion = [&] (const std::unique_ptr<Object> &p) {
-        return current_state.selected_item == p.get();
-      };
-      auto area = std::find_if(scene.areas.begin(), scene.areas.end(), removal_criterion);
-      auto object = std::find_if(scene.objects.begin(), scene.objects.end(), removal_criterion);
-      if (scene.areas.end() == area) {
-        scene.areas.emplace_back(object->release());
-        scene.objects.erase(object);
+      if (scene.IsArea(current_state.selected_item)) {
+        scene.SetKind(current_state.selected_item, Kind::kObject);
       } else {
-        scene.objects.emplace_back(area->release());
-        scene.areas.erase(area);
+        scene.SetKind(current_state.selected_item, Kind::kArea);
       }
+      geometry_changed = true;
     }
     if (ready && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_R) > 0) {
-      auto old_selected_item = current_state.selected_item;
-      auto removal_criterion = [&] (const std::unique_ptr<Object> &p) {
-        return current_state.selected_item == p.get();
-      };
-      auto area = std::find_if(scene.areas.begin(), scene.areas.end(), removal_criterion);
-      if (scene.areas.end() == area) {
-        current_state.selected_item = scene.AddObject();
-      } else {
+      const auto old_selected_item = *scene.Find(current_state.selected_item);
+      if (scene.IsArea(current_state.selected_item)) {
         current_state.selected_item = scene.AddArea();
+      } else {
+        current_state.selected_item = scene.AddObject();
       }
-      current_state.selected_item->aabb = old_selected_item->aabb;
-      current_state.selected_item->invisible = old_selected_item->invisible;
-      current_state.selected_item->shape = old_selected_item->shape;
+      auto selected_item = scene.Find(current_state.selected_item);
+      selected_item->aabb = old_selected_item.aabb;
+      selected_item->invisible = old_selected_item.invisible;
+      selected_item->shape = old_selected_item.shape;
       moving = true;
-      aabb = current_state.selected_item->aabb;
+      aabb = selected_item->aabb;
       delta = aabb.minimum - GetCursorPosition();
+      geometry_changed = true;
     }
     if (ready && current_state.selected_item && mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_1) > 0) {
       placing = true;
@@ -140,24 +138,18 @@ namespace textengine {
     }
     if (ready && mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_2)) {
       const auto cursor = GetCursorPosition();
-      std::unordered_set<Object *> candidates;
+      auto minimum = std::numeric_limits<float>::infinity();
+      Handle argmin{};
       for (auto &area : scene.areas) {
-        if (area->Contains(cursor)) {
-          candidates.insert(area.get());
+        if (area.Contains(cursor) && area.area() < minimum) {
+          minimum = area.area();
+          argmin = scene.areas.handle(area);
         }
       }
       for (auto &object : scene.objects) {
-        if (object->Contains(cursor)) {
-          candidates.insert(object.get());
-        }
-      }
-      auto minimum = std::numeric_limits<float>::infinity();
-      Object *argmin = nullptr;
-      for (auto candidate : candidates) {
-        const auto area = candidate->area();
-        if (area < minimum) {
-          minimum = area;
-          argmin = candidate;
+        if (object.Contains(cursor) && object.area() < minimum) {
+          minimum = object.area();
+          argmin = scene.objects.handle(object);
         }
       }
       if (argmin) {
@@ -165,39 +157,50 @@ namespace textengine {
       }
     }
     if (ready && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_BACKSPACE) > 0) {
+      current_state.DestroyBody(current_state.selected_item);
       scene.EraseItem(current_state.selected_item);
-      current_state.selected_item = nullptr;
+      current_state.selected_item = Handle{};
     }
-    if (ready && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_G) > 0) {
+    const auto selected_item = scene.Find(current_state.selected_item);
+    if (ready && selected_item && keyboard.GetKeyVelocity(GLFW_KEY_G) > 0) {
       moving = true;
-      aabb = current_state.selected_item->aabb;
+      aabb = selected_item->aabb;
       delta = aabb.minimum - GetCursorPosition();
     }
-    if (moving && current_state.selected_item) {
-      const auto position = GetCursorPosition();
-      current_state.selected_item->aabb.minimum = position + delta;
-      current_state.selected_item->aabb.maximum = position + delta + aabb.extent();
+    if (moving && selected_item) {
+      const auto minimum = GetCursorPosition() + delta;
+      moved = minimum != selected_item->aabb.minimum;
+      selected_item->aabb.minimum = minimum;
+      selected_item->aabb.maximum = minimum + aabb.extent();
     }
     if (moving && keyboard.GetKeyVelocity(GLFW_KEY_ESCAPE) > 0) {
       moving = false;
-      current_state.selected_item->aabb = aabb;
+      selected_item->aabb = aabb;
+      moved = true;
     }
     if (moving && mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_1) > 0) {
       moving = false;
     }
-    if (!naming && current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_V) > 0) {
-      current_state.selected_item->invisible = !current_state.selected_item->invisible;
+    if (!naming && selected_item && keyboard.GetKeyVelocity(GLFW_KEY_V) > 0) {
+      selected_item->invisible = !selected_item->invisible;
     }
-    if (placing && current_state.selected_item) {
+    // The size changes with every step of the drag, so the body waits for the button's release.
+    if (placing && selected_item) {
       stop = GetCursorPosition();
-      current_state.selected_item->aabb.minimum = glm::min(start, stop);
-      current_state.selected_item->aabb.maximum = glm::max(start, stop);
+      selected_item->aabb.minimum = glm::min(start, stop);
+      selected_item->aabb.maximum = glm::max(start, stop);
     }
-    if (placing && current_state.selected_item && mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_1) < 0) {
+    if (placing && selected_item && mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_1) < 0) {
       placing = false;
       stop = GetCursorPosition();
-      current_state.selected_item->aabb.minimum = glm::min(start, stop);
-      current_state.selected_item->aabb.maximum = glm::max(start, stop);
+      selected_item->aabb.minimum = glm::min(start, stop);
+      selected_item->aabb.maximum = glm::max(start, stop);
+      geometry_changed = true;
+    }
+    if (geometry_changed) {
+      current_state.CreateBody(scene, current_state.selected_item);
+    } else if (moved) {
+      current_state.MoveBody(scene, current_state.selected_item);
     }
     if (!naming && keyboard.IsKeyDown(GLFW_KEY_MINUS)) {
       current_state.zoom *= 0.9;
@@ -210,44 +213,44 @@ namespace textengine {
     }
     constexpr auto kMultiplier = 1.25;
     if (!naming) {
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_SLASH) > 0) {
-        current_state.selected_item->base_attenuation *= -1.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_SLASH) > 0) {
+        selected_item->base_attenuation *= -1.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_7) > 0) {
-        current_state.selected_item->base_attenuation = 1.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_7) > 0) {
+        selected_item->base_attenuation = 1.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_U) > 0) {
-        current_state.selected_item->base_attenuation *= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_U) > 0) {
+        selected_item->base_attenuation *= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_J) > 0) {
-        current_state.selected_item->base_attenuation /= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_J) > 0) {
+        selected_item->base_attenuation /= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_M) > 0) {
-        current_state.selected_item->base_attenuation = 0.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_M) > 0) {
+        selected_item->base_attenuation = 0.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_8) > 0) {
-        current_state.selected_item->linear_attenuation = 1.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_8) > 0) {
+        selected_item->linear_attenuation = 1.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_I) > 0) {
-        current_state.selected_item->linear_attenuation *= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_I) > 0) {
+        selected_item->linear_attenuation *= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_K) > 0) {
-        current_state.selected_item->linear_attenuation /= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_K) > 0) {
+        selected_item->linear_attenuation /= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_COMMA) > 0) {
-        current_state.selected_item->linear_attenuation = 0.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_COMMA) > 0) {
+        selected_item->linear_attenuation = 0.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_9) > 0) {
-        current_state.selected_item->quadratic_attenuation = 1.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_9) > 0) {
+        selected_item->quadratic_attenuation = 1.0;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_O) > 0) {
-        current_state.selected_item->quadratic_attenuation *= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_O) > 0) {
+        selected_item->quadratic_attenuation *= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_L) > 0) {
-        current_state.selected_item->quadratic_attenuation /= kMultiplier;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_L) > 0) {
+        selected_item->quadratic_attenuation /= kMultiplier;
       }
-      if (current_state.selected_item && keyboard.GetKeyVelocity(GLFW_KEY_PERIOD) > 0) {
-        current_state.selected_item->quadratic_attenuation = 0.0;
+      if (selected_item && keyboard.GetKeyVelocity(GLFW_KEY_PERIOD) > 0) {
+        selected_item->quadratic_attenuation = 0.0;
       }
     }
   }
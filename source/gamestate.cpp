@@ -1,18 +1,106 @@
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <chrono>
 #include <glm/glm.hpp>
 #include <memory>
+#include <numeric>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include "drawable.h"
 #include "gamestate.h"
+#include "metrics.h"
+#include "profiler.h"
 #include "scene.h"
+#include "threadpool.h"
 
 namespace textengine {
 
-  GameState::GameState(Scene &scene)
+  namespace {
+
+    class ThreadPoolTaskExecutor : public b2TaskExecutor {
+    public:
+      ThreadPoolTaskExecutor(ThreadPool &pool) : pool(pool) {}
+
+      virtual ~ThreadPoolTaskExecutor() = default;
+
+      virtual int32 GetWorkerCount() const override {
+        return static_cast<int32>(pool.size());
+      }
+
+      virtual void Run(b2Task *task, int32 count) override {
+        pool.ParallelFor(count, 1, [task] (std::size_t begin, std::size_t end,
+                                           std::size_t worker) {
+          task->Execute(static_cast<int32>(begin), static_cast<int32>(end),
+                        static_cast<int32>(worker));
+        });
+      }
+
+    private:
+      ThreadPool &pool;
+    };
+
+    /** The number of rays or boxes a solver thread takes at once. */
+    constexpr std::size_t kQueryGrain = 64;
+
+    class ClosestHitCallback : public b2RayCastCallback {
+    public:
+      ClosestHitCallback(RayHit &hit) : hit(hit) {}
+
+      virtual ~ClosestHitCallback() = default;
+
+      virtual float32 ReportFixture(b2Fixture *fixture, const b2Vec2 &point,
+                                    const b2Vec2 &normal, float32 fraction) override {
+        const auto item = Handle::FromUserData(fixture->GetUserData());
+        if (!item || fixture->IsSensor()) {
+          return -1.0f;
+        }
+        hit = RayHit{item, glm::vec2(point.x, point.y), glm::vec2(normal.x, normal.y), fraction};
+        return fraction;
+      }
+
+    private:
+      RayHit &hit;
+    };
+
+    class OverlapCallback : public b2QueryCallback {
+    public:
+      OverlapCallback(const b2AABB &bounds, std::vector<Handle> &items)
+      : bounds(bounds), items(items) {}
+
+      virtual ~OverlapCallback() = default;
+
+      virtual bool ReportFixture(b2Fixture *fixture) override {
+        const auto item = Handle::FromUserData(fixture->GetUserData());
+        if (item && b2TestOverlap(fixture->GetAABB(0), bounds)) {
+          items.push_back(item);
+        }
+        return true;
+      }
+
+    private:
+      const b2AABB &bounds;
+      std::vector<Handle> &items;
+    };
+
+  }  // namespace
+
+  GameState::GameState(Scene &scene, bool create_bodies, const PhysicsSettings &settings)
   : camera_position(), previous_player_position(), accrued_distance(), zoom(1.0),
-    world(b2Vec2(0.0f, 0.0f)), player_body(), selected_item() {
+    allocator(), world(b2Vec2(0.0f, 0.0f), &allocator), player_body(), selected_item(),
+    settings(settings), step_statistics(), tree_statistics(), solver_pool(), solver_executor() {
+    const auto solver_threads = settings.solver_threads
+        ? settings.solver_threads : std::max(std::thread::hardware_concurrency(), 1u);
+    if (solver_threads > 1) {
+      solver_pool.reset(new ThreadPool(solver_threads));
+      solver_executor.reset(new ThreadPoolTaskExecutor(*solver_pool));
+      world.SetTaskExecutor(solver_executor.get());
+    }
+    world.SetAllowSleeping(settings.allow_sleep);
+    world.SetWideContactSolving(settings.wide_contact_solver);
+    world.SetSleepTolerances(settings.linear_sleep_tolerance, settings.angular_sleep_tolerance,
+                             settings.time_to_sleep);
     b2BodyDef player_body_definition;
     player_body_definition.type = b2_dynamicBody;
     player_body_definition.position.Set(0.0f, 0.0f);
@@ -31,63 +119,272 @@ namespace textengine {
     player_fixture_definition.friction = 0.5f;
     player_body->CreateFixture(&player_fixture_definition);
 
-    for (const auto &area : scene.areas) {
-      b2BodyDef area_body_definition;
-      area_body_definition.position.Set(area->aabb.center().x, area->aabb.center().y);
-      area_body_definition.fixedRotation = true;
-      area_body_definition.userData = area.get();
-      areas.push_back(world.CreateBody(&area_body_definition));
-      b2PolygonShape aabb_shape;
-      b2CircleShape circle_shape;
-      b2FixtureDef area_fixture_definition;
-      if (Shape::kAxisAlignedBoundingBox == area->shape) {
-        aabb_shape.SetAsBox(area->aabb.half_extent().x, area->aabb.half_extent().y);
-        area_fixture_definition.shape = &aabb_shape;
+    if (create_bodies && settings.fixtures_per_merged_body > 1) {
+      CreateMergedBodies(scene);
+    } else if (create_bodies) {
+      for (const auto &area : scene.areas) {
+        CreateBody(scene.areas.handle(area), area, true);
+      }
+      for (const auto &object : scene.objects) {
+        CreateBody(scene.objects.handle(object), object, false);
+      }
+    }
+    if (create_bodies) {
+      RebuildTrees();
+    }
+  }
+
+  GameState::~GameState() = default;
+
+  void GameState::CreateBody(Scene &scene, Handle item) {
+    DestroyBody(item);
+    const auto object = scene.Find(item);
+    if (object) {
+      CreateBody(item, *object, scene.IsArea(item));
+    }
+  }
+
+  void GameState::CreateBody(Handle item, const Object &object, bool is_area) {
+    DestroyBody(item);
+    if (is_area) {
+      areas.Insert(item, object.aabb);
+      return;
+    }
+    AttachBody(item, CreateDetachedBody(item, object));
+  }
+
+  void GameState::MoveBody(Scene &scene, Handle item) {
+    const auto object = scene.Find(item);
+    const auto fixture = FindFixture(item);
+    const auto body = fixture ? fixture->GetBody() : nullptr;
+    if (object && body && body->GetFixtureList() == fixture && !fixture->GetNext()) {
+      const auto center = object->aabb.center();
+      body->SetTransform(b2Vec2(center.x, center.y), body->GetAngle());
+    } else {
+      CreateBody(scene, item);
+    }
+  }
+
+  b2Body *GameState::CreateDetachedBody(Handle item, const Object &object) {
+    b2BodyDef body_definition;
+    body_definition.type = b2_staticBody;
+    body_definition.position.Set(object.aabb.center().x, object.aabb.center().y);
+    body_definition.fixedRotation = true;
+    const FixtureDefinition fixture(item, object, b2Vec2_zero);
+    return world.CreateDetachedBody(&body_definition, &fixture.definition, 1);
+  }
+
+  void GameState::AttachBody(Handle item, b2Body *body) {
+    DestroyBody(item);
+    world.AttachBody(body);
+    objects[item] = body->GetFixtureList();
+  }
+
+  b2Body *GameState::DetachBody(Handle item) {
+    const auto fixture = objects.find(item);
+    if (objects.cend() == fixture) {
+      DestroyBody(item);
+      return nullptr;
+    }
+    const auto body = fixture->second->GetBody();
+    if (body->GetFixtureList() != fixture->second || fixture->second->GetNext()) {
+      DestroyBody(item);
+      return nullptr;
+    }
+    world.DetachBody(body);
+    objects.erase(fixture);
+    return body;
+  }
+
+  void GameState::DestroyDetachedBody(b2Body *body) {
+    world.DestroyDetachedBody(body);
+  }
+
+  void GameState::DestroyBody(Handle item) {
+    areas.Remove(item);
+    const auto fixture = objects.find(item);
+    if (objects.cend() != fixture) {
+      const auto body = fixture->second->GetBody();
+      if (body->GetFixtureList() == fixture->second && !fixture->second->GetNext()) {
+        world.DestroyBody(body);
       } else {
-        circle_shape.m_radius = area->aabb.radius();
-        area_fixture_definition.shape = &circle_shape;
+        body->DestroyFixture(fixture->second);
       }
-      area_fixture_definition.isSensor = true;
-      areas.back()->CreateFixture(&area_fixture_definition);
+      objects.erase(fixture);
+    }
+  }
+
+  b2Body *GameState::FindBody(Handle item) const {
+    const auto fixture = FindFixture(item);
+    return fixture ? fixture->GetBody() : nullptr;
+  }
+
+  b2Fixture *GameState::FindFixture(Handle item) const {
+    const auto fixture = objects.find(item);
+    return objects.cend() == fixture ? nullptr : fixture->second;
+  }
+
+  void GameState::RayCast(const std::vector<Ray> &rays, std::vector<RayHit> &hits) const {
+    hits.resize(rays.size());
+    ParallelFor(rays.size(), kQueryGrain, [&] (std::size_t begin, std::size_t end, std::size_t) {
+      for (auto i = begin; i < end; ++i) {
+        const auto &ray = rays[i];
+        hits[i] = RayHit{Handle(), ray.target, glm::vec2(), 1.0f};
+        if (ray.origin != ray.target) {
+          ClosestHitCallback callback(hits[i]);
+          world.RayCast(&callback, b2Vec2(ray.origin.x, ray.origin.y),
+                        b2Vec2(ray.target.x, ray.target.y));
+        }
+      }
+    });
+  }
+
+  void GameState::QueryOverlaps(const std::vector<AxisAlignedBoundingBox> &boxes,
+                                Overlaps &overlaps) const {
+    // Each chunk of boxes collects its items separately, with offsets relative to the chunk, so
+    // the results come out in the same order however the chunks are spread across threads.
+    std::vector<std::vector<Handle>> chunk_items((boxes.size() + kQueryGrain - 1) / kQueryGrain);
+    overlaps.offsets.assign(boxes.size() + 1, 0);
+    ParallelFor(boxes.size(), kQueryGrain, [&] (std::size_t begin, std::size_t end, std::size_t) {
+      auto &items = chunk_items[begin / kQueryGrain];
+      for (auto i = begin; i < end; ++i) {
+        b2AABB bounds;
+        bounds.lowerBound.Set(boxes[i].minimum.x, boxes[i].minimum.y);
+        bounds.upperBound.Set(boxes[i].maximum.x, boxes[i].maximum.y);
+        OverlapCallback callback(bounds, items);
+        world.QueryAABB(&callback, bounds);
+        overlaps.offsets[i + 1] = items.size();
+      }
+    });
+    overlaps.items.clear();
+    for (std::size_t chunk = 0; chunk < chunk_items.size(); ++chunk) {
+      const auto base = overlaps.items.size();
+      const auto end = std::min(boxes.size(), (chunk + 1) * kQueryGrain);
+      for (auto i = chunk * kQueryGrain; i < end; ++i) {
+        overlaps.offsets[i + 1] += base;
+      }
+      overlaps.items.insert(overlaps.items.end(), chunk_items[chunk].begin(),
+                            chunk_items[chunk].end());
+    }
+  }
+
+  void GameState::RebuildTrees() {
+    const auto start = std::chrono::high_resolution_clock::now();
+    tree_statistics.quality_before = world.GetTreeQuality();
+    world.RebuildBroadPhase();
+    areas.Rebuild(solver_executor.get());
+    tree_statistics.rebuilds += 1;
+    tree_statistics.proxy_count = world.GetProxyCount();
+    tree_statistics.height = world.GetTreeHeight();
+    tree_statistics.balance = world.GetTreeBalance();
+    tree_statistics.quality = world.GetTreeQuality();
+    tree_statistics.duration = std::chrono::high_resolution_clock::now() - start;
+  }
+
+  void GameState::Step(float dt) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    {
+      PROFILE_SCOPE("world.Step");
+      world.Step(dt, settings.velocity_iterations, settings.position_iterations);
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::high_resolution_clock::now() - start;
+    step_statistics.count += 1;
+    step_statistics.total += elapsed;
+    step_statistics.maximum = std::max(step_statistics.maximum, elapsed);
+    Metrics::Observe(Metrics::kStepTime, elapsed);
+  }
+
+  GameState::FixtureDefinition::FixtureDefinition(Handle item, const Object &object,
+                                                  b2Vec2 offset)
+  : box(), circle(), definition() {
+    if (Shape::kAxisAlignedBoundingBox == object.shape) {
+      box.SetAsBox(object.aabb.half_extent().x, object.aabb.half_extent().y, offset, 0.0f);
+      definition.shape = &box;
+    } else {
+      circle.m_p = offset;
+      circle.m_radius = object.aabb.radius();
+      definition.shape = &circle;
+    }
+    definition.friction = 0.5f;
+    definition.userData = item.ToUserData();
+  }
+
+  void GameState::CreateFixture(b2Body *body, Handle item, const Object &object,
+                                b2Vec2 offset) {
+    const FixtureDefinition fixture(item, object, offset);
+    objects[item] = body->CreateFixture(&fixture.definition);
+  }
+
+  void GameState::CreateMergedBodies(Scene &scene) {
+    struct Item {
+      Handle handle;
+      const Object *object;
+    };
+    std::vector<Item> items;
+    items.reserve(scene.objects.size());
+    for (const auto &area : scene.areas) {
+      areas.Insert(scene.areas.handle(area), area.aabb);
     }
     for (const auto &object : scene.objects) {
-      b2BodyDef object_body_definition;
-      object_body_definition.position.Set(object->aabb.center().x, object->aabb.center().y);
-      object_body_definition.fixedRotation = true;
-      object_body_definition.userData = object.get();
-      objects.push_back(world.CreateBody(&object_body_definition));
-      b2PolygonShape aabb_shape;
-      b2CircleShape circle_shape;
-      b2FixtureDef object_fixture_definition;
-      if (Shape::kAxisAlignedBoundingBox == object->shape) {
-        aabb_shape.SetAsBox(object->aabb.half_extent().x, object->aabb.half_extent().y);
-        object_fixture_definition.shape = &aabb_shape;
-      } else {
-        circle_shape.m_radius = object->aabb.radius();
-        object_fixture_definition.shape = &circle_shape;
+      items.push_back(Item{scene.objects.handle(object), &object});
+    }
+
+    // Sweep along x, joining each item with the earlier items whose boxes it touches as long as
+    // the joined cluster stays within the fixture limit.
+    std::vector<std::size_t> order(items.size()), parents(items.size()), sizes(items.size(), 1);
+    std::iota(order.begin(), order.end(), 0);
+    std::iota(parents.begin(), parents.end(), 0);
+    std::sort(order.begin(), order.end(), [&items] (std::size_t a, std::size_t b) {
+      return items[a].object->aabb.minimum.x < items[b].object->aabb.minimum.x;
+    });
+    const auto find = [&parents] (std::size_t i) {
+      while (parents[i] != i) {
+        i = parents[i] = parents[parents[i]];
       }
-      object_fixture_definition.friction = 0.5f;
-      objects.back()->CreateFixture(&object_fixture_definition);
-    }
-  }
-
-  GameState::~GameState() {
-    // TODO(robertsdionne): debug the mutex lock failure; not even sure why that's happening.
-//    if (player_body) {
-//      world.DestroyBody(player_body);
-//      player_body = nullptr;
-//    }
-//    for (auto &area : areas) {
-//      if (area) {
-//        world.DestroyBody(area);
-//        area = nullptr;
-//      }
-//    }
-    for (auto &object : objects) {
-      if (object) {
-        world.DestroyBody(object);
-        object = nullptr;
+      return i;
+    };
+    std::vector<std::size_t> active;
+    for (const auto i : order) {
+      const auto &aabb = items[i].object->aabb;
+      active.erase(std::remove_if(active.begin(), active.end(), [&] (std::size_t j) {
+        return items[j].object->aabb.maximum.x < aabb.minimum.x;
+      }), active.end());
+      for (const auto j : active) {
+        const auto &other = items[j].object->aabb;
+        const auto a = find(i), b = find(j);
+        if (a != b && aabb.minimum.y <= other.maximum.y && other.minimum.y <= aabb.maximum.y
+            && sizes[a] + sizes[b] <= settings.fixtures_per_merged_body) {
+          parents[b] = a;
+          sizes[a] += sizes[b];
+        }
+      }
+      active.push_back(i);
+    }
+
+    std::unordered_map<std::size_t, b2Body *> bodies;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+      auto &body = bodies[find(i)];
+      if (!body) {
+        b2BodyDef body_definition;
+        body_definition.type = b2_staticBody;
+        body_definition.fixedRotation = true;
+        body = world.CreateBody(&body_definition);
       }
+      const auto center = items[i].object->aabb.center();
+      CreateFixture(body, items[i].handle, *items[i].object, b2Vec2(center.x, center.y));
+    }
+  }
+
+  void GameState::ParallelFor(
+      std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t, std::size_t)> &function) const {
+    if (solver_pool) {
+      solver_pool->ParallelFor(count, grain, function);
+      return;
+    }
+    for (std::size_t begin = 0; begin < count; begin += grain) {
+      function(begin, std::min(begin + grain, count), 0);
     }
   }
 
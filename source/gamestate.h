@@ -3,33 +3,201 @@
 
 #include <Box2D/Box2D.h>
 #include <chrono>
+#include <cstddef>
 #include <deque>
 #include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "areatracker.h"
+#include "concurrentblockallocator.h"
 #include "drawable.h"
+#include "handle.h"
 
 namespace textengine {
 
   class Object;
   class Scene;
+  class ThreadPool;
+
+  /**
+   * Tunables for the Box2D world. Sleep tolerances default to Box2D's own.
+   */
+  struct PhysicsSettings {
+    int velocity_iterations = 8, position_iterations = 3;
+    bool allow_sleep = true;
+    float linear_sleep_tolerance = b2_linearSleepTolerance;
+    float angular_sleep_tolerance = b2_angularSleepTolerance;
+    float time_to_sleep = b2_timeToSleep;
+
+    /**
+     * Threads used to solve islands, counting the stepping thread. Zero uses one per hardware
+     * thread; one solves on the stepping thread alone.
+     */
+    std::size_t solver_threads = 0;
+
+    /**
+     * Solves contacts four at a time with SIMD. Results differ slightly from the scalar solver,
+     * since contacts are solved in a different order.
+     */
+    bool wide_contact_solver = false;
+
+    /**
+     * Objects whose bounding boxes touch share a static body of at most this many fixtures. Zero
+     * or one gives every object its own body.
+     */
+    std::size_t fixtures_per_merged_body = 64;
+  };
+
+  struct Ray {
+    glm::vec2 origin, target;
+  };
+
+  /**
+   * The closest item a ray hits. A ray that reaches its target has a null item and fraction one.
+   */
+  struct RayHit {
+    Handle item;
+    glm::vec2 point, normal;
+    float fraction;
+  };
+
+  /**
+   * The items overlapping each of a batch of boxes. Those of box i are items[offsets[i]] up to
+   * items[offsets[i + 1]].
+   */
+  struct Overlaps {
+    std::vector<std::size_t> offsets;
+    std::vector<Handle> items;
+  };
+
+  struct StepStatistics {
+    std::size_t count;
+    std::chrono::duration<double, std::milli> total, maximum;
+  };
+
+  struct TreeStatistics {
+    std::size_t rebuilds;
+    int proxy_count, height, balance;
+    float quality_before, quality;
+    std::chrono::duration<double, std::milli> duration;
+  };
 
   class GameState {
   public:
-    GameState(Scene &scene);
+    /**
+     * Creates the player and, unless create_bodies is false, a body for every scene item. A
+     * WorldStreamer creates item bodies on demand instead.
+     */
+    GameState(Scene &scene, bool create_bodies = true,
+              const PhysicsSettings &settings = PhysicsSettings());
 
     virtual ~GameState();
 
+    /**
+     * Creates the Box2D body for a scene object, replacing any body it already has. Areas have no
+     * body; they are tracked by bounds in areas instead.
+     */
+    void CreateBody(Scene &scene, Handle item);
+
+    void CreateBody(Handle item, const Object &object, bool is_area);
+
+    /**
+     * Moves the item's body to where the scene now has the item, keeping its fixture. An item
+     * sharing a merged body, or an area, gets a body of its own through CreateBody instead.
+     */
+    void MoveBody(Scene &scene, Handle item);
+
+    /**
+     * Removes the item's fixture, and its body once no other item shares it, or stops tracking
+     * the area.
+     */
+    void DestroyBody(Handle item);
+
+    /**
+     * Builds the body for a scene object without adding it to the world. This may be called on
+     * any thread, even while the world steps.
+     */
+    b2Body *CreateDetachedBody(Handle item, const Object &object);
+
+    /**
+     * Adds a body from CreateDetachedBody to the world as the item's body.
+     */
+    void AttachBody(Handle item, b2Body *body);
+
+    /**
+     * Removes the item's body from the world and returns it unfreed when no other item shares
+     * it, for DestroyDetachedBody to free on any thread. Otherwise destroys the item's fixture,
+     * or stops tracking the area, and returns null.
+     */
+    b2Body *DetachBody(Handle item);
+
+    void DestroyDetachedBody(b2Body *body);
+
+    b2Body *FindBody(Handle item) const;
+
+    b2Fixture *FindFixture(Handle item) const;
+
+    /**
+     * Finds the closest item each ray hits, spreading the rays across the solver threads. The
+     * player is ignored. Must not be called while the world steps.
+     */
+    void RayCast(const std::vector<Ray> &rays, std::vector<RayHit> &hits) const;
+
+    /**
+     * Finds the items whose bounds overlap each box, spreading the boxes across the solver
+     * threads. The player is ignored. Must not be called while the world steps.
+     */
+    void QueryOverlaps(const std::vector<AxisAlignedBoundingBox> &boxes, Overlaps &overlaps) const;
+
+    /**
+     * Rebuilds the broad-phase and area trees top down on the solver threads. Trees built one
+     * insertion at a time degrade after a large load, so call this once a batch of bodies is in.
+     */
+    void RebuildTrees();
+
+    /**
+     * Advances the world by dt using the configured iteration counts and records the time taken.
+     */
+    void Step(float dt);
+
+  private:
+    struct FixtureDefinition {
+      FixtureDefinition(Handle item, const Object &object, b2Vec2 offset);
+
+      b2PolygonShape box;
+      b2CircleShape circle;
+      b2FixtureDef definition;
+    };
+
+    void CreateFixture(b2Body *body, Handle item, const Object &object, b2Vec2 offset);
+
+    void CreateMergedBodies(Scene &scene);
+
+    /**
+     * Runs function over [0, count) on the solver threads, or on this thread if there are none.
+     */
+    void ParallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t, std::size_t)> &function) const;
+
+  public:
     glm::vec2 camera_position, previous_player_position;
     float accrued_distance, zoom;
+    ConcurrentBlockAllocator allocator;
     b2World world;
     b2Body *player_body;
-    Object *selected_item;
+    Handle selected_item;
+    PhysicsSettings settings;
+    StepStatistics step_statistics;
+    TreeStatistics tree_statistics;
+    std::unique_ptr<ThreadPool> solver_pool;
+    std::unique_ptr<b2TaskExecutor> solver_executor;
 
-    std::vector<b2Body *> areas;
-    std::vector<b2Body *> objects;
+    AreaTracker areas;
+    std::unordered_map<Handle, b2Fixture *, HandleHash> objects;
   };
 
 }  // namespace textengine
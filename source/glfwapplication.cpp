@@ -1,4 +1,5 @@
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <unistd.h>
@@ -9,7 +10,9 @@
 #include "input.h"
 #include "joystick.h"
 #include "keyboard.h"
+#include "metrics.h"
 #include "mouse.h"
+#include "profiler.h"
 #include "renderer.h"
 
 namespace textengine {
@@ -92,6 +95,7 @@ namespace textengine {
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
     HandleReshape(window, framebuffer_width, framebuffer_height);
     controller.Setup();
+    auto frame_start = std::chrono::steady_clock::now();
     while (!glfwWindowShouldClose(window)) {
       if (keyboard.GetKeyVelocity(GLFW_KEY_TAB) > 0) {
         if (minimized) {
@@ -103,25 +107,40 @@ namespace textengine {
         }
         minimized = !minimized;
       }
-      if (minimized) {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-      } else {
-        renderer.Render();
+      {
+        PROFILE_SCOPE("render");
+        if (minimized) {
+          glClearColor(1.0, 1.0, 1.0, 1.0);
+          glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        } else {
+          renderer.Render();
+        }
+      }
+      {
+        PROFILE_SCOPE("update");
+        controller.Update();
+        keyboard.Update();
+        mouse.Update();
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        mouse.OnCursorMove(glm::vec2(x, y));
+        joystick.Update();
+        input.Update();
+      }
+      {
+        PROFILE_SCOPE("swap");
+        glfwSwapBuffers(window);
+      }
+      {
+        PROFILE_SCOPE("poll");
+        glfwPollEvents();
       }
-      controller.Update();
-      keyboard.Update();
-      mouse.Update();
-      double x, y;
-      glfwGetCursorPos(window, &x, &y);
-      mouse.OnCursorMove(glm::vec2(x, y));
-      joystick.Update();
-      input.Update();
-      glfwSwapBuffers(window);
-      glfwPollEvents();
       if (minimized) {
         usleep(16666);
       }
+      const auto frame_end = std::chrono::steady_clock::now();
+      Metrics::Observe(Metrics::kFrameTime, frame_end - frame_start);
+      frame_start = frame_end;
     }
     glfwTerminate();
     return 0;
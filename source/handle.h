@@ -0,0 +1,56 @@
+#ifndef __textengine__handle__
+#define __textengine__handle__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace textengine {
+
+  /**
+   * A stable reference to an item stored in a Scene. The generation changes every time the
+   * underlying slot is reused, so a handle to an erased item never resolves to a newer one.
+   */
+  struct Handle {
+    std::uint32_t index, generation;
+
+    /**
+     * Generation zero is never issued, so a default-constructed Handle is null.
+     */
+    explicit operator bool() const {
+      return generation != 0;
+    }
+
+    bool operator ==(const Handle &other) const {
+      return index == other.index && generation == other.generation;
+    }
+
+    bool operator !=(const Handle &other) const {
+      return !(*this == other);
+    }
+
+    /**
+     * Packs this handle into a pointer-sized value suitable for b2Body user data.
+     */
+    void *ToUserData() const {
+      static_assert(sizeof(void *) >= sizeof(std::uint64_t), "Handle does not fit in a pointer.");
+      return reinterpret_cast<void *>(
+          static_cast<std::uintptr_t>(generation) << 32 | static_cast<std::uintptr_t>(index));
+    }
+
+    static Handle FromUserData(void *user_data) {
+      const auto bits = reinterpret_cast<std::uintptr_t>(user_data);
+      return Handle{static_cast<std::uint32_t>(bits), static_cast<std::uint32_t>(bits >> 32)};
+    }
+  };
+
+  struct HandleHash {
+    std::size_t operator ()(const Handle &handle) const {
+      return std::hash<std::uint64_t>()(
+          static_cast<std::uint64_t>(handle.generation) << 32 | handle.index);
+    }
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__handle__) */
@@ -0,0 +1,26 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "hash.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+    constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+
+  }  // namespace
+
+  std::uint64_t HashBytes(std::uint64_t hash, const void *bytes, std::size_t size) {
+    if (!hash) {
+      hash = kFnvOffsetBasis;
+    }
+    const auto data = static_cast<const unsigned char *>(bytes);
+    for (std::size_t i = 0; i < size; ++i) {
+      hash = (hash ^ data[i]) * kFnvPrime;
+    }
+    return hash;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,16 @@
+#ifndef __textengine__hash__
+#define __textengine__hash__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace textengine {
+
+  /**
+   * Hashes message content with 64 bit FNV-1a so that two runs can be compared cheaply.
+   */
+  std::uint64_t HashBytes(std::uint64_t hash, const void *bytes, std::size_t size);
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__hash__) */
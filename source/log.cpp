@@ -1,29 +1,69 @@
 #include <chrono>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <zlib.h>
 
 #include "log.h"
 
 namespace textengine {
 
-  Log::Log(const std::string &filename) : filename(filename), out(filename, std::ios_base::app) {
+  namespace {
+
+    /** A power of two; about a minute of websocket traffic. */
+    constexpr std::size_t kQueueCapacity = 4096;
+
+    constexpr auto kPollInterval = std::chrono::milliseconds(10);
+
+  }  // namespace
+
+  Log::Log(const std::string &filename, Format format, bool compressed)
+  : filename(filename), format(format), out(), compressed_out(), slots(new Slot[kQueueCapacity]),
+    push_position(), pop_position(), prefix_time(-1), prefix(), messages(), dropped(),
+    unreported(), batches(), bytes(), running(true), thread() {
+    if (compressed) {
+      compressed_out = gzopen(filename.c_str(), "ab");
+    } else {
+      out.open(filename, std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+    }
+    for (std::size_t i = 0; i < kQueueCapacity; ++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread = std::thread(&Log::Loop, this);
     Begin();
   }
 
   Log::~Log() {
     End();
+    running = false;
+    thread.join();
+    if (compressed_out) {
+      gzclose(compressed_out);
+    }
     out.close();
   }
 
   void Log::LogMessage(const std::string &message) {
-    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    out << std::put_time(std::localtime(&now), "%F %T %Z") << ": " << message << std::endl;
+    LogMessage(std::string(message));
+  }
+
+  void Log::LogMessage(std::string &&message) {
+    if (!Push(Clock::now(), std::move(message))) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      unreported.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  Log::Statistics Log::statistics() const {
+    return Statistics{messages.load(), dropped.load(), batches.load(), bytes.load()};
   }
 
   void Log::Begin() {
-    std::ostringstream to_string;
     LogMessage("Beginning session.");
   }
 
@@ -31,4 +71,103 @@ namespace textengine {
     LogMessage("Ending session.");
   }
 
+  void Log::Append(Clock::time_point time, const std::string &message, std::string &batch) {
+    if (Format::kBinary == format) {
+      const std::int64_t microseconds =
+          std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+      const auto size = static_cast<std::uint32_t>(message.size());
+      batch.append(reinterpret_cast<const char *>(&microseconds), sizeof(microseconds));
+      batch.append(reinterpret_cast<const char *>(&size), sizeof(size));
+      batch.append(message);
+      return;
+    }
+    // Formatting the time is most of the cost of a line, and most lines share their second.
+    const auto seconds = Clock::to_time_t(time);
+    if (seconds != prefix_time) {
+      std::ostringstream to_string;
+      to_string << std::put_time(std::localtime(&seconds), "%F %T %Z") << ": ";
+      prefix = to_string.str();
+      prefix_time = seconds;
+    }
+    batch.append(prefix);
+    batch.append(message);
+    batch.push_back('\n');
+  }
+
+  void Log::Loop() {
+    std::string batch, message;
+    Clock::time_point time;
+    while (true) {
+      // Whatever was logged before the destructor stopped the writer is drained below.
+      const auto stopping = !running.load();
+      batch.clear();
+      std::size_t count = 0;
+      while (Pop(time, message)) {
+        Append(time, message, batch);
+        ++count;
+      }
+      const auto missed = unreported.exchange(0, std::memory_order_relaxed);
+      if (missed) {
+        Append(Clock::now(), "Dropped " + std::to_string(missed) + " messages.", batch);
+      }
+      if (!batch.empty()) {
+        Write(batch);
+        messages.fetch_add(count, std::memory_order_relaxed);
+        batches.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(batch.size(), std::memory_order_relaxed);
+      }
+      if (stopping) {
+        break;
+      }
+      if (!count) {
+        std::this_thread::sleep_for(kPollInterval);
+      }
+    }
+  }
+
+  bool Log::Pop(Clock::time_point &time, std::string &message) {
+    auto &slot = slots[pop_position % kQueueCapacity];
+    if (slot.sequence.load(std::memory_order_acquire) != pop_position + 1) {
+      return false;
+    }
+    time = slot.time;
+    message.swap(slot.message);
+    // Hands the slot to whoever pushes a whole turn of the ring later.
+    slot.sequence.store(pop_position + kQueueCapacity, std::memory_order_release);
+    ++pop_position;
+    return true;
+  }
+
+  bool Log::Push(Clock::time_point time, std::string &&message) {
+    auto position = push_position.load(std::memory_order_relaxed);
+    while (true) {
+      auto &slot = slots[position % kQueueCapacity];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        // The slot is free for this turn; claim it unless another thread got there first.
+        if (push_position.compare_exchange_weak(position, position + 1,
+                                                std::memory_order_relaxed)) {
+          slot.time = time;
+          slot.message = std::move(message);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < position) {
+        // The writer has yet to empty it from the previous turn: the ring is full.
+        return false;
+      } else {
+        position = push_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Log::Write(const std::string &batch) {
+    if (compressed_out) {
+      gzwrite(compressed_out, batch.data(), static_cast<unsigned>(batch.size()));
+    } else {
+      out.write(batch.data(), batch.size());
+      out.flush();
+    }
+  }
+
 }  // namespace textengine
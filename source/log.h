@@ -1,28 +1,93 @@
 #ifndef __textengine__log__
 #define __textengine__log__
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <ctime>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <zlib.h>
 
 namespace textengine {
 
+  /**
+   * Appends timestamped messages to a file without making the caller wait for the disk.
+   *
+   * LogMessage stamps the message and hands it to a writer thread through a fixed ring, claiming
+   * a slot with a compare-and-swap, so no caller takes a lock or waits; if the ring is full the
+   * message is dropped and counted, and the writer notes how many it dropped. The writer drains
+   * the ring every few milliseconds and writes what it took in one batch.
+   *
+   * Text logs read as they always have. Binary logs hold one record per message: the time in
+   * microseconds since the Unix epoch as a 64-bit integer, the length of the message as a 32-bit
+   * integer, both in the machine's byte order, then the message itself. Either may be gzipped,
+   * in which case it reaches the disk in blocks rather than in batches.
+   */
   class Log {
   public:
-    Log(const std::string &filename);
+    enum class Format {
+      kText,
+      kBinary
+    };
+
+    struct Statistics {
+      std::size_t messages, dropped, batches, bytes;
+    };
+
+    explicit Log(const std::string &filename, Format format = Format::kText,
+                 bool compressed = false);
 
     virtual ~Log();
 
     void LogMessage(const std::string &message);
 
+    void LogMessage(std::string &&message);
+
+    Statistics statistics() const;
+
   private:
+    using Clock = std::chrono::system_clock;
+
+    struct Slot {
+      /** Which turn of the ring the slot is ready for; see Push and Pop. */
+      std::atomic<std::size_t> sequence;
+      Clock::time_point time;
+      std::string message;
+    };
+
     virtual void Begin();
 
     virtual void End();
 
+    void Append(Clock::time_point time, const std::string &message, std::string &batch);
+
+    void Loop();
+
+    bool Pop(Clock::time_point &time, std::string &message);
+
+    bool Push(Clock::time_point time, std::string &&message);
+
+    void Write(const std::string &batch);
+
   private:
     std::string filename;
+    Format format;
     std::fstream out;
+    gzFile compressed_out;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<std::size_t> push_position;
+
+    // Writer side.
+    std::size_t pop_position;
+    std::time_t prefix_time;
+    std::string prefix;
+
+    std::atomic<std::size_t> messages, dropped, unreported, batches, bytes;
+    std::atomic<bool> running;
+    std::thread thread;
   };
 
 }  // namespace textengine
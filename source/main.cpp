@@ -1,5 +1,20 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "ambienceplayer.h"
+#include "audiobenchmark.h"
+#include "audioengine.h"
+#include "audiosink.h"
+#include "contactbenchmark.h"
+#include "cuemixer.h"
 #include "editor.h"
 #include "gamestate.h"
 #include "glfwapplication.h"
@@ -7,47 +22,338 @@
 #include "joystick.h"
 #include "keyboard.h"
 #include "log.h"
+#include "messagebenchmark.h"
+#include "metrics.h"
 #include "mouse.h"
+#include "openalaudiosink.h"
+#include "profiler.h"
+#include "querybenchmark.h"
+#include "recorder.h"
 #include "scene.h"
 #include "sceneloader.h"
 #include "sceneserializer.h"
+#include "speechcache.h"
+#include "speechsynthesizer.h"
 #include "synchronizedqueue.h"
+#include "telemetrybenchmark.h"
 #include "textenginerenderer.h"
+#include "threadpool.h"
 #include "updater.h"
 #include "voiceprompt.h"
 #include "websocketprompt.h"
+#include "worldgenerator.h"
+#include "worldstreamer.h"
 
+constexpr std::size_t kAudioBenchmarkUtterances = 200;
+constexpr std::size_t kAudioBufferCount = 4;
+constexpr int kAudioSampleRate = 44100;
+constexpr std::size_t kContactBenchmarkPileHeight = 10;
+constexpr std::size_t kContactBenchmarkPiles = 300;
+constexpr std::size_t kContactBenchmarkSettleSteps = 60;
+constexpr std::size_t kContactBenchmarkSteps = 400;
+constexpr std::size_t kCueBenchmarkBlocks = 2000;
+constexpr std::size_t kCueVoices = 512;
+constexpr int kDeflateLevel = 1;
+constexpr int kDeflateWindowBits = 15;
+constexpr const char *kGameProtocol = u8"interactive-fiction-protocol";
+constexpr std::uint64_t kGeneratorSeed = 1;
+constexpr std::size_t kMessageBenchmarkDraws = 2000000;
+constexpr std::size_t kMessageBenchmarkMessages = 5;
+constexpr std::size_t kMessageCacheCapacity = 256;
+constexpr std::size_t kStreamingBodiesPerUpdate = 64;
+constexpr float kStreamingChunkSize = 16.0f;
+constexpr float kStreamingLoadRadius = 32.0f;
+constexpr float kStreamingUnloadRadius = 48.0f;
+constexpr std::size_t kTelemetryBenchmarkTicks = 625;
 constexpr const char *kPlaytestLog = u8"playtest.log";
+constexpr const char *kProfileTrace = u8"profile.json";
 constexpr const char *kPrompt = u8"> ";
+constexpr std::size_t kQueryBenchmarkItems = 100000;
+constexpr std::size_t kQueryBenchmarkQueries = 10000;
+constexpr std::size_t kQueryBenchmarkTicks = 10;
+constexpr const char *kRecording = u8"playtest.replay";
+constexpr std::size_t kVoiceCacheBytes = 32 * 1024 * 1024;
+constexpr const char *kVoiceClips = u8"../resource/voice";
 constexpr int kWindowHeight = 800;
 constexpr int kWindowWidth = 1280/2;
 constexpr const char *kWindowTitle = u8"Palimpsest";
 
 int main(int argument_count, char *arguments[]) {
   const std::string filename = argument_count > 1 ? arguments[1] : "../resource/scenes/terrarium.json";
-  const auto edit = argument_count > 2 && "edit" == std::string(arguments[2]);
-  const auto voice = false;
+  const auto has_option = [argument_count, arguments] (const std::string &option) {
+    return std::find(arguments + std::min(argument_count, 2), arguments + argument_count, option)
+        != arguments + argument_count;
+  };
+  // Options that take a value are written name=value; a missing one is empty.
+  const auto option_value = [argument_count, arguments] (const std::string &option) {
+    const auto prefix = option + "=";
+    for (auto argument = arguments + std::min(argument_count, 2);
+         argument != arguments + argument_count; ++argument) {
+      if (!std::string(*argument).compare(0, prefix.size(), prefix)) {
+        return std::string(*argument + prefix.size());
+      }
+    }
+    return std::string();
+  };
+  // Loading and generating spread items across every hardware thread. GameState starts a pool of
+  // its own, sized by PhysicsSettings, so this one stops once the scene is read.
+  std::unique_ptr<textengine::ThreadPool> load_pool(
+      new textengine::ThreadPool(std::thread::hardware_concurrency()));
+  const auto generate = option_value("generate");
+  if (!generate.empty()) {
+    const auto seed = option_value("seed");
+    textengine::WorldGenerator generator(seed.empty() ? kGeneratorSeed : std::stoull(seed));
+    auto generated = generator.Generate(std::stoull(generate), *load_pool);
+    const auto write_start = std::chrono::high_resolution_clock::now();
+    textengine::SceneSerializer(false).WriteScene(filename, generated);
+    const std::chrono::duration<double, std::milli> write =
+        std::chrono::high_resolution_clock::now() - write_start;
+    std::cout << "generated " << generator.statistics.area_count << " areas and "
+        << generator.statistics.object_count << " objects: generate "
+        << generator.statistics.generate.count() << " ms, insert "
+        << generator.statistics.insert.count() << " ms, write " << write.count() << " ms"
+        << std::endl;
+    return 0;
+  }
+  if (has_option("benchmark-queries")) {
+    auto generated = textengine::WorldGenerator(kGeneratorSeed).Generate(kQueryBenchmarkItems,
+                                                                        *load_pool);
+    load_pool.reset();
+    std::vector<std::size_t> thread_counts{1};
+    if (std::thread::hardware_concurrency() > 1) {
+      thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    std::cout << kQueryBenchmarkQueries << " rays and boxes per tick against "
+        << kQueryBenchmarkItems << " generated items, mean of " << kQueryBenchmarkTicks
+        << " ticks:" << std::endl;
+    for (const auto &result : textengine::QueryBenchmark(generated, kGeneratorSeed).Run(
+        kQueryBenchmarkQueries, kQueryBenchmarkTicks, thread_counts)) {
+      std::cout << "  " << result.thread_count << " threads: rays " << result.ray_cast.count()
+          << " ms (" << result.hit_count << " hit), boxes " << result.overlap.count() << " ms ("
+          << result.overlap_count << " overlaps)" << std::endl;
+    }
+    return 0;
+  }
+  if (has_option("benchmark-contacts")) {
+    textengine::ContactBenchmark benchmark(kContactBenchmarkPiles, kContactBenchmarkPileHeight);
+    const auto comparison = benchmark.Compare(kContactBenchmarkSettleSteps);
+    std::cout << "one step of " << comparison.body_count << " bodies from an identical state: "
+        << "velocities differ by at most " << comparison.velocity_difference << " (speeds up to "
+        << comparison.maximum_speed << "), positions by " << comparison.position_difference
+        << std::endl;
+    for (const auto &result : benchmark.Run(kContactBenchmarkSteps)) {
+      std::cout << "  " << result.solver << ": " << result.contact_count
+          << " contacts, mean height " << result.mean_height << ", " << result.step.count()
+          << " ms per step, " << result.solve_velocity.count() << " ms solving velocities"
+          << std::endl;
+    }
+    return 0;
+  }
+  if (has_option("benchmark-audio")) {
+    std::cout << "speech latency over " << kAudioBenchmarkUtterances
+        << " utterances from an instant synthesizer:" << std::endl;
+    for (const auto &result : textengine::AudioBenchmark(kAudioSampleRate).Speak(
+        kAudioBenchmarkUtterances)) {
+      const auto &speech = result.statistics;
+      std::cout << "  " << result.sink << " null sink: " << speech.utterances << " utterances, "
+          << speech.dropped << " dropped, " << speech.failed << " failed, latency mean "
+          << speech.latency.count() / speech.utterances << " ms, max "
+          << speech.maximum_latency.count() << " ms" << std::endl;
+    }
+    return 0;
+  }
+  if (has_option("benchmark-messages")) {
+    std::cout << "choosing one of " << kMessageBenchmarkMessages << " messages:" << std::endl;
+    for (const auto &result : textengine::MessageBenchmark(kMessageBenchmarkMessages).Run(
+        kMessageBenchmarkDraws)) {
+      std::cout << "  " << result.generator << ": " << result.choice.count()
+          << " ns per choice, " << result.immediate_repeats << " immediate repeats" << std::endl;
+    }
+    return 0;
+  }
+  if (has_option("benchmark-cues")) {
+    std::cout << "cue mixing, mean of " << kCueBenchmarkBlocks << " blocks:" << std::endl;
+    for (const auto &result : textengine::AudioBenchmark(kAudioSampleRate).MixCues(
+        {kCueVoices / 2, kCueVoices, 2 * kCueVoices}, kCueBenchmarkBlocks)) {
+      std::cout << "  " << result.voice_count << " voices, "
+          << (result.vectorized ? "vectorized" : "scalar") << ": " << result.block.count()
+          << " us per block, " << 100.0 * result.load << "% of real time" << std::endl;
+    }
+    return 0;
+  }
+  const auto edit = has_option("edit");
+  // Saving an edit rewrites the scene file, which a lazy scene reads its messages from.
+  const auto lazy = !edit && has_option("lazy");
+  // A replay must see bodies appear on the same ticks as its recording did, so neither streams.
+  const auto record = !edit && has_option("record");
+  const auto replay = !edit && has_option("replay");
+  const auto stream = !edit && !record && !replay && has_option("stream");
+  const auto voice = !edit && !replay && has_option("voice");
+  const auto cues = !edit && !replay && has_option("cues");
+  const auto ambience = !edit && !replay && has_option("ambience");
+  const auto profile = has_option("profile");
+  textengine::Profiler::Enable(profile);
   textengine::Joystick joystick(GLFW_JOYSTICK_1);
   textengine::Keyboard keyboard;
   textengine::Mouse mouse;
   textengine::Input input(joystick, keyboard, mouse);
   textengine::Scene scene;
-  textengine::SceneLoader scene_loader;
-  scene = scene_loader.ReadScene(filename);
-  textengine::GameState initial_state{scene};
-  textengine::Log playtest_log(kPlaytestLog);
+  textengine::SceneLoader scene_loader(lazy ? kMessageCacheCapacity : 0);
+  scene = scene_loader.ReadScene(filename, *load_pool);
+  load_pool.reset();
+  const auto deflate_level = option_value("deflate-level");
+  if (has_option("benchmark-telemetry")) {
+    const auto level = deflate_level.empty() ? kDeflateLevel : std::stoi(deflate_level);
+    std::cout << "telemetry for " << scene.areas.size() + scene.objects.size() << " items over "
+        << kTelemetryBenchmarkTicks << " ticks, deflate level " << level << ":" << std::endl;
+    for (const auto &result : textengine::TelemetryBenchmark(scene, level).Run(
+        kTelemetryBenchmarkTicks)) {
+      std::cout << "  " << result.encoding << ": " << result.bytes / result.message_count
+          << " bytes, " << result.encode.count() / result.message_count << " ms per message"
+          << std::endl;
+    }
+    return 0;
+  }
+  const auto bodies_start = std::chrono::high_resolution_clock::now();
+  textengine::GameState initial_state{scene, !stream};
+  std::unique_ptr<textengine::WorldStreamer> world_streamer;
+  if (stream) {
+    world_streamer.reset(new textengine::WorldStreamer(
+        scene, initial_state, kStreamingChunkSize, kStreamingLoadRadius, kStreamingUnloadRadius,
+        kStreamingBodiesPerUpdate));
+    const auto position = initial_state.player_body->GetPosition();
+    world_streamer->LoadAround(glm::vec2(position.x, position.y));
+    world_streamer->Run();
+  }
+  const std::chrono::duration<double, std::milli> bodies =
+      std::chrono::high_resolution_clock::now() - bodies_start;
+  std::cout << "loaded " << scene_loader.statistics.item_count << " items: "
+      << "parse " << scene_loader.statistics.parse.count() << " ms, "
+      << "materialize " << scene_loader.statistics.materialize.count() << " ms, "
+      << "insert " << scene_loader.statistics.insert.count() << " ms, "
+      << "bodies " << bodies.count() << " ms" << std::endl;
+  const auto &trees = initial_state.tree_statistics;
+  if (trees.rebuilds) {
+    std::cout << "broad-phase: " << trees.proxy_count << " proxies, height " << trees.height
+        << ", balance " << trees.balance << ", area ratio " << trees.quality_before << " -> "
+        << trees.quality << ", rebuilt in " << trees.duration.count() << " ms" << std::endl;
+  }
+  if (world_streamer) {
+    std::cout << "streaming " << world_streamer->loaded_chunk_count() << " of "
+        << world_streamer->chunk_count() << " chunks, "
+        << world_streamer->item_count() << " items" << std::endl;
+  }
+  // Binary and gzipped logs go to files of their own rather than onto the end of a text log.
+  const auto binary_log = "binary" == option_value("log");
+  const auto gzip_log = has_option("gzip-log");
+  textengine::Log playtest_log(
+      std::string(kPlaytestLog) + (binary_log ? ".bin" : "") + (gzip_log ? ".gz" : ""),
+      binary_log ? textengine::Log::Format::kBinary : textengine::Log::Format::kText, gzip_log);
   textengine::SynchronizedQueue reply_queue, voice_queue;
+  textengine::Metrics::Watch("textengine_reply_queue_depth", "Replies waiting to be sent.",
+                             [&reply_queue] () { return reply_queue.size(); });
+  textengine::Metrics::Watch("textengine_voice_queue_depth", "Replies waiting to be spoken.",
+                             [&voice_queue] () { return voice_queue.size(); });
   textengine::Updater updater(
     kWindowWidth, kWindowHeight, reply_queue, voice_queue,
-    playtest_log, input, mouse, keyboard, initial_state, scene);
+    playtest_log, input, mouse, keyboard, initial_state, scene, world_streamer.get());
+  updater.SetSelectionPolicy(textengine::SelectionPolicy::kNonRepeating);
+  if (replay) {
+    textengine::Replay recording(kRecording);
+    updater.Seed(recording.seed());
+    updater.Setup();
+    textengine::InputFrame frame;
+    std::size_t message_count = 0;
+    const auto replay_start = std::chrono::high_resolution_clock::now();
+    while (recording.Read(frame)) {
+      updater.Tick(frame);
+      for (; reply_queue.HasMessage(); ++message_count) {
+        reply_queue.PopMessage();
+      }
+      while (voice_queue.HasMessage()) {
+        voice_queue.PopMessage();
+      }
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::high_resolution_clock::now() - replay_start;
+    const auto played = 0.016 * recording.tick_count();
+    const auto matches = !recording.digest() || recording.digest() == updater.digest();
+    std::cout << "replayed " << recording.tick_count() << " ticks (" << played << " s) in "
+        << elapsed.count() << " ms, " << 1000.0 * played / elapsed.count() << "x real time, "
+        << message_count << " messages, digest " << std::hex << updater.digest() << std::dec
+        << (recording.digest() ? matches ? ", matches recording" : ", DIFFERS from recording"
+                               : ", recording was not finished") << std::endl;
+    return matches ? 0 : 1;
+  }
+  std::unique_ptr<textengine::Recorder> recorder;
+  if (record) {
+    std::random_device device;
+    const auto seed = static_cast<std::uint64_t>(device()) << 32 | device();
+    recorder.reset(new textengine::Recorder(kRecording, seed));
+    updater.Seed(seed);
+    updater.SetRecorder(recorder.get());
+  }
   textengine::WebSocketPrompt prompt(reply_queue, kPrompt, playtest_log);
-  textengine::VoicePrompt voice_prompt(voice_queue);
+  if (has_option("deflate")) {
+    const auto window_bits = option_value("deflate-window");
+    prompt.Compress(kGameProtocol, deflate_level.empty() ? kDeflateLevel : std::stoi(deflate_level),
+                    window_bits.empty() ? kDeflateWindowBits : std::stoi(window_bits),
+                    !has_option("no-context-takeover"));
+  }
+  std::unique_ptr<textengine::AudioSink> audio_sink;
+  std::unique_ptr<textengine::SpeechSynthesizer> synthesizer;
+  std::unique_ptr<textengine::SpeechCache> speech_cache;
+  std::unique_ptr<textengine::CueMixer> cue_mixer;
+  std::unique_ptr<textengine::AmbiencePlayer> ambience_player;
+  std::unique_ptr<textengine::AudioEngine> audio_engine;
+  std::unique_ptr<textengine::VoicePrompt> voice_prompt;
+  if (voice || cues || ambience) {
+    if (has_option("mute")) {
+      audio_sink.reset(new textengine::NullAudioSink(kAudioSampleRate, true));
+    } else {
+      audio_sink.reset(new textengine::OpenAlAudioSink(kAudioSampleRate, kAudioBufferCount));
+    }
+    // Synthesized speech is saved as the clips that the clips option plays.
+    const auto clips = has_option("clips");
+    if (clips) {
+      synthesizer.reset(new textengine::ClipSpeechSynthesizer(kVoiceClips));
+    } else {
+      synthesizer.reset(new textengine::CommandSpeechSynthesizer());
+    }
+    speech_cache.reset(new textengine::SpeechCache(*synthesizer, clips ? "" : kVoiceClips,
+                                                   kAudioSampleRate, kVoiceCacheBytes));
+    if (cues) {
+      cue_mixer.reset(new textengine::CueMixer(kAudioSampleRate, kCueVoices));
+      updater.SetCueMixer(cue_mixer.get());
+    }
+    if (ambience) {
+      ambience_player.reset(new textengine::AmbiencePlayer(kAudioSampleRate));
+      updater.SetAmbiencePlayer(ambience_player.get());
+    }
+    audio_engine.reset(new textengine::AudioEngine(*audio_sink, *speech_cache));
+    if (cue_mixer) {
+      audio_engine->AddSource(*cue_mixer);
+    }
+    if (ambience_player) {
+      audio_engine->AddSource(*ambience_player);
+    }
+    if (voice) {
+      voice_prompt.reset(new textengine::VoicePrompt(voice_queue, *audio_engine));
+    }
+  }
   textengine::Editor editor(edit ? 2 * kWindowWidth : kWindowWidth, kWindowHeight, initial_state,
                             keyboard, mouse, scene);
   if (!edit) {
     prompt.Run();
-    if (voice) {
-      voice_prompt.Run();
+    if (ambience_player) {
+      ambience_player->Run();
+    }
+    if (audio_engine) {
+      audio_engine->Run();
+    }
+    if (voice_prompt) {
+      speech_cache->Warm(scene.MessageTexts());
+      voice_prompt->Run();
     }
   }
   textengine::Controller *controller = &updater;
@@ -60,6 +366,52 @@ int main(int argument_count, char *arguments[]) {
     kWindowTitle, *controller, renderer, input, joystick,
     keyboard, mouse, !edit);
   const auto result = application.Run();
+  if (recorder) {
+    recorder->Finish(updater.digest());
+  }
+  const auto &steps = initial_state.step_statistics;
+  if (steps.count) {
+    std::cout << "physics: " << steps.count << " steps, mean " << steps.total.count() / steps.count
+        << " ms, max " << steps.maximum.count() << " ms" << std::endl;
+  }
+  if (audio_engine) {
+    const auto speech = audio_engine->statistics();
+    if (speech.utterances) {
+      std::cout << "speech: " << speech.utterances << " utterances, " << speech.dropped
+          << " dropped, " << speech.failed << " failed, synthesis max "
+          << speech.maximum_synthesis.count() << " ms, latency mean "
+          << speech.latency.count() / speech.utterances << " ms, max "
+          << speech.maximum_latency.count() << " ms" << std::endl;
+    }
+  }
+  if (voice_prompt) {
+    const auto cache = speech_cache->statistics();
+    std::cout << "voice cache: " << cache.memory_hits << " memory hits, " << cache.disk_hits
+        << " disk hits, " << cache.synthesized << " synthesized, " << cache.failed << " failed, "
+        << cache.warmed << " warmed, " << cache.resident_bytes / 1024 << " KB resident"
+        << std::endl;
+  }
+  if (ambience_player) {
+    const auto streams = ambience_player->statistics();
+    if (streams.streams_opened) {
+      std::cout << "ambience: " << streams.streams_opened << " streams, " << streams.streams_failed
+          << " failed, " << streams.underruns << " underruns, decoding "
+          << streams.decoding.count() << " ms for " << streams.decoded_frames
+          << " frames, pass max " << streams.maximum_pass.count() << " ms, stream peak "
+          << streams.peak_stream_bytes / 1024 << " of "
+          << textengine::AmbiencePlayer::stream_bytes() / 1024 << " KB" << std::endl;
+    }
+  }
+  const auto logged = playtest_log.statistics();
+  std::cout << "log: " << logged.messages << " messages in " << logged.batches << " batches, "
+      << logged.bytes / 1024 << " KB, " << logged.dropped << " dropped" << std::endl;
+  if (profile) {
+    if (textengine::Profiler::WriteChromeTrace(kProfileTrace)) {
+      std::cout << "profile: trace written to " << kProfileTrace << std::endl;
+    } else {
+      std::cout << "profile: could not write " << kProfileTrace << std::endl;
+    }
+  }
   if (edit) {
     textengine::SceneSerializer serializer;
     serializer.WriteScene(filename, scene);
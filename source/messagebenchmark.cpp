@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "messagebenchmark.h"
+#include "messageselector.h"
+#include "scene.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr const char *kMessageName = u8"describe";
+    constexpr std::uint64_t kSeed = 1;
+
+    /** std::random_device may read the kernel each draw, so it gets fewer of them. */
+    constexpr std::size_t kRandomDeviceDivisor = 10;
+
+  }  // namespace
+
+  MessageBenchmark::MessageBenchmark(std::size_t message_count) : messages() {
+    std::unique_ptr<MessageList> list(new MessageList());
+    for (std::size_t i = 0; i < message_count; ++i) {
+      list->emplace_back(new std::string("message number " + std::to_string(i)));
+    }
+    messages.emplace(kMessageName, std::move(list));
+  }
+
+  std::vector<MessageBenchmark::Result> MessageBenchmark::Run(std::size_t draw_count) {
+    std::vector<Result> results;
+    const auto time = [this, &results] (const std::string &generator, std::size_t count,
+                                        const std::function<const std::string &()> &choose) {
+      Result result{generator, {}, 0};
+      const std::string *last = nullptr;
+      const auto start = std::chrono::high_resolution_clock::now();
+      for (std::size_t draw = 0; draw < count; ++draw) {
+        const auto &message = choose();
+        result.immediate_repeats += last == &message;
+        last = &message;
+      }
+      result.choice = std::chrono::duration<double, std::nano>(
+          std::chrono::high_resolution_clock::now() - start) / count;
+      results.push_back(result);
+    };
+    std::uniform_int_distribution<std::size_t> index_distribution;
+    std::random_device device;
+    time("std::random_device", draw_count / kRandomDeviceDivisor, [&] () -> const std::string & {
+      const auto &list = *messages.at(kMessageName);
+      return *list[index_distribution(device) % list.size()];
+    });
+    std::mt19937_64 twister(kSeed);
+    time("std::mt19937_64", draw_count, [&] () -> const std::string & {
+      const auto &list = *messages.at(kMessageName);
+      return *list[index_distribution(twister) % list.size()];
+    });
+    const std::pair<SelectionPolicy, const char *> policies[] = {
+      {SelectionPolicy::kUniform, "pcg32, uniform"},
+      {SelectionPolicy::kNonRepeating, "pcg32, non-repeating"},
+      {SelectionPolicy::kWeighted, "pcg32, weighted"}
+    };
+    for (const auto &policy : policies) {
+      MessageSelector selector(policy.first, kSeed);
+      time(policy.second, draw_count, [&] () -> const std::string & {
+        return selector.Choose(*messages.at(kMessageName));
+      });
+    }
+    return results;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,40 @@
+#ifndef __textengine__messagebenchmark__
+#define __textengine__messagebenchmark__
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "scene.h"
+
+namespace textengine {
+
+  /**
+   * Times choosing one of a list of messages as Updater::ChooseMessage does, map lookups
+   * included: first with the std::random_device and std::mt19937_64 generators it used to draw
+   * from, then through a MessageSelector under each policy.
+   */
+  class MessageBenchmark {
+  public:
+    struct Result {
+      std::string generator;
+      std::chrono::duration<double, std::nano> choice;
+
+      /** Draws that chose the same message as the draw before. */
+      std::size_t immediate_repeats;
+    };
+
+    explicit MessageBenchmark(std::size_t message_count);
+
+    virtual ~MessageBenchmark() = default;
+
+    std::vector<Result> Run(std::size_t draw_count);
+
+  private:
+    MessageMap messages;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__messagebenchmark__) */
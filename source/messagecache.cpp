@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <fstream>
+#include <picojson.h>
+#include <string>
+
+#include "checks.h"
+#include "messagecache.h"
+#include "scene.h"
+
+namespace textengine {
+
+  MessageCache::MessageCache(const std::string &filename, std::size_t capacity)
+  : in(filename, std::ios_base::binary), capacity(std::max<std::size_t>(capacity, 1)),
+    scene_loader(), entries(), entries_by_offset() {
+    CHECK_STATE(!in.fail());
+  }
+
+  void MessageCache::Evict(const MessageSpan &span) {
+    const auto entry = entries_by_offset.find(span.begin);
+    if (entries_by_offset.cend() != entry) {
+      entries.erase(entry->second);
+      entries_by_offset.erase(entry);
+    }
+  }
+
+  const MessageMap &MessageCache::Get(const MessageSpan &span) {
+    const auto entry = entries_by_offset.find(span.begin);
+    if (entries_by_offset.cend() != entry) {
+      entries.splice(entries.begin(), entries, entry->second);
+      return entry->second->second;
+    }
+    if (entries.size() >= capacity) {
+      entries_by_offset.erase(entries.back().first);
+      entries.pop_back();
+    }
+    entries.emplace_front(span.begin, Read(span));
+    entries_by_offset.emplace(span.begin, entries.begin());
+    return entries.front().second;
+  }
+
+  std::size_t MessageCache::size() const {
+    return entries.size();
+  }
+
+  MessageMap MessageCache::Read(const MessageSpan &span) {
+    std::string text(span.end - span.begin, '\0');
+    in.clear();
+    in.seekg(span.begin);
+    in.read(&text[0], text.size());
+    CHECK_STATE(static_cast<std::size_t>(in.gcount()) == text.size());
+    picojson::value messages;
+    std::string error;
+    picojson::parse(messages, text.cbegin(), text.cend(), &error);
+    if (!error.empty()) {
+      FAIL(error);
+    }
+    return scene_loader.ReadMessageMap(messages);
+  }
+
+}  // namespace textengine
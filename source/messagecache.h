@@ -0,0 +1,47 @@
+#ifndef __textengine__messagecache__
+#define __textengine__messagecache__
+
+#include <cstddef>
+#include <fstream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "scene.h"
+#include "sceneloader.h"
+
+namespace textengine {
+
+  /**
+   * Reads lazily loaded message maps back out of a scene file on demand, keeping at most
+   * capacity of them resident and evicting the least recently used.
+   */
+  class MessageCache {
+  public:
+    MessageCache(const std::string &filename, std::size_t capacity);
+
+    virtual ~MessageCache() = default;
+
+    void Evict(const MessageSpan &span);
+
+    const MessageMap &Get(const MessageSpan &span);
+
+    std::size_t size() const;
+
+  private:
+    using Entry = std::pair<std::size_t, MessageMap>;
+
+    MessageMap Read(const MessageSpan &span);
+
+  private:
+    std::ifstream in;
+    std::size_t capacity;
+    SceneLoader scene_loader;
+    std::list<Entry> entries;
+    std::unordered_map<std::size_t, std::list<Entry>::iterator> entries_by_offset;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__messagecache__) */
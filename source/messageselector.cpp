@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "messageselector.h"
+#include "scene.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** The 64-bit FNV prime, which spreads each message's hash across the whole key. */
+    constexpr std::uint64_t kKeyMultiplier = 1099511628211ull;
+
+  }  // namespace
+
+  MessageSelector::MessageSelector(SelectionPolicy policy, std::uint64_t seed)
+  : policy(policy), generator(seed), histories() {}
+
+  const std::string &MessageSelector::Choose(const MessageList &messages) {
+    const auto count = static_cast<std::uint32_t>(messages.size());
+    if (1 == count) {
+      return *messages.front();
+    }
+    switch (policy) {
+      case SelectionPolicy::kNonRepeating:
+        return *messages[ChooseNonRepeating(FindHistory(messages))];
+      case SelectionPolicy::kWeighted:
+        return *messages[ChooseWeighted(FindHistory(messages))];
+      default:
+        return *messages[generator.Below(count)];
+    }
+  }
+
+  void MessageSelector::Seed(std::uint64_t seed) {
+    generator.Seed(seed);
+    histories.clear();
+  }
+
+  void MessageSelector::SetPolicy(SelectionPolicy policy) {
+    MessageSelector::policy = policy;
+    histories.clear();
+  }
+
+  MessageSelector::History &MessageSelector::FindHistory(const MessageList &messages) {
+    const auto count = static_cast<std::uint32_t>(messages.size());
+    // Every message goes into the key, so lists that share a first message still have
+    // histories of their own. Keys never leave the process, so std::hash, which is much faster
+    // than hashing a byte at a time, will do.
+    std::uint64_t key = count;
+    for (const auto &message : messages) {
+      key = (key ^ std::hash<std::string>()(*message)) * kKeyMultiplier;
+    }
+    auto &history = histories[key];
+    if (count != history.values.size()) {
+      // A list not chosen from since the histories were last cleared.
+      history.values.resize(count);
+      if (SelectionPolicy::kNonRepeating == policy) {
+        for (std::uint32_t i = 0; i < count; ++i) {
+          history.values[i] = i;
+        }
+      } else {
+        std::fill(history.values.begin(), history.values.end(), 0);
+      }
+      history.draws = count;
+    }
+    return history;
+  }
+
+  // values is the order of the current round and draws how far into it we are.
+  std::uint32_t MessageSelector::ChooseNonRepeating(History &history) {
+    const auto count = static_cast<std::uint32_t>(history.values.size());
+    if (count == history.draws) {
+      const auto last = history.values.back();
+      for (auto i = count - 1; i > 0; --i) {
+        std::swap(history.values[i], history.values[generator.Below(i + 1)]);
+      }
+      // Do not say the last message of one round first in the next.
+      if (last == history.values.front()) {
+        std::swap(history.values.front(), history.values[1 + generator.Below(count - 1)]);
+      }
+      history.draws = 0;
+    }
+    return history.values[history.draws++];
+  }
+
+  // values holds the draw on which each message was last said and draws counts every draw.
+  std::uint32_t MessageSelector::ChooseWeighted(History &history) {
+    const auto count = static_cast<std::uint32_t>(history.values.size());
+    std::uint32_t total = 0;
+    for (const auto last : history.values) {
+      total += std::min(history.draws - last, count);
+    }
+    auto target = generator.Below(total);
+    std::uint32_t chosen = 0;
+    for (; chosen < count - 1; ++chosen) {
+      const auto weight = std::min(history.draws - history.values[chosen], count);
+      if (target < weight) {
+        break;
+      }
+      target -= weight;
+    }
+    history.values[chosen] = history.draws++;
+    return chosen;
+  }
+
+}  // namespace textengine
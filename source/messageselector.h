@@ -0,0 +1,70 @@
+#ifndef __textengine__messageselector__
+#define __textengine__messageselector__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pcg32.h"
+#include "scene.h"
+
+namespace textengine {
+
+  enum class SelectionPolicy {
+    /** Every message is equally likely each time. */
+    kUniform,
+
+    /** Every message is said once, in random order, before any is said again. */
+    kNonRepeating,
+
+    /** A message's weight grows with the number of draws since it was last said. */
+    kWeighted
+  };
+
+  /**
+   * Chooses which of a list of alternative messages to say. Lists are remembered by content
+   * rather than address, so a list evicted from the message cache and read again keeps its
+   * history and a replay makes the same choices.
+   */
+  class MessageSelector {
+  public:
+    explicit MessageSelector(SelectionPolicy policy = SelectionPolicy::kUniform,
+                             std::uint64_t seed = 0);
+
+    virtual ~MessageSelector() = default;
+
+    /**
+     * Returns one of messages, which must not be empty.
+     */
+    const std::string &Choose(const MessageList &messages);
+
+    /**
+     * Restarts the generator and forgets every list's history.
+     */
+    void Seed(std::uint64_t seed);
+
+    void SetPolicy(SelectionPolicy policy);
+
+  private:
+    struct History {
+      std::vector<std::uint32_t> values;
+      std::uint32_t draws;
+    };
+
+    History &FindHistory(const MessageList &messages);
+
+    std::uint32_t ChooseNonRepeating(History &history);
+
+    std::uint32_t ChooseWeighted(History &history);
+
+  private:
+    SelectionPolicy policy;
+    Pcg32 generator;
+    /** Keyed by a hash of every message in the list. */
+    std::unordered_map<std::uint64_t, History> histories;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__messageselector__) */
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "metrics.h"
+
+namespace textengine {
+
+  namespace {
+
+    struct Description {
+      const char *name, *help;
+    };
+
+    constexpr Description kCounters[] = {
+      {"textengine_websocket_messages_sent_total", "Messages sent to websocket clients."},
+      {"textengine_websocket_bytes_sent_total", "Bytes of messages sent to websocket clients."},
+      {"textengine_telemetry_dropped_total",
+       "Telemetry replaced by newer telemetry before it was sent."}
+    };
+
+    constexpr Description kHistograms[] = {
+      {"textengine_frame_seconds", "Time from the start of one frame to the next."},
+      {"textengine_physics_step_seconds", "Time spent in each physics step."}
+    };
+
+    /** Upper bounds in seconds, around the sixteen milliseconds of a frame. */
+    constexpr double kBucketBounds[] = {
+      0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033, 0.066, 0.133, 0.25
+    };
+
+    constexpr std::size_t kBucketCount = sizeof(kBucketBounds) / sizeof(kBucketBounds[0]);
+
+    struct Shard {
+      std::array<std::atomic<std::uint64_t>, Metrics::kCounterCount> counters;
+
+      /** Per histogram, counts by bucket, the last for any longer, then the sum in nanoseconds. */
+      std::array<std::array<std::atomic<std::uint64_t>, kBucketCount + 2>,
+                 Metrics::kHistogramCount> histograms;
+
+      /** Whether a live thread owns it. Guarded by the registry mutex. */
+      bool owned;
+    };
+
+    struct Gauge {
+      std::string name, help;
+      const char *type;
+      std::function<double()> read;
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Gauge> gauges;
+
+    /** Gives the thread's shard back when the thread ends. */
+    struct LocalShard {
+      Shard *shard;
+
+      ~LocalShard() {
+        if (shard) {
+          std::lock_guard<std::mutex> lock(registry_mutex);
+          shard->owned = false;
+        }
+      }
+    };
+
+    thread_local LocalShard local_shard;
+
+    Shard &AcquireShard() {
+      if (local_shard.shard) {
+        return *local_shard.shard;
+      }
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      for (const auto &shard : shards) {
+        if (!shard->owned) {
+          shard->owned = true;
+          return *(local_shard.shard = shard.get());
+        }
+      }
+      shards.emplace_back(new Shard());
+      shards.back()->owned = true;
+      return *(local_shard.shard = shards.back().get());
+    }
+
+    /** Only the owning thread writes, so there is no need for fetch_add and its lock prefix. */
+    void Increase(std::atomic<std::uint64_t> &value, std::uint64_t amount) {
+      value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void WriteHeader(std::ostringstream &out, const std::string &name, const std::string &help,
+                     const char *type) {
+      out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+
+  }  // namespace
+
+  void Metrics::Add(Counter counter, std::uint64_t amount) {
+    Increase(AcquireShard().counters[counter], amount);
+  }
+
+  void Metrics::Observe(Histogram histogram, std::chrono::duration<double> duration) {
+    auto &buckets = AcquireShard().histograms[histogram];
+    const auto bucket = std::lower_bound(std::begin(kBucketBounds), std::end(kBucketBounds),
+                                         duration.count()) - std::begin(kBucketBounds);
+    Increase(buckets[bucket], 1);
+    Increase(buckets[kBucketCount + 1],
+             std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  }
+
+  void Metrics::Watch(const std::string &name, const std::string &help,
+                      std::function<double()> gauge) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    gauges.push_back(Gauge{name, help, "gauge", std::move(gauge)});
+  }
+
+  void Metrics::WatchTotal(const std::string &name, const std::string &help,
+                           std::function<double()> total) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    gauges.push_back(Gauge{name, help, "counter", std::move(total)});
+  }
+
+  std::string Metrics::Export() {
+    std::array<std::uint64_t, kCounterCount> counters{};
+    std::array<std::array<std::uint64_t, kBucketCount + 2>, kHistogramCount> histograms{};
+    std::vector<Gauge> watched;
+    {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      for (const auto &shard : shards) {
+        for (std::size_t i = 0; i < kCounterCount; ++i) {
+          counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < kHistogramCount; ++i) {
+          for (std::size_t j = 0; j < kBucketCount + 2; ++j) {
+            histograms[i][j] += shard->histograms[i][j].load(std::memory_order_relaxed);
+          }
+        }
+      }
+      watched = gauges;
+    }
+    std::ostringstream out;
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+      WriteHeader(out, kCounters[i].name, kCounters[i].help, "counter");
+      out << kCounters[i].name << " " << counters[i] << "\n";
+    }
+    for (std::size_t i = 0; i < kHistogramCount; ++i) {
+      const std::string name = kHistograms[i].name;
+      WriteHeader(out, name, kHistograms[i].help, "histogram");
+      std::uint64_t cumulative = 0;
+      for (std::size_t j = 0; j <= kBucketCount; ++j) {
+        cumulative += histograms[i][j];
+        out << name << "_bucket{le=\"";
+        if (j < kBucketCount) {
+          out << kBucketBounds[j];
+        } else {
+          out << "+Inf";
+        }
+        out << "\"} " << cumulative << "\n";
+      }
+      out << name << "_sum " << std::to_string(histograms[i][kBucketCount + 1] / 1e9) << "\n";
+      out << name << "_count " << cumulative << "\n";
+    }
+    // Read outside the registry lock, since a gauge may take a lock under which others count.
+    for (const auto &gauge : watched) {
+      WriteHeader(out, gauge.name, gauge.help, gauge.type);
+      out << gauge.name << " " << std::to_string(gauge.read()) << "\n";
+    }
+    return out.str();
+  }
+
+}  // namespace textengine
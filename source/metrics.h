@@ -0,0 +1,58 @@
+#ifndef __textengine__metrics__
+#define __textengine__metrics__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace textengine {
+
+  /**
+   * Counts what the engine does, for export in the Prometheus text format at /metrics.
+   *
+   * Each thread counts into a shard of its own. The shard has one writer, so Add and Observe
+   * are a relaxed load and store apiece, with no lock and no read-modify-write; Export sums
+   * every shard. A shard outlives its thread and passes to the next thread started, so totals
+   * are never lost and threads that come and go reuse a bounded number of shards.
+   *
+   * Gauges are not counted but read when exported, from functions registered with Watch; so are
+   * totals counted elsewhere, registered with WatchTotal.
+   */
+  class Metrics {
+  public:
+    enum Counter {
+      kMessagesSent,
+      kBytesSent,
+      kTelemetryDropped,
+      kCounterCount
+    };
+
+    enum Histogram {
+      kFrameTime,
+      kStepTime,
+      kHistogramCount
+    };
+
+    static void Add(Counter counter, std::uint64_t amount = 1);
+
+    static void Observe(Histogram histogram, std::chrono::duration<double> duration);
+
+    /**
+     * Exports gauge under name, which must outlive every later Export.
+     */
+    static void Watch(const std::string &name, const std::string &help,
+                      std::function<double()> gauge);
+
+    /**
+     * Like Watch, for a total that only grows, which is exported as a counter.
+     */
+    static void WatchTotal(const std::string &name, const std::string &help,
+                           std::function<double()> total);
+
+    static std::string Export();
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__metrics__) */
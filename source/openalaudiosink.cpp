@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#include "checks.h"
+#include "openalaudiosink.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** OpenAL has no completion callback, so a full queue is polled at about a tenth of a block. */
+    constexpr auto kPollInterval = std::chrono::milliseconds(1);
+
+  }  // namespace
+
+  OpenAlAudioSink::OpenAlAudioSink(int sample_rate, std::size_t buffer_count)
+  : rate(sample_rate), device(alcOpenDevice(nullptr)), context(), source(),
+    buffers(buffer_count), free_buffers() {
+    CHECK_STATE(device);
+    context = alcCreateContext(device, nullptr);
+    CHECK_STATE(context);
+    alcMakeContextCurrent(context);
+    alGenSources(1, &source);
+    alGenBuffers(static_cast<ALsizei>(buffers.size()), buffers.data());
+    CHECK_STATE(AL_NO_ERROR == alGetError());
+    free_buffers = buffers;
+  }
+
+  OpenAlAudioSink::~OpenAlAudioSink() {
+    alSourceStop(source);
+    alSourcei(source, AL_BUFFER, 0);
+    alDeleteSources(1, &source);
+    alDeleteBuffers(static_cast<ALsizei>(buffers.size()), buffers.data());
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+  }
+
+  void OpenAlAudioSink::Write(const short *samples, std::size_t frame_count) {
+    // Reclaim every processed buffer, even with some free, since a stopped source played again
+    // would start over from the first buffer still queued.
+    while (true) {
+      ALint processed = 0;
+      alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+      if (processed) {
+        const auto count = free_buffers.size();
+        free_buffers.resize(count + processed);
+        alSourceUnqueueBuffers(source, processed, free_buffers.data() + count);
+      }
+      if (!free_buffers.empty()) {
+        break;
+      }
+      std::this_thread::sleep_for(kPollInterval);
+    }
+    const auto buffer = free_buffers.back();
+    free_buffers.pop_back();
+    alBufferData(buffer, AL_FORMAT_STEREO16, samples,
+                 static_cast<ALsizei>(2 * sizeof(short) * frame_count), rate);
+    alSourceQueueBuffers(source, 1, &buffer);
+    // The source stops when it runs out, after an underrun or while the engine was idle.
+    ALint state;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    if (AL_PLAYING != state) {
+      alSourcePlay(source);
+    }
+  }
+
+  int OpenAlAudioSink::sample_rate() const {
+    return rate;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,42 @@
+#ifndef __textengine__openalaudiosink__
+#define __textengine__openalaudiosink__
+
+#ifdef __APPLE__
+#include <OpenAL/al.h>
+#include <OpenAL/alc.h>
+#else
+#include <AL/al.h>
+#include <AL/alc.h>
+#endif
+#include <cstddef>
+#include <vector>
+
+#include "audiosink.h"
+
+namespace textengine {
+
+  /**
+   * Streams to the default output device through a single OpenAL source fed from a small ring of
+   * buffers, so the mixer stays at most buffer_count writes ahead of what is heard.
+   */
+  class OpenAlAudioSink : public AudioSink {
+  public:
+    OpenAlAudioSink(int sample_rate, std::size_t buffer_count);
+
+    virtual ~OpenAlAudioSink();
+
+    virtual void Write(const short *samples, std::size_t frame_count) override;
+
+    virtual int sample_rate() const override;
+
+  private:
+    int rate;
+    ALCdevice *device;
+    ALCcontext *context;
+    ALuint source;
+    std::vector<ALuint> buffers, free_buffers;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__openalaudiosink__) */
@@ -0,0 +1,85 @@
+#ifndef __textengine__pcg32__
+#define __textengine__pcg32__
+
+#include <cstdint>
+#include <limits>
+
+namespace textengine {
+
+  /**
+   * A PCG-XSH-RR 64/32 generator: eight bytes of state, a multiply and a rotate per draw, and
+   * seedable, unlike std::random_device. It models UniformRandomBitGenerator, so it plugs into
+   * the std distributions.
+   *
+   * Generators with the same seed but different streams produce independent sequences, so
+   * parallel workers each take Stream(worker) of a common generator and stay reproducible
+   * however the work is scheduled.
+   */
+  class Pcg32 {
+  public:
+    using result_type = std::uint32_t;
+
+    explicit Pcg32(std::uint64_t seed = kDefaultSeed, std::uint64_t stream = 0)
+    : state(), increment(), seed() {
+      Seed(seed, stream);
+    }
+
+    static constexpr result_type min() {
+      return std::numeric_limits<result_type>::min();
+    }
+
+    static constexpr result_type max() {
+      return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+      const auto previous = state;
+      state = previous * kMultiplier + increment;
+      const auto shifted = static_cast<std::uint32_t>(((previous >> 18) ^ previous) >> 27);
+      const auto rotation = static_cast<std::uint32_t>(previous >> 59);
+      return (shifted >> rotation) | (shifted << ((~rotation + 1) & 31));
+    }
+
+    /**
+     * Draws uniformly from [0, bound) without modulo bias, using Lemire's multiply-and-shift so
+     * that a division is needed only on the rare rejected draw.
+     */
+    std::uint32_t Below(std::uint32_t bound) {
+      auto product = static_cast<std::uint64_t>((*this)()) * bound;
+      auto low = static_cast<std::uint32_t>(product);
+      if (low < bound) {
+        const auto threshold = (~bound + 1) % bound;
+        while (low < threshold) {
+          product = static_cast<std::uint64_t>((*this)()) * bound;
+          low = static_cast<std::uint32_t>(product);
+        }
+      }
+      return static_cast<std::uint32_t>(product >> 32);
+    }
+
+    void Seed(std::uint64_t seed, std::uint64_t stream = 0) {
+      state = 0;
+      increment = stream << 1 | 1;
+      (*this)();
+      state += seed;
+      (*this)();
+      Pcg32::seed = seed;
+    }
+
+    /**
+     * A generator with this one's seed on another stream.
+     */
+    Pcg32 Stream(std::uint64_t stream) const {
+      return Pcg32(seed, stream);
+    }
+
+  private:
+    static constexpr std::uint64_t kDefaultSeed = 0x853c49e6748fea9bull;
+    static constexpr std::uint64_t kMultiplier = 6364136223846793005ull;
+
+    std::uint64_t state, increment, seed;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__pcg32__) */
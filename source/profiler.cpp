@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+namespace textengine {
+
+  namespace {
+
+    using Clock = Profiler::Clock;
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    /** Per thread; at sixty frames a second and a few dozen scopes a frame, about ten seconds. */
+    constexpr std::size_t kRingCapacity = 32 * 1024;
+
+    /** Atomic only so that readers may copy while the owner writes; every access is relaxed. */
+    struct Event {
+      std::atomic<const char *> name;
+      std::atomic<Clock::rep> begin, end;
+    };
+
+    struct Ring {
+      std::array<Event, kRingCapacity> events;
+      std::atomic<std::uint64_t> written;
+
+      /** Whether a live thread owns it. Guarded by the registry mutex. */
+      bool owned;
+    };
+
+    struct Copy {
+      const char *name;
+      Clock::rep begin, end;
+      std::size_t thread;
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    /** Gives the thread's ring back when the thread ends. */
+    struct LocalRing {
+      Ring *ring;
+
+      ~LocalRing() {
+        if (ring) {
+          std::lock_guard<std::mutex> lock(registry_mutex);
+          ring->owned = false;
+        }
+      }
+    };
+
+    thread_local LocalRing local_ring;
+
+    Ring *AcquireRing() {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      for (const auto &ring : rings) {
+        if (!ring->owned) {
+          ring->owned = true;
+          return ring.get();
+        }
+      }
+      rings.emplace_back(new Ring());
+      rings.back()->owned = true;
+      return rings.back().get();
+    }
+
+    /**
+     * Appends the events of ring that ended at or after since, newest first. The registry mutex
+     * must be held.
+     */
+    void CopyRing(const Ring &ring, std::size_t thread, Clock::rep since, std::vector<Copy> &out) {
+      const auto written = ring.written.load(std::memory_order_acquire);
+      const auto oldest = written > kRingCapacity ? written - kRingCapacity : 0;
+      const auto start = out.size();
+      // Events are recorded as their scopes end, so going back in the ring goes back in time.
+      for (auto index = written; index > oldest; --index) {
+        const auto &event = ring.events[(index - 1) % kRingCapacity];
+        const auto end = event.end.load(std::memory_order_relaxed);
+        if (end < since) {
+          break;
+        }
+        out.push_back(Copy{event.name.load(std::memory_order_relaxed),
+                           event.begin.load(std::memory_order_relaxed), end, thread});
+      }
+      // Whatever the owner wrote meanwhile overwrote the oldest events, which may now be torn.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const auto after = ring.written.load(std::memory_order_relaxed);
+      const auto first_intact = after >= kRingCapacity ? after - kRingCapacity + 1 : 0;
+      const auto intact = written > first_intact ? written - first_intact : 0;
+      out.resize(start + std::min<std::size_t>(out.size() - start, intact));
+    }
+
+    std::vector<Copy> CopyRings(Clock::rep since) {
+      std::vector<Copy> events;
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      for (std::size_t i = 0; i < rings.size(); ++i) {
+        CopyRing(*rings[i], i, since, events);
+      }
+      return events;
+    }
+
+  }  // namespace
+
+  std::atomic<bool> Profiler::enabled_flag;
+
+  void Profiler::Enable(bool enabled) {
+    enabled_flag.store(enabled, std::memory_order_relaxed);
+  }
+
+  void Profiler::Record(const char *name, Clock::time_point begin, Clock::time_point end) {
+    auto ring = local_ring.ring;
+    if (!ring) {
+      ring = local_ring.ring = AcquireRing();
+    }
+    const auto index = ring->written.load(std::memory_order_relaxed);
+    auto &event = ring->events[index % kRingCapacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin.time_since_epoch().count(), std::memory_order_relaxed);
+    event.end.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+    ring->written.store(index + 1, std::memory_order_release);
+  }
+
+  std::vector<Profiler::Summary> Profiler::Summarize(std::chrono::milliseconds window) {
+    const auto since = Clock::now() - window;
+    std::map<std::string, Summary> summaries;
+    for (const auto &event : CopyRings(since.time_since_epoch().count())) {
+      auto &summary = summaries[event.name];
+      const std::chrono::duration<double, std::milli> elapsed =
+          Clock::duration(event.end - event.begin);
+      summary.count += 1;
+      summary.total += elapsed;
+      summary.maximum = std::max(summary.maximum, elapsed);
+    }
+    std::vector<Summary> result;
+    for (auto &entry : summaries) {
+      entry.second.name = entry.first;
+      result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(), [] (const Summary &a, const Summary &b) {
+      return a.total > b.total;
+    });
+    return result;
+  }
+
+  bool Profiler::WriteChromeTrace(const std::string &filename) {
+    auto events = CopyRings(std::numeric_limits<Clock::rep>::min());
+    std::ofstream out(filename);
+    auto origin = std::numeric_limits<Clock::rep>::max();
+    for (const auto &event : events) {
+      origin = std::min(origin, event.begin);
+    }
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      const auto &event = events[i];
+      out << (i ? ",\n" : "\n") << "{\"name\":\"" << event.name
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+          << ",\"ts\":" << Microseconds(Clock::duration(event.begin - origin)).count()
+          << ",\"dur\":" << Microseconds(Clock::duration(event.end - event.begin)).count() << "}";
+    }
+    out << "\n]}" << std::endl;
+    out.close();
+    return !out.fail();
+  }
+
+}  // namespace textengine
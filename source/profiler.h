@@ -0,0 +1,89 @@
+#ifndef __textengine__profiler__
+#define __textengine__profiler__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+
+/**
+ * Times the rest of the enclosing block under name, which must be a string literal.
+ */
+#define PROFILE_SCOPE(name) \
+    ::textengine::ProfileScope PROFILE_CONCATENATE(profile_scope_, __LINE__)(name)
+
+namespace textengine {
+
+  /**
+   * Records timed scopes from any thread for a Chrome trace and a live summary.
+   *
+   * Each thread writes its events into a fixed ring of its own, without locks or allocation,
+   * so a scope costs two clock reads and a few stores; while disabled it costs a load and a
+   * branch. Readers copy the rings as they are being written and drop any event that was
+   * overwritten meanwhile. A ring outlives its thread and passes to the next thread started,
+   * so threads that come and go reuse a bounded number of rings.
+   */
+  class Profiler {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Summary {
+      std::string name;
+      std::size_t count;
+      std::chrono::duration<double, std::milli> total, maximum;
+    };
+
+    /**
+     * Starts or stops recording, which is off until first enabled.
+     */
+    static void Enable(bool enabled);
+
+    static bool enabled() {
+      return enabled_flag.load(std::memory_order_relaxed);
+    }
+
+    static void Record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+    /**
+     * Summarizes, by name and most time first, the events that ended within window of now.
+     */
+    static std::vector<Summary> Summarize(std::chrono::milliseconds window);
+
+    /**
+     * Writes the events still held in the Chrome trace event format, which chrome://tracing
+     * and Perfetto read. Returns whether that succeeded.
+     */
+    static bool WriteChromeTrace(const std::string &filename);
+
+  private:
+    static std::atomic<bool> enabled_flag;
+  };
+
+  class ProfileScope {
+  public:
+    explicit ProfileScope(const char *name)
+    : name(Profiler::enabled() ? name : nullptr),
+      begin(ProfileScope::name ? Profiler::Clock::now() : Profiler::Clock::time_point()) {}
+
+    ProfileScope(const ProfileScope &) = delete;
+
+    ProfileScope &operator =(const ProfileScope &) = delete;
+
+    ~ProfileScope() {
+      if (name) {
+        Profiler::Record(name, begin, Profiler::Clock::now());
+      }
+    }
+
+  private:
+    const char *name;
+    Profiler::Clock::time_point begin;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__profiler__) */
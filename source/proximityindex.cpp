@@ -0,0 +1,146 @@
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <glm/glm.hpp>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "proximityindex.h"
+#include "scene.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** The half extent of the first box searched around the position. */
+    constexpr float kInitialRadius = 8.0f;
+
+    bool Louder(const std::pair<float, Handle> &a, const std::pair<float, Handle> &b) {
+      return a.first < b.first || (a.first == b.first && a.second.index < b.second.index);
+    }
+
+  }  // namespace
+
+  ProximityIndex::ProximityIndex()
+  : tree(), entries(), count(), bounds(), minimum_base(), minimum_linear(), minimum_quadratic() {}
+
+  void ProximityIndex::Build(Scene &scene, const std::string &key) {
+    for (std::size_t proxy = 0; proxy < entries.size(); ++proxy) {
+      if (entries[proxy].item) {
+        tree.DestroyProxy(static_cast<int32>(proxy));
+      }
+    }
+    entries.clear();
+    count = 0;
+    bounds = AxisAlignedBoundingBox{glm::vec2(std::numeric_limits<float>::infinity()),
+                                    glm::vec2(-std::numeric_limits<float>::infinity())};
+    minimum_base = minimum_linear = minimum_quadratic = std::numeric_limits<float>::infinity();
+    for (auto store : {&scene.areas, &scene.objects}) {
+      for (const auto &object : *store) {
+        if (!scene.HasMessage(store->description(object), key)) {
+          continue;
+        }
+        auto extent = object.aabb;
+        if (Shape::kCircle == object.shape) {
+          extent.minimum = object.aabb.center() - object.aabb.radius();
+          extent.maximum = object.aabb.center() + object.aabb.radius();
+        }
+        b2AABB aabb;
+        aabb.lowerBound.Set(extent.minimum.x, extent.minimum.y);
+        aabb.upperBound.Set(extent.maximum.x, extent.maximum.y);
+        const auto proxy = static_cast<std::size_t>(tree.CreateProxy(aabb, nullptr));
+        if (entries.size() <= proxy) {
+          entries.resize(proxy + 1);
+        }
+        entries[proxy] = Entry{store->handle(object), object};
+        ++count;
+        bounds.minimum = glm::min(bounds.minimum, extent.minimum);
+        bounds.maximum = glm::max(bounds.maximum, extent.maximum);
+        minimum_base = std::min(minimum_base, object.base_attenuation);
+        minimum_linear = std::min(minimum_linear, object.linear_attenuation);
+        minimum_quadratic = std::min(minimum_quadratic, object.quadratic_attenuation);
+      }
+    }
+    tree.RebuildTopDown();
+  }
+
+  void ProximityIndex::Nearest(glm::vec2 position, std::size_t k,
+                               const std::function<bool(Handle)> &accept,
+                               std::vector<Handle> &nearest) const {
+    nearest.clear();
+    if (!k || !count) {
+      return;
+    }
+    // A box this large around position holds every item.
+    const auto everything = glm::max(glm::abs(bounds.minimum - position),
+                                     glm::abs(bounds.maximum - position));
+    const auto reach = std::max(everything.x, everything.y);
+    std::vector<Candidate> best;
+    auto radius = std::min(kInitialRadius, reach);
+    while (true) {
+      best.clear();
+      b2AABB box;
+      box.lowerBound.Set(position.x - radius, position.y - radius);
+      box.upperBound.Set(position.x + radius, position.y + radius);
+      Query query{*this, position, k, accept, best};
+      tree.Query(&query, box);
+      if (radius >= reach) {
+        break;
+      }
+      if (best.size() == k) {
+        // Anything farther out attenuates more than the kth best, which is itself inside.
+        const auto bound = RadiusFor(best.back().first);
+        if (bound <= radius) {
+          break;
+        }
+        radius = std::min(bound, reach);
+      } else {
+        radius = std::min(4.0f * radius, reach);
+      }
+    }
+    for (const auto &candidate : best) {
+      nearest.push_back(candidate.second);
+    }
+  }
+
+  std::size_t ProximityIndex::size() const {
+    return count;
+  }
+
+  float ProximityIndex::RadiusFor(float attenuation) const {
+    if (minimum_linear < 0.0f || minimum_quadratic < 0.0f) {
+      return std::numeric_limits<float>::infinity();
+    }
+    const auto excess = attenuation - minimum_base;
+    if (excess <= 0.0f) {
+      return 0.0f;
+    } else if (minimum_quadratic > 0.0f) {
+      return (std::sqrt(minimum_linear * minimum_linear + 4.0f * minimum_quadratic * excess)
+              - minimum_linear) / (2.0f * minimum_quadratic);
+    } else if (minimum_linear > 0.0f) {
+      return excess / minimum_linear;
+    } else {
+      return std::numeric_limits<float>::infinity();
+    }
+  }
+
+  bool ProximityIndex::Query::QueryCallback(int32 proxy) {
+    const auto &entry = index.entries[proxy];
+    if (!accept(entry.item)) {
+      return true;
+    }
+    const Candidate candidate{entry.object.attenuation(position), entry.item};
+    if (best.size() < k || Louder(candidate, best.back())) {
+      best.insert(std::upper_bound(best.begin(), best.end(), candidate, Louder), candidate);
+      if (best.size() > k) {
+        best.pop_back();
+      }
+    }
+    return true;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,80 @@
+#ifndef __textengine__proximityindex__
+#define __textengine__proximityindex__
+
+#include <Box2D/Box2D.h>
+#include <cstddef>
+#include <functional>
+#include <glm/glm.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "handle.h"
+#include "scene.h"
+
+namespace textengine {
+
+  /**
+   * Finds the items that sound loudest from a position, that is the k with the least attenuation.
+   * Items live in a b2DynamicTree of their own along with a copy of their shape and attenuation
+   * coefficients, so a query touches only items near the position and evaluates each once.
+   *
+   * Attenuation grows with distance when every linear and quadratic coefficient is non-negative.
+   * The search then stops at the radius beyond which even the most favorable coefficients cannot
+   * beat the kth best found; otherwise it falls back to visiting every item.
+   */
+  class ProximityIndex {
+  public:
+    ProximityIndex();
+
+    virtual ~ProximityIndex() = default;
+
+    /**
+     * Indexes every area and object of scene that has a message under key, replacing the
+     * previous contents.
+     */
+    void Build(Scene &scene, const std::string &key);
+
+    /**
+     * Replaces nearest with up to k accepted items in order of increasing attenuation at
+     * position. Ties go to the lower handle index.
+     */
+    void Nearest(glm::vec2 position, std::size_t k, const std::function<bool(Handle)> &accept,
+                 std::vector<Handle> &nearest) const;
+
+    std::size_t size() const;
+
+  private:
+    using Candidate = std::pair<float, Handle>;
+
+    struct Entry {
+      Handle item;
+      Object object;
+    };
+
+    struct Query {
+      bool QueryCallback(int32 proxy);
+
+      const ProximityIndex &index;
+      glm::vec2 position;
+      std::size_t k;
+      const std::function<bool(Handle)> &accept;
+      std::vector<Candidate> &best;
+    };
+
+    /**
+     * The distance beyond which no item can attenuate less than attenuation.
+     */
+    float RadiusFor(float attenuation) const;
+
+  private:
+    b2DynamicTree tree;
+    std::vector<Entry> entries;
+    std::size_t count;
+    AxisAlignedBoundingBox bounds;
+    float minimum_base, minimum_linear, minimum_quadratic;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__proximityindex__) */
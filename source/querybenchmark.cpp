@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "checks.h"
+#include "gamestate.h"
+#include "pcg32.h"
+#include "querybenchmark.h"
+#include "scene.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr float kRayLength = 32.0f;
+    constexpr float kBoxSize = 8.0f;
+
+  }  // namespace
+
+  QueryBenchmark::QueryBenchmark(Scene &scene, std::uint64_t seed) : scene(scene), seed(seed) {}
+
+  std::vector<QueryBenchmark::Result> QueryBenchmark::Run(
+      std::size_t query_count, std::size_t tick_count,
+      const std::vector<std::size_t> &thread_counts) {
+    AxisAlignedBoundingBox bounds{glm::vec2(std::numeric_limits<float>::max()),
+                                  glm::vec2(std::numeric_limits<float>::lowest())};
+    for (const auto &object : scene.objects) {
+      bounds.minimum = glm::min(bounds.minimum, object.aabb.minimum);
+      bounds.maximum = glm::max(bounds.maximum, object.aabb.maximum);
+    }
+    Pcg32 generator(seed);
+    std::uniform_real_distribution<float> x(bounds.minimum.x, bounds.maximum.x),
+        y(bounds.minimum.y, bounds.maximum.y), angle(0.0f, 2.0f * static_cast<float>(M_PI));
+    std::vector<Ray> rays(query_count);
+    std::vector<AxisAlignedBoundingBox> boxes(query_count);
+    for (std::size_t i = 0; i < query_count; ++i) {
+      const glm::vec2 origin(x(generator), y(generator));
+      const auto direction = angle(generator);
+      rays[i] = Ray{origin, origin + kRayLength * glm::vec2(std::cos(direction),
+                                                            std::sin(direction))};
+      const glm::vec2 corner(x(generator), y(generator));
+      boxes[i] = AxisAlignedBoundingBox{corner, corner + glm::vec2(kBoxSize)};
+    }
+
+    std::vector<Result> results;
+    std::vector<Handle> first_hits, first_overlaps;
+    for (const auto thread_count : thread_counts) {
+      PhysicsSettings settings;
+      settings.solver_threads = thread_count;
+      GameState state(scene, true, settings);
+      Result result{thread_count, 0, 0, {}, {}};
+      std::vector<RayHit> hits;
+      Overlaps overlaps;
+      for (std::size_t tick = 0; tick < tick_count; ++tick) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        state.RayCast(rays, hits);
+        const auto cast = std::chrono::high_resolution_clock::now();
+        state.QueryOverlaps(boxes, overlaps);
+        result.ray_cast += cast - start;
+        result.overlap += std::chrono::high_resolution_clock::now() - cast;
+      }
+      result.ray_cast /= tick_count;
+      result.overlap /= tick_count;
+      std::vector<Handle> hit_items;
+      for (const auto &hit : hits) {
+        hit_items.push_back(hit.item);
+      }
+      result.hit_count = static_cast<std::size_t>(std::count_if(
+          hit_items.cbegin(), hit_items.cend(), [] (Handle item) {
+            return static_cast<bool>(item);
+          }));
+      result.overlap_count = overlaps.items.size();
+      if (results.empty()) {
+        first_hits = hit_items;
+        first_overlaps = overlaps.items;
+      }
+      CHECK_STATE(first_hits == hit_items && first_overlaps == overlaps.items);
+      results.push_back(result);
+    }
+    return results;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,46 @@
+#ifndef __textengine__querybenchmark__
+#define __textengine__querybenchmark__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace textengine {
+
+  class Scene;
+
+  /**
+   * Times GameState's batched RayCast and QueryOverlaps against every item of scene, with the
+   * queries spread across each of a set of solver thread counts. Rays start anywhere among the
+   * items and point any way; boxes are the size of a few cells. Results must come out the same
+   * for every thread count.
+   */
+  class QueryBenchmark {
+  public:
+    struct Result {
+      std::size_t thread_count, hit_count, overlap_count;
+
+      /** Mean time per tick to answer every ray, and every box. */
+      std::chrono::duration<double, std::milli> ray_cast, overlap;
+    };
+
+    QueryBenchmark(Scene &scene, std::uint64_t seed);
+
+    virtual ~QueryBenchmark() = default;
+
+    /**
+     * Casts query_count rays and queries query_count boxes each tick for tick_count ticks, once
+     * for each of thread_counts.
+     */
+    std::vector<Result> Run(std::size_t query_count, std::size_t tick_count,
+                            const std::vector<std::size_t> &thread_counts);
+
+  private:
+    Scene &scene;
+    std::uint64_t seed;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__querybenchmark__) */
@@ -0,0 +1,171 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <glm/glm.hpp>
+#include <string>
+
+#include "checks.h"
+#include "recorder.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr char kMagic[4] = {'T', 'X', 'R', 'P'};
+    constexpr std::uint32_t kVersion = 1;
+
+    /** Bits of the byte leading each frame. */
+    constexpr std::uint8_t kPrimaryAxes = 1 << 0;
+    constexpr std::uint8_t kSecondaryAxes = 1 << 1;
+    constexpr std::uint8_t kLookVelocity = 1 << 2;
+    constexpr std::uint8_t kTriggerVelocity = 1 << 3;
+    constexpr std::uint8_t kTriggerPressure = 1 << 4;
+    constexpr std::uint8_t kSelect = 1 << 5;
+    constexpr std::uint8_t kDeselect = 1 << 6;
+    constexpr std::uint8_t kEnd = 1 << 7;
+
+    // Changes are found by bits rather than value so that a replay reproduces each float exactly.
+    template <typename T>
+    bool Differs(const T &a, const T &b) {
+      return 0 != std::memcmp(&a, &b, sizeof(T));
+    }
+
+  }  // namespace
+
+  Recorder::Recorder(const std::string &filename, std::uint64_t seed)
+  : out(filename, std::ios_base::binary | std::ios_base::trunc), previous(), tick_count(),
+    finished() {
+    CHECK_STATE(!out.fail());
+    out.write(kMagic, sizeof(kMagic));
+    Put(kVersion);
+    Put(seed);
+  }
+
+  Recorder::~Recorder() {
+    out.close();
+  }
+
+  void Recorder::Finish(std::uint64_t digest) {
+    if (!finished) {
+      Put(kEnd);
+      Put(tick_count);
+      Put(digest);
+      out.flush();
+      finished = true;
+    }
+  }
+
+  void Recorder::Write(const InputFrame &frame) {
+    if (finished) {
+      return;
+    }
+    std::uint8_t changes = 0;
+    changes |= Differs(frame.primary_axes, previous.primary_axes) ? kPrimaryAxes : 0;
+    changes |= Differs(frame.secondary_axes, previous.secondary_axes) ? kSecondaryAxes : 0;
+    changes |= Differs(frame.look_velocity, previous.look_velocity) ? kLookVelocity : 0;
+    changes |= Differs(frame.trigger_velocity, previous.trigger_velocity) ? kTriggerVelocity : 0;
+    changes |= Differs(frame.trigger_pressure, previous.trigger_pressure) ? kTriggerPressure : 0;
+    changes |= frame.select ? kSelect : 0;
+    changes |= frame.deselect ? kDeselect : 0;
+    Put(changes);
+    if (changes & kPrimaryAxes) {
+      Put(frame.primary_axes);
+    }
+    if (changes & kSecondaryAxes) {
+      Put(frame.secondary_axes);
+    }
+    if (changes & kLookVelocity) {
+      Put(frame.look_velocity);
+    }
+    if (changes & kTriggerVelocity) {
+      Put(frame.trigger_velocity);
+    }
+    if (changes & kTriggerPressure) {
+      Put(frame.trigger_pressure);
+    }
+    if (changes & kSelect) {
+      Put(frame.cursor);
+    }
+    previous = frame;
+    ++tick_count;
+  }
+
+  template <typename T>
+  void Recorder::Put(const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  Replay::Replay(const std::string &filename)
+  : in(filename, std::ios_base::binary), previous(), recorded_seed(), recorded_digest(), ticks() {
+    CHECK_STATE(!in.fail());
+    char magic[sizeof(kMagic)];
+    in.read(magic, sizeof(magic));
+    CHECK_STATE(0 == std::memcmp(magic, kMagic, sizeof(kMagic)));
+    std::uint32_t version;
+    CHECK_STATE(Get(version));
+    CHECK_STATE(kVersion == version);
+    CHECK_STATE(Get(recorded_seed));
+  }
+
+  bool Replay::Read(InputFrame &frame) {
+    std::uint8_t changes;
+    if (!Get(changes)) {
+      return false;
+    }
+    if (changes & kEnd) {
+      std::uint64_t tick_count;
+      CHECK_STATE(Get(tick_count));
+      CHECK_STATE(ticks == tick_count);
+      CHECK_STATE(Get(recorded_digest));
+      return false;
+    }
+    frame = previous;
+    frame.select = changes & kSelect;
+    frame.deselect = changes & kDeselect;
+    auto complete = true;
+    if (changes & kPrimaryAxes) {
+      complete = complete && Get(frame.primary_axes);
+    }
+    if (changes & kSecondaryAxes) {
+      complete = complete && Get(frame.secondary_axes);
+    }
+    if (changes & kLookVelocity) {
+      complete = complete && Get(frame.look_velocity);
+    }
+    if (changes & kTriggerVelocity) {
+      complete = complete && Get(frame.trigger_velocity);
+    }
+    if (changes & kTriggerPressure) {
+      complete = complete && Get(frame.trigger_pressure);
+    }
+    if (changes & kSelect) {
+      complete = complete && Get(frame.cursor);
+    }
+    if (!complete) {
+      return false;
+    }
+    previous = frame;
+    ++ticks;
+    return true;
+  }
+
+  std::uint64_t Replay::digest() const {
+    return recorded_digest;
+  }
+
+  std::uint64_t Replay::seed() const {
+    return recorded_seed;
+  }
+
+  std::uint64_t Replay::tick_count() const {
+    return ticks;
+  }
+
+  template <typename T>
+  bool Replay::Get(T &value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<std::size_t>(in.gcount()) == sizeof(T);
+  }
+
+}  // namespace textengine
@@ -0,0 +1,91 @@
+#ifndef __textengine__recorder__
+#define __textengine__recorder__
+
+#include <cstdint>
+#include <fstream>
+#include <glm/glm.hpp>
+#include <string>
+
+namespace textengine {
+
+  /**
+   * Everything Updater reads from the input devices in one tick.
+   */
+  struct InputFrame {
+    glm::vec2 primary_axes, secondary_axes;
+    float look_velocity, trigger_velocity, trigger_pressure;
+
+    /** Whether to select the smallest item under cursor, in world coordinates. */
+    bool select;
+    glm::vec2 cursor;
+
+    bool deselect;
+  };
+
+  /**
+   * Writes the seed and per-tick input frames of a session to a binary file. Each frame is a
+   * byte saying which fields changed since the previous frame followed by just those fields, so
+   * idle ticks cost one byte. Values are written in the host's byte order.
+   */
+  class Recorder {
+  public:
+    Recorder(const std::string &filename, std::uint64_t seed);
+
+    virtual ~Recorder();
+
+    /**
+     * Ends the recording with the tick count and the digest of the messages the session sent, for
+     * a replay to check itself against. Frames written afterwards are ignored.
+     */
+    void Finish(std::uint64_t digest);
+
+    void Write(const InputFrame &frame);
+
+  private:
+    template <typename T>
+    void Put(const T &value);
+
+  private:
+    std::ofstream out;
+    InputFrame previous;
+    std::uint64_t tick_count;
+    bool finished;
+  };
+
+  /**
+   * Reads back a file written by Recorder.
+   */
+  class Replay {
+  public:
+    explicit Replay(const std::string &filename);
+
+    virtual ~Replay() = default;
+
+    /**
+     * Reads the next frame, returning false at the end of the recording.
+     */
+    bool Read(InputFrame &frame);
+
+    /**
+     * The digest recorded by Recorder::Finish, once Read has returned false. Zero if the recording
+     * was cut short.
+     */
+    std::uint64_t digest() const;
+
+    std::uint64_t seed() const;
+
+    std::uint64_t tick_count() const;
+
+  private:
+    template <typename T>
+    bool Get(T &value);
+
+  private:
+    std::ifstream in;
+    InputFrame previous;
+    std::uint64_t recorded_seed, recorded_digest, ticks;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__recorder__) */
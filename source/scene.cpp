@@ -1,72 +1,218 @@
 #include <algorithm>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "messagecache.h"
 #include "scene.h"
 
 namespace textengine {
 
-  Scene::Scene(long next_id,
-    MessageMap &&messages_by_name, ObjectList &&areas, ObjectList &&objects)
+  Scene::Scene() = default;
+
+  Scene::Scene(Scene &&scene) = default;
+
+  Scene::Scene(long next_id, MessageMap &&messages_by_name)
+  : next_id(next_id), messages_by_name(std::move(messages_by_name)) {}
+
+  Scene::Scene(long next_id, MessageMap &&messages_by_name,
+               std::unique_ptr<MessageCache> &&message_cache)
   : next_id(next_id), messages_by_name(std::move(messages_by_name)),
-  areas(std::move(areas)), objects(std::move(objects)) {}
-  
-  Object *Scene::AddArea() {
-    auto area = new Object{next_id++};
-    area->aabb.maximum = glm::vec2(1);
-    area->name = MakeDefaultName("area");
-    area->base_attenuation = 0.0;
-    area->linear_attenuation = 0.0;
-    area->quadratic_attenuation = 1.0;
-    MakeDefaultMessageList(area, {
+    message_cache(std::move(message_cache)) {}
+
+  Scene::~Scene() = default;
+
+  Scene &Scene::operator =(Scene &&scene) = default;
+
+  Handle Scene::AddArea() {
+    auto area = Object{next_id++, Shape::kAxisAlignedBoundingBox, {glm::vec2(), glm::vec2(1)},
+                       false, 0.0f, 0.0f, 1.0f};
+    auto description = ObjectDescription{MakeDefaultName("area"), MessageMap(), nullptr, ""};
+    MakeDefaultMessageList(description, {
       "describe",
       "inside",
       "enter",
       "exit"
     });
-    areas.emplace_back(area);
-    return area;
-  }
-  
-  Object *Scene::AddObject() {
-    auto object = new Object{next_id++};
-    object->aabb.maximum = glm::vec2(1);
-    object->name = MakeDefaultName("object");
-    object->base_attenuation = 0.0;
-    object->linear_attenuation = 0.0;
-    object->quadratic_attenuation = 1.0;
-    MakeDefaultMessageList(object, {
+    return Insert(Kind::kArea, std::move(area), std::move(description));
+  }
+
+  Handle Scene::AddObject() {
+    auto object = Object{next_id++, Shape::kAxisAlignedBoundingBox, {glm::vec2(), glm::vec2(1)},
+                         false, 0.0f, 0.0f, 1.0f};
+    auto description = ObjectDescription{MakeDefaultName("object"), MessageMap(), nullptr, ""};
+    MakeDefaultMessageList(description, {
       "describe",
       "touch"
     });
-    objects.emplace_back(object);
-    return object;
+    return Insert(Kind::kObject, std::move(object), std::move(description));
+  }
+
+  void Scene::EraseItem(Handle item) {
+    const auto slot = FindSlot(item);
+    if (slot) {
+      handles_by_id.erase(Find(item)->id);
+      Remove(*slot);
+      slots[item.index].generation = std::max(slots[item.index].generation + 1, 1u);
+      free_slots.push_back(item.index);
+    }
   }
-  
-  void Scene::EraseItem(Object *item) {
-    auto removal_criterion = [&] (const std::unique_ptr<Object> &p) {
-      return item == p.get();
+
+  void Scene::EvictMessages(const ObjectDescription &description) {
+    if (description.span && message_cache) {
+      message_cache->Evict(*description.span);
+    }
+  }
+
+  Object *Scene::Find(Handle item) {
+    const auto slot = FindSlot(item);
+    return slot ? &Store(slot->kind).hot[slot->position] : nullptr;
+  }
+
+  Handle Scene::FindById(long id) const {
+    const auto handle = handles_by_id.find(id);
+    return handles_by_id.cend() == handle ? Handle{} : handle->second;
+  }
+
+  ObjectDescription *Scene::FindDescription(Handle item) {
+    const auto slot = FindSlot(item);
+    return slot ? &Store(slot->kind).cold[slot->position] : nullptr;
+  }
+
+  bool Scene::HasMessage(const ObjectDescription &description, const std::string &key) const {
+    if (description.span) {
+      const auto &keys = description.span->keys;
+      return keys.cend() != std::find(keys.cbegin(), keys.cend(), key);
+    } else {
+      const auto messages = description.messages.find(key);
+      return description.messages.cend() != messages && messages->second->size();
+    }
+  }
+
+  Handle Scene::Insert(Kind kind, Object &&object, ObjectDescription &&description) {
+    auto &store = Store(kind);
+    std::uint32_t index;
+    if (free_slots.empty()) {
+      index = static_cast<std::uint32_t>(slots.size());
+      slots.push_back(Slot{kind, 0, 1});
+    } else {
+      index = free_slots.back();
+      free_slots.pop_back();
+    }
+    auto &slot = slots[index];
+    slot.kind = kind;
+    slot.position = static_cast<std::uint32_t>(store.hot.size());
+    const auto handle = Handle{index, slot.generation};
+    handles_by_id[object.id] = handle;
+    store.hot.push_back(std::move(object));
+    store.cold.push_back(std::move(description));
+    store.handles.push_back(handle);
+    return handle;
+  }
+
+  bool Scene::IsArea(Handle item) const {
+    const auto slot = FindSlot(item);
+    return slot && Kind::kArea == slot->kind;
+  }
+
+  const MessageMap &Scene::Messages(const ObjectDescription &description) {
+    if (description.span && message_cache) {
+      return message_cache->Get(*description.span);
+    } else {
+      return description.messages;
+    }
+  }
+
+  std::vector<std::string> Scene::MessageTexts() {
+    std::vector<std::string> texts;
+    const auto add = [&texts] (const MessageMap &messages) {
+      for (const auto &list : messages) {
+        for (const auto &message : *list.second) {
+          texts.push_back(*message);
+        }
+      }
     };
-    if (areas.end() != std::find_if(areas.begin(), areas.end(), removal_criterion)) {
-      areas.erase(std::remove_if(areas.begin(), areas.end(), removal_criterion));
-    } else if (objects.end() != std::find_if(objects.begin(), objects.end(), removal_criterion)) {
-      objects.erase(std::remove_if(objects.begin(), objects.end(), removal_criterion));
+    add(messages_by_name);
+    for (const auto &area : areas) {
+      add(Messages(areas.description(area)));
+    }
+    for (const auto &object : objects) {
+      add(Messages(objects.description(object)));
+    }
+    std::sort(texts.begin(), texts.end());
+    texts.erase(std::unique(texts.begin(), texts.end()), texts.end());
+    return texts;
+  }
+
+  void Scene::Reserve(std::size_t area_count, std::size_t object_count) {
+    for (auto reservation : {std::make_pair(&areas, area_count),
+                             std::make_pair(&objects, object_count)}) {
+      reservation.first->hot.reserve(reservation.second);
+      reservation.first->cold.reserve(reservation.second);
+      reservation.first->handles.reserve(reservation.second);
+    }
+    slots.reserve(area_count + object_count);
+    handles_by_id.reserve(area_count + object_count);
+  }
+
+  void Scene::SetKind(Handle item, Kind kind) {
+    const auto slot = FindSlot(item);
+    if (!slot || kind == slot->kind) {
+      return;
+    }
+    auto &store = Store(slot->kind);
+    auto object = std::move(store.hot[slot->position]);
+    auto description = std::move(store.cold[slot->position]);
+    Remove(*slot);
+    auto &target = Store(kind);
+    slots[item.index].kind = kind;
+    slots[item.index].position = static_cast<std::uint32_t>(target.hot.size());
+    target.hot.push_back(std::move(object));
+    target.cold.push_back(std::move(description));
+    target.handles.push_back(item);
+  }
+
+  const Scene::Slot *Scene::FindSlot(Handle item) const {
+    if (item && item.index < slots.size() && item.generation == slots[item.index].generation) {
+      return &slots[item.index];
+    } else {
+      return nullptr;
     }
   }
-  
-  void Scene::MakeDefaultMessageList(Object *object, const std::vector<std::string> &&keys) const {
+
+  void Scene::MakeDefaultMessageList(ObjectDescription &description,
+                                     const std::vector<std::string> &&keys) const {
     for (auto &key : keys) {
       auto message_list = new MessageList();
-      message_list->emplace_back(new std::string("TODO: " + key + " " + object->name + "."));
-      object->messages.emplace(key, std::unique_ptr<MessageList>(message_list));
+      message_list->emplace_back(new std::string("TODO: " + key + " " + description.name + "."));
+      description.messages.emplace(key, std::unique_ptr<MessageList>(message_list));
     }
   }
-  
+
   std::string Scene::MakeDefaultName(const std::string &type) const {
     std::ostringstream out;
     out << type << " " << next_id - 1;
     return out.str();
   }
 
+  void Scene::Remove(const Slot &slot) {
+    auto &store = Store(slot.kind);
+    const auto last = store.hot.size() - 1;
+    if (slot.position != last) {
+      store.hot[slot.position] = std::move(store.hot[last]);
+      store.cold[slot.position] = std::move(store.cold[last]);
+      store.handles[slot.position] = store.handles[last];
+      slots[store.handles[slot.position].index].position = slot.position;
+    }
+    store.hot.pop_back();
+    store.cold.pop_back();
+    store.handles.pop_back();
+  }
+
+  ObjectStore &Scene::Store(Kind kind) {
+    return Kind::kArea == kind ? areas : objects;
+  }
+
 }  // namespace textengine
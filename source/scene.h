@@ -3,11 +3,14 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtx/component_wise.hpp>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "handle.h"
+
 namespace textengine {
 
   struct AxisAlignedBoundingBox {
@@ -47,12 +50,13 @@ namespace textengine {
     kCircle
   };
 
+  /**
+   * The hot part of a scene item: everything touched per tick by physics, telemetry and rendering.
+   */
   struct Object {
     long id;
-    std::string name;
     Shape shape;
     AxisAlignedBoundingBox aabb;
-    MessageMap messages;
     bool invisible;
     float base_attenuation, linear_attenuation, quadratic_attenuation;
     
@@ -116,36 +120,188 @@ namespace textengine {
     }
   };
 
-  using ObjectList = std::vector<std::unique_ptr<Object>>;
+  /**
+   * Where an item's messages live in its scene file when they are loaded lazily, along with the
+   * keys that have at least one message so that lookups need not load the text.
+   */
+  struct MessageSpan {
+    std::size_t begin, end;
+    std::vector<std::string> keys;
+  };
+
+  /**
+   * The cold part of a scene item: text that is only read when a message is chosen or edited.
+   * Lazily loaded items leave messages empty and carry a span instead.
+   */
+  struct ObjectDescription {
+    std::string name;
+    MessageMap messages;
+    std::unique_ptr<MessageSpan> span;
+
+    /** An Ogg Vorbis file looped while the player is inside, for areas; empty for none. */
+    std::string ambience;
+  };
+
+  class MessageCache;
+
+  enum class Kind {
+    kArea,
+    kObject
+  };
+
+  /**
+   * Densely packed storage for one kind of scene item. Hot and cold fields live in parallel
+   * arrays so that iterating over objects only walks contiguous Object structs.
+   */
+  class ObjectStore {
+  public:
+    using iterator = std::vector<Object>::iterator;
+    using const_iterator = std::vector<Object>::const_iterator;
+
+    ObjectStore() = default;
+
+    ObjectStore(ObjectStore &&store) = default;
+
+    virtual ~ObjectStore() = default;
+
+    ObjectStore &operator =(ObjectStore &&store) = default;
+
+    iterator begin() {
+      return hot.begin();
+    }
+
+    const_iterator begin() const {
+      return hot.begin();
+    }
+
+    iterator end() {
+      return hot.end();
+    }
+
+    const_iterator end() const {
+      return hot.end();
+    }
+
+    bool empty() const {
+      return hot.empty();
+    }
+
+    std::size_t size() const {
+      return hot.size();
+    }
+
+    ObjectDescription &description(const Object &object) {
+      return cold[IndexOf(object)];
+    }
+
+    const ObjectDescription &description(const Object &object) const {
+      return cold[IndexOf(object)];
+    }
+
+    Handle handle(const Object &object) const {
+      return handles[IndexOf(object)];
+    }
+
+  private:
+    friend class Scene;
+
+    std::size_t IndexOf(const Object &object) const {
+      return &object - hot.data();
+    }
+
+    std::vector<Object> hot;
+    std::vector<ObjectDescription> cold;
+    std::vector<Handle> handles;
+  };
 
+  /**
+   * Owns every area and object in the world. Items are addressed by generational handles that
+   * stay valid across insertions and erasures of other items; erase and lookup are O(1).
+   */
   class Scene {
   public:
-    Scene() = default;
+    Scene();
 
-    Scene(Scene &&scene) = default;
+    Scene(Scene &&scene);
 
-    Scene(long next_id, MessageMap &&messages_by_name, ObjectList &&areas, ObjectList &&objects);
-    
-    virtual ~Scene() = default;
+    Scene(long next_id, MessageMap &&messages_by_name);
 
-    Scene &operator =(Scene &&scene) = default;
+    Scene(long next_id, MessageMap &&messages_by_name,
+          std::unique_ptr<MessageCache> &&message_cache);
     
-    Object *AddArea();
+    virtual ~Scene();
+
+    Scene &operator =(Scene &&scene);
     
-    Object *AddObject();
+    Handle AddArea();
     
-    void EraseItem(Object *item);
+    Handle AddObject();
+
+    void EraseItem(Handle item);
+
+    /**
+     * Drops the item's lazily loaded messages from memory; they are read again on next use.
+     */
+    void EvictMessages(const ObjectDescription &description);
+
+    Object *Find(Handle item);
+
+    Handle FindById(long id) const;
+
+    ObjectDescription *FindDescription(Handle item);
+
+    bool HasMessage(const ObjectDescription &description, const std::string &key) const;
+
+    Handle Insert(Kind kind, Object &&object, ObjectDescription &&description);
+
+    bool IsArea(Handle item) const;
+
+    /**
+     * Returns the item's messages, reading them from the scene file if they were loaded lazily.
+     * The result stays valid until the next call.
+     */
+    const MessageMap &Messages(const ObjectDescription &description);
+
+    /**
+     * Every distinct message the scene can say, sorted. Reads any lazily loaded messages.
+     */
+    std::vector<std::string> MessageTexts();
+
+    void Reserve(std::size_t area_count, std::size_t object_count);
+
+    /**
+     * Moves an item between areas and objects without invalidating its handle.
+     */
+    void SetKind(Handle item, Kind kind);
     
   private:
-    void MakeDefaultMessageList(Object *object, const std::vector<std::string> &&keys) const;
+    struct Slot {
+      Kind kind;
+      std::uint32_t position, generation;
+    };
+
+    const Slot *FindSlot(Handle item) const;
+
+    void MakeDefaultMessageList(ObjectDescription &description,
+                                const std::vector<std::string> &&keys) const;
     
     std::string MakeDefaultName(const std::string &type) const;
+
+    void Remove(const Slot &slot);
+
+    ObjectStore &Store(Kind kind);
     
   public:
     long next_id;
-    ObjectList areas;
+    ObjectStore areas;
     MessageMap messages_by_name;
-    ObjectList objects;
+    ObjectStore objects;
+
+  private:
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> free_slots;
+    std::unordered_map<long, Handle> handles_by_id;
+    std::unique_ptr<MessageCache> message_cache;
   };
 
 }  // namespace textengine
@@ -1,61 +1,250 @@
+#include <chrono>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <picojson.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "checks.h"
+#include "messagecache.h"
 #include "scene.h"
 #include "sceneloader.h"
+#include "threadpool.h"
 
 namespace textengine {
 
-  Scene SceneLoader::ReadScene(const std::string &filename) const {
-    std::ifstream in(filename);
+  namespace {
+
+    struct MessageSpanTable {
+      std::vector<MessageSpan> areas, objects;
+    };
+
+    /**
+     * Counts the messages in one message list without keeping their text.
+     */
+    class MessageCountParseContext : public picojson::deny_parse_context {
+    public:
+      bool parse_array_start() {
+        return true;
+      }
+
+      template <typename Iter>
+      bool parse_array_item(picojson::input<Iter> &in, std::size_t) {
+        ++count;
+        picojson::null_parse_context message;
+        return picojson::_parse(message, in);
+      }
+
+      std::size_t count = 0;
+    };
+
+    /**
+     * Collects the keys of a message map that have at least one message.
+     */
+    class MessageKeysParseContext : public picojson::deny_parse_context {
+    public:
+      bool parse_object_start() {
+        return true;
+      }
+
+      template <typename Iter>
+      bool parse_object_item(picojson::input<Iter> &in, const std::string &key) {
+        MessageCountParseContext messages;
+        if (!picojson::_parse(messages, in)) {
+          return false;
+        }
+        if (messages.count) {
+          keys.push_back(key);
+        }
+        return true;
+      }
+
+      std::vector<std::string> keys;
+    };
+
+    /**
+     * Builds the same document as picojson::default_parse_context, except that the messages of
+     * every area and object are skipped and their byte range and keys recorded in a span table.
+     */
+    class LazyMessagesParseContext {
+    public:
+      LazyMessagesParseContext(picojson::value *out, const char *first, MessageSpanTable *table,
+                               std::vector<MessageSpan> *spans = nullptr,
+                               std::size_t depth = 0, std::size_t index = 0)
+      : out(out), first(first), table(table), spans(spans), depth(depth), index(index) {}
+
+      bool set_null() {
+        *out = picojson::value();
+        return true;
+      }
+
+      bool set_bool(bool b) {
+        *out = picojson::value(b);
+        return true;
+      }
+
+      bool set_number(double f) {
+        *out = picojson::value(f);
+        return true;
+      }
+
+      template <typename Iter>
+      bool parse_string(picojson::input<Iter> &in) {
+        *out = picojson::value(picojson::string_type, false);
+        return picojson::_parse_string(out->get<std::string>(), in);
+      }
+
+      bool parse_array_start() {
+        *out = picojson::value(picojson::array_type, false);
+        return true;
+      }
+
+      template <typename Iter>
+      bool parse_array_item(picojson::input<Iter> &in, std::size_t index) {
+        auto &array = out->get<picojson::array>();
+        array.push_back(picojson::value());
+        LazyMessagesParseContext item(&array.back(), first, table, spans, depth + 1, index);
+        return picojson::_parse(item, in);
+      }
+
+      bool parse_object_start() {
+        *out = picojson::value(picojson::object_type, false);
+        return true;
+      }
+
+      template <typename Iter>
+      bool parse_object_item(picojson::input<Iter> &in, const std::string &key) {
+        auto &object = out->get<picojson::object>();
+        if (kItemDepth == depth && spans && "messages" == key) {
+          // The ':' was just consumed, so the span starts with any whitespace before the map
+          // and ends right after its closing brace.
+          const std::size_t begin = in.cur() - first;
+          MessageKeysParseContext messages;
+          if (!picojson::_parse(messages, in)) {
+            return false;
+          }
+          if (spans->size() <= index) {
+            spans->resize(index + 1);
+          }
+          (*spans)[index] = MessageSpan{begin, static_cast<std::size_t>(in.cur() - first),
+                                        std::move(messages.keys)};
+          object[key] = picojson::value();
+          return true;
+        }
+        auto item_spans = spans;
+        if (0 == depth) {
+          item_spans = "areas" == key ? &table->areas
+              : "objects" == key ? &table->objects : nullptr;
+        }
+        LazyMessagesParseContext item(&object[key], first, table, item_spans, depth + 1);
+        return picojson::_parse(item, in);
+      }
+
+    private:
+      static constexpr std::size_t kItemDepth = 2;
+
+      picojson::value *out;
+      const char *first;
+      MessageSpanTable *table;
+      std::vector<MessageSpan> *spans;
+      std::size_t depth, index;
+    };
+
+  }  // namespace
+
+  SceneLoader::SceneLoader(std::size_t message_cache_capacity)
+  : message_cache_capacity(message_cache_capacity) {}
+
+  Scene SceneLoader::ReadScene(const std::string &filename, ThreadPool &pool) {
+    std::ifstream in(filename, std::ios_base::binary);
     CHECK_STATE(!in.fail());
-    return ReadScene(in);
+    return ReadScene(in, filename, pool);
   }
 
-  Scene SceneLoader::ReadOrCreateScene(const std::string &filename) const {
-    std::ifstream in(filename);
+  Scene SceneLoader::ReadOrCreateScene(const std::string &filename, ThreadPool &pool) {
+    std::ifstream in(filename, std::ios_base::binary);
     if (in.fail()) {
       return Scene();
     } else {
-      return ReadScene(in);
+      return ReadScene(in, filename, pool);
     }
   }
 
-  Scene SceneLoader::ReadScene(std::ifstream &in) const {
-    picojson::value value;
-    in >> value;
+  Scene SceneLoader::ReadScene(std::ifstream &in, const std::string &filename,
+                               ThreadPool &pool) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
     in.close();
-    const std::string error = picojson::get_last_error();
+    picojson::value value;
+    std::string error;
+    MessageSpanTable spans;
+    if (message_cache_capacity) {
+      LazyMessagesParseContext context(&value, text.data(), &spans);
+      picojson::_parse(context, text.data(), text.data() + text.size(), &error);
+    } else {
+      picojson::parse(value, text.data(), text.data() + text.size(), &error);
+    }
     if (!error.empty()) {
       FAIL(error);
     }
     CHECK_STATE(value.is<picojson::object>());
-    auto json_object = value.get<picojson::object>();
+    auto &json_object = value.get<picojson::object>();
     CHECK_STATE(json_object["areas"].is<picojson::array>());
     CHECK_STATE(json_object["messages"].is<picojson::object>());
     CHECK_STATE(json_object["objects"].is<picojson::array>());
-    auto areas_in = json_object["areas"].get<picojson::array>();
-    auto objects_in = json_object["objects"].get<picojson::array>();
-    long next_id = 0;
-    ObjectList areas_out;
-    auto messages_out = ReadMessageMap(json_object["messages"]);
-    ObjectList objects_out;
-    for (auto &area : areas_in) {
-      areas_out.emplace_back(ReadObject(next_id++, area));
+    auto &areas_in = json_object["areas"].get<picojson::array>();
+    auto &messages_in = json_object["messages"];
+    auto &objects_in = json_object["objects"].get<picojson::array>();
+    const auto parsed = std::chrono::high_resolution_clock::now();
+
+    // Each worker only touches its own elements of the parsed document, so areas, objects and
+    // the global messages can be materialized concurrently.
+    MessageMap messages_out;
+    std::thread messages_thread([&] () {
+      messages_out = ReadMessageMap(messages_in);
+    });
+    const auto item_count = areas_in.size() + objects_in.size();
+    std::vector<Object> objects_out(item_count);
+    std::vector<ObjectDescription> descriptions_out(item_count);
+    pool.ParallelFor(item_count, kItemsPerChunk, [&] (std::size_t begin, std::size_t end,
+                                                      std::size_t) {
+      for (auto i = begin; i < end; ++i) {
+        auto &item = i < areas_in.size() ? areas_in[i] : objects_in[i - areas_in.size()];
+        ReadObject(i, item, objects_out[i], descriptions_out[i]);
+        auto &item_spans = i < areas_in.size() ? spans.areas : spans.objects;
+        const auto index = i < areas_in.size() ? i : i - areas_in.size();
+        if (index < item_spans.size()) {
+          descriptions_out[i].span.reset(new MessageSpan(std::move(item_spans[index])));
+        }
+      }
+    });
+    messages_thread.join();
+    const auto materialized = std::chrono::high_resolution_clock::now();
+
+    std::unique_ptr<MessageCache> message_cache;
+    if (message_cache_capacity) {
+      message_cache.reset(new MessageCache(filename, message_cache_capacity));
     }
-    for (auto &object : objects_in) {
-      objects_out.emplace_back(ReadObject(next_id++, object));
+    Scene scene(item_count, std::move(messages_out), std::move(message_cache));
+    scene.Reserve(areas_in.size(), objects_in.size());
+    for (std::size_t i = 0; i < item_count; ++i) {
+      scene.Insert(i < areas_in.size() ? Kind::kArea : Kind::kObject,
+                   std::move(objects_out[i]), std::move(descriptions_out[i]));
     }
-    return Scene(next_id, std::move(messages_out), std::move(areas_out), std::move(objects_out));
+    const auto inserted = std::chrono::high_resolution_clock::now();
+
+    statistics.parse = parsed - start;
+    statistics.materialize = materialized - parsed;
+    statistics.insert = inserted - materialized;
+    statistics.item_count = item_count;
+    return scene;
   }
 
   AxisAlignedBoundingBox SceneLoader::ReadAxisAlignedBoundingBox(picojson::value &aabb) const {
     CHECK_STATE(aabb.is<picojson::object>());
-    auto json_object = aabb.get<picojson::object>();
+    auto &json_object = aabb.get<picojson::object>();
     CHECK_STATE(json_object["minimum"].is<picojson::object>());
     CHECK_STATE(json_object["maximum"].is<picojson::object>());
     return AxisAlignedBoundingBox{
@@ -66,7 +255,7 @@ namespace textengine {
 
   MessageList *SceneLoader::ReadMessageList(picojson::value &messages) const {
     CHECK_STATE(messages.is<picojson::array>());
-    auto json_array = messages.get<picojson::array>();
+    auto &json_array = messages.get<picojson::array>();
     auto message_list = new MessageList();
     for (auto &message : json_array) {
       CHECK_STATE(message.is<std::string>());
@@ -77,7 +266,7 @@ namespace textengine {
 
   MessageMap SceneLoader::ReadMessageMap(picojson::value &messages) const {
     CHECK_STATE(messages.is<picojson::object>());
-    auto json_object = messages.get<picojson::object>();
+    auto &json_object = messages.get<picojson::object>();
     auto message_map = MessageMap();
     for (auto &message_list : json_object) {
       message_map.emplace(message_list.first,
@@ -86,14 +275,15 @@ namespace textengine {
     return message_map;
   }
 
-  Object *SceneLoader::ReadObject(long id, picojson::value &object) const {
-    CHECK_STATE(object.is<picojson::object>());
-    auto json_object = object.get<picojson::object>();
+  void SceneLoader::ReadObject(long id, picojson::value &json, Object &object,
+                               ObjectDescription &description) const {
+    CHECK_STATE(json.is<picojson::object>());
+    auto &json_object = json.get<picojson::object>();
     CHECK_STATE(json_object["name"].is<std::string>());
-    CHECK_STATE(json_object["messages"].is<picojson::object>());
-    const auto result = new Object();
-    result->id = id;
-    result->name = json_object["name"].get<std::string>();
+    CHECK_STATE(json_object["messages"].is<picojson::object>() ||
+                (message_cache_capacity && json_object["messages"].is<picojson::null>()));
+    object.id = id;
+    description.name = json_object["name"].get<std::string>();
     if (json_object.cend() == json_object.find("aabb")) {
       CHECK_STATE(json_object["position"].is<picojson::object>());
       CHECK_STATE(json_object["radius"].is<double>());
@@ -103,24 +293,26 @@ namespace textengine {
         position + glm::vec2(-radius, -radius),
         position + glm::vec2(radius, radius)
       };
-      result->shape = Shape::kCircle;
-      result->aabb = aabb;
+      object.shape = Shape::kCircle;
+      object.aabb = aabb;
     } else {
       CHECK_STATE(json_object["aabb"].is<picojson::object>());
-      result->shape = Shape::kAxisAlignedBoundingBox;
-      result->aabb = ReadAxisAlignedBoundingBox(json_object["aabb"]);
+      object.shape = Shape::kAxisAlignedBoundingBox;
+      object.aabb = ReadAxisAlignedBoundingBox(json_object["aabb"]);
+    }
+    if (json_object["messages"].is<picojson::object>()) {
+      description.messages = ReadMessageMap(json_object["messages"]);
     }
-    result->messages = ReadMessageMap(json_object["messages"]);
-    result->invisible = Get(json_object, "invisible", false);
-    result->base_attenuation = Get(json_object, "base_attenuation", 0.0);
-    result->linear_attenuation = Get(json_object, "linear_attenuation", 0.0);
-    result->quadratic_attenuation = Get(json_object, "quadratic_attenuation", 1.0);
-    return result;
+    object.invisible = Get(json_object, "invisible", false);
+    object.base_attenuation = Get(json_object, "base_attenuation", 0.0);
+    object.linear_attenuation = Get(json_object, "linear_attenuation", 0.0);
+    object.quadratic_attenuation = Get(json_object, "quadratic_attenuation", 1.0);
+    description.ambience = Get(json_object, "ambience", std::string());
   }
 
-  glm::vec2 SceneLoader::ReadVec2(const picojson::value &vector) const {
+  glm::vec2 SceneLoader::ReadVec2(picojson::value &vector) const {
     CHECK_STATE(vector.is<picojson::object>());
-    auto object = vector.get<picojson::object>();
+    auto &object = vector.get<picojson::object>();
     CHECK_STATE(object["x"].is<double>());
     CHECK_STATE(object["y"].is<double>());
     return glm::vec2(object["x"].get<double>(), object["y"].get<double>());
@@ -1,6 +1,8 @@
 #ifndef __textengine__sceneloader__
 #define __textengine__sceneloader__
 
+#include <chrono>
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <picojson.h>
 #include <string>
@@ -10,18 +12,44 @@
 
 namespace textengine {
 
+  class ThreadPool;
+
+  /**
+   * Wall-clock time spent in each phase of the most recent ReadScene.
+   */
+  struct LoadStatistics {
+    std::chrono::duration<double, std::milli> parse, materialize, insert;
+    std::size_t item_count;
+  };
+
   class SceneLoader {
   public:
     SceneLoader() = default;
 
+    /**
+     * Creates a loader that leaves area and object messages in the scene file, reading them back
+     * on demand through a cache of at most message_cache_capacity message maps. A capacity of
+     * zero loads every message up front.
+     */
+    explicit SceneLoader(std::size_t message_cache_capacity);
+
     virtual ~SceneLoader() = default;
 
-    Scene ReadScene(const std::string &filename) const;
+    /**
+     * Reads the scene in filename, materializing its items in chunks spread across pool.
+     */
+    Scene ReadScene(const std::string &filename, ThreadPool &pool);
 
-    Scene ReadOrCreateScene(const std::string &filename) const;
+    Scene ReadOrCreateScene(const std::string &filename, ThreadPool &pool);
+
+    LoadStatistics statistics;
 
   private:
-    Scene ReadScene(std::ifstream &in) const;
+    friend class MessageCache;
+
+    static constexpr std::size_t kItemsPerChunk = 256;
+
+    Scene ReadScene(std::ifstream &in, const std::string &filename, ThreadPool &pool);
 
     AxisAlignedBoundingBox ReadAxisAlignedBoundingBox(picojson::value &aabb) const;
 
@@ -29,9 +57,12 @@ namespace textengine {
 
     MessageMap ReadMessageMap(picojson::value &messages) const;
 
-    Object *ReadObject(long id, picojson::value &object) const;
+    void ReadObject(long id, picojson::value &json, Object &object,
+                    ObjectDescription &description) const;
 
-    glm::vec2 ReadVec2(const picojson::value &vector) const;
+    glm::vec2 ReadVec2(picojson::value &vector) const;
+    
+    std::size_t message_cache_capacity = 0;
     
     template <typename T>
     T Get(picojson::object &object, const std::string &key, T default_value) const {
@@ -1,6 +1,8 @@
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <glm/glm.hpp>
+#include <iterator>
 #include <string>
 
 #include "checks.h"
@@ -9,25 +11,43 @@
 
 namespace textengine {
 
+  SceneSerializer::SceneSerializer(bool indent) : indent(indent) {}
+
   void SceneSerializer::WriteScene(const std::string &filename, Scene &scene) const {
-    std::ofstream out(filename);
+    // Written beside the scene and renamed over it, since messages of a lazily loaded scene are
+    // still read from the original while writing, and a failed save must not cost the scene.
+    const auto temporary = filename + ".tmp";
+    std::ofstream out(temporary);
     CHECK_STATE(!out.fail());
-    picojson::array areas;
+    // Items are written one at a time rather than as one document, which for a large scene
+    // would take many times the memory of the scene itself. Keys go in picojson's sorted order.
+    std::ostreambuf_iterator<char> iterator(out);
+    out << "{\"areas\":[";
     for (auto &area : scene.areas) {
-      areas.push_back(WriteObject(area.get()));
+      if (&area != &*scene.areas.begin()) {
+        out << ',';
+      }
+      const auto &description = scene.areas.description(area);
+      WriteObject(area, description, scene.Messages(description)).serialize(iterator);
     }
-    picojson::array objects;
+    out << "],\"messages\":";
+    WriteMessageMap(scene.messages_by_name).serialize(iterator);
+    out << ",\"objects\":[";
     for (auto &object : scene.objects) {
-      objects.push_back(WriteObject(object.get()));
+      if (&object != &*scene.objects.begin()) {
+        out << ',';
+      }
+      const auto &description = scene.objects.description(object);
+      WriteObject(object, description, scene.Messages(description)).serialize(iterator);
     }
-    picojson::object object;
-    object["messages"] = WriteMessageMap(scene.messages_by_name);
-    object["areas"] = picojson::value(areas);
-    object["objects"] = picojson::value(objects);
-    out << picojson::value(object) << std::endl;
+    out << "]}" << std::endl;
     out.close();
-    std::system(("python -mjson.tool < " + filename + " > temp.json").c_str());
-    std::system(("mv temp.json " + filename).c_str());
+    CHECK_STATE(!out.fail());
+    if (indent) {
+      CHECK_STATE(!std::system(("python -mjson.tool < " + temporary + " > temp.json").c_str()));
+      std::system(("mv temp.json " + temporary).c_str());
+    }
+    CHECK_STATE(!std::rename(temporary.c_str(), filename.c_str()));
   }
   
   picojson::value SceneSerializer::WriteAxisAlignedBoundingBox(AxisAlignedBoundingBox aabb) const {
@@ -37,7 +57,7 @@ namespace textengine {
     return picojson::value(object);
   }
   
-  picojson::value SceneSerializer::WriteMessageMap(MessageMap &messages) const {
+  picojson::value SceneSerializer::WriteMessageMap(const MessageMap &messages) const {
     picojson::object object;
     for (auto &entry : messages) {
       picojson::array message_set;
@@ -49,20 +69,25 @@ namespace textengine {
     return picojson::value(object);
   }
   
-  picojson::value SceneSerializer::WriteObject(textengine::Object *object) const {
+  picojson::value SceneSerializer::WriteObject(const Object &object,
+                                               const ObjectDescription &description,
+                                               const MessageMap &messages) const {
     picojson::object result;
-    result["name"] = picojson::value(object->name);
-    if (Shape::kAxisAlignedBoundingBox == object->shape) {
-      result["aabb"] = WriteAxisAlignedBoundingBox(object->aabb);
-    } else if (Shape::kCircle == object->shape) {
-      result["position"] = WriteVec2(object->aabb.center());
-      result["radius"] = picojson::value(object->aabb.radius());
+    result["name"] = picojson::value(description.name);
+    if (Shape::kAxisAlignedBoundingBox == object.shape) {
+      result["aabb"] = WriteAxisAlignedBoundingBox(object.aabb);
+    } else if (Shape::kCircle == object.shape) {
+      result["position"] = WriteVec2(object.aabb.center());
+      result["radius"] = picojson::value(object.aabb.radius());
+    }
+    result["messages"] = WriteMessageMap(messages);
+    result["invisible"] = picojson::value(object.invisible);
+    result["base_attenuation"] = picojson::value(object.base_attenuation);
+    result["linear_attenuation"] = picojson::value(object.linear_attenuation);
+    result["quadratic_attenuation"] = picojson::value(object.quadratic_attenuation);
+    if (!description.ambience.empty()) {
+      result["ambience"] = picojson::value(description.ambience);
     }
-    result["messages"] = WriteMessageMap(object->messages);
-    result["invisible"] = picojson::value(object->invisible);
-    result["base_attenuation"] = picojson::value(object->base_attenuation);
-    result["linear_attenuation"] = picojson::value(object->linear_attenuation);
-    result["quadratic_attenuation"] = picojson::value(object->quadratic_attenuation);
     return picojson::value(result);
   }
 
@@ -12,7 +12,11 @@ namespace textengine {
 
   class SceneSerializer {
   public:
-    SceneSerializer() = default;
+    /**
+     * Scenes are indented for hand editing unless indent is false, which suits generated scenes
+     * too large to read.
+     */
+    explicit SceneSerializer(bool indent = true);
 
     virtual ~SceneSerializer() = default;
 
@@ -21,11 +25,15 @@ namespace textengine {
   private:
     picojson::value WriteAxisAlignedBoundingBox(AxisAlignedBoundingBox aabb) const;
     
-    picojson::value WriteMessageMap(MessageMap &messages) const;
+    picojson::value WriteMessageMap(const MessageMap &messages) const;
     
-    picojson::value WriteObject(Object *object) const;
+    picojson::value WriteObject(const Object &object, const ObjectDescription &description,
+                                const MessageMap &messages) const;
     
     picojson::value WriteVec2(glm::vec2 vector) const;
+
+  private:
+    bool indent;
   };
 
 }  // namespace textengine
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "audioclip.h"
+#include "hash.h"
+#include "speechcache.h"
+
+namespace textengine {
+
+  SpeechCache::SpeechCache(SpeechSynthesizer &synthesizer, const std::string &directory,
+                           int sample_rate, std::size_t capacity_bytes)
+  : synthesizer(synthesizer), directory(directory), sample_rate(sample_rate),
+    capacity_bytes(capacity_bytes), mutex(), rendered(), entries(), entries_by_key(),
+    rendering(), totals(), running(), thread() {
+    if (!directory.empty()) {
+      // It may well exist already; if it cannot be made, writes fail and clips stay in memory.
+      mkdir(directory.c_str(), 0755);
+    }
+  }
+
+  SpeechCache::~SpeechCache() {
+    running = false;
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  bool SpeechCache::Synthesize(const std::string &text, AudioClip &clip) {
+    const auto cached = Get(text, false);
+    if (!cached) {
+      return false;
+    }
+    clip = *cached;
+    return true;
+  }
+
+  void SpeechCache::Warm(std::vector<std::string> &&texts) {
+    running = true;
+    thread = std::thread(&SpeechCache::WarmLoop, this, std::move(texts));
+  }
+
+  SpeechCache::Statistics SpeechCache::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+  }
+
+  std::shared_ptr<const AudioClip> SpeechCache::Get(const std::string &text, bool warming) {
+    const auto key = HashBytes(0, text.data(), text.size());
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      const auto found = entries_by_key.find(key);
+      if (entries_by_key.cend() != found) {
+        entries.splice(entries.begin(), entries, found->second);
+        if (!warming) {
+          ++totals.memory_hits;
+        }
+        return found->second->second;
+      }
+      if (!rendering.count(key)) {
+        break;
+      }
+      rendered.wait(lock);
+    }
+    rendering.insert(key);
+    lock.unlock();
+    const auto clip = Render(text, warming);
+    lock.lock();
+    rendering.erase(key);
+    if (clip) {
+      entries.emplace_front(key, clip);
+      entries_by_key.emplace(key, entries.begin());
+      totals.resident_bytes += clip->samples.size() * sizeof(short);
+      // The newest clip stays even if it alone is over capacity.
+      while (totals.resident_bytes > capacity_bytes && entries.size() > 1) {
+        totals.resident_bytes -= entries.back().second->samples.size() * sizeof(short);
+        entries_by_key.erase(entries.back().first);
+        entries.pop_back();
+      }
+    }
+    rendered.notify_all();
+    return clip;
+  }
+
+  std::shared_ptr<const AudioClip> SpeechCache::Render(const std::string &text, bool warming) {
+    const auto filename = directory.empty()
+        ? std::string() : directory + "/" + ClipSpeechSynthesizer::FilenameFor(text);
+    std::shared_ptr<AudioClip> clip(new AudioClip());
+    const auto from_disk = !filename.empty() && ReadWave(filename, *clip);
+    const auto synthesized = !from_disk && synthesizer.Synthesize(text, *clip);
+    if (from_disk || synthesized) {
+      Resample(*clip, sample_rate);
+    }
+    const auto succeeded = (from_disk || synthesized) && clip->frame_count() > 0;
+    if (succeeded && synthesized && !filename.empty()) {
+      // Written aside and renamed so that no reader ever sees half a file.
+      const auto partial = filename + ".partial";
+      if (!WriteWave(partial, *clip) || std::rename(partial.c_str(), filename.c_str())) {
+        std::remove(partial.c_str());
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!succeeded) {
+      ++totals.failed;
+      return nullptr;
+    }
+    if (from_disk) {
+      ++totals.disk_hits;
+    } else {
+      ++totals.synthesized;
+    }
+    if (warming) {
+      ++totals.warmed;
+    }
+    return clip;
+  }
+
+  void SpeechCache::WarmLoop(std::vector<std::string> texts) {
+    for (const auto &text : texts) {
+      if (!running) {
+        break;
+      }
+      Get(text, true);
+    }
+  }
+
+}  // namespace textengine
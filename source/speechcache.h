@@ -0,0 +1,85 @@
+#ifndef __textengine__speechcache__
+#define __textengine__speechcache__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "audioclip.h"
+#include "speechsynthesizer.h"
+
+namespace textengine {
+
+  /**
+   * Remembers what another synthesizer said, so that each distinct text is synthesized once.
+   *
+   * Clips are keyed by the hash of their text. They are kept in memory up to a byte capacity,
+   * evicting the least recently used, and written to directory under the names
+   * ClipSpeechSynthesizer reads, so later sessions and clip playback find them too. Clips are
+   * stored at the engine's sample rate, so a hit is a copy. Since the key is the text alone, the
+   * directory belongs to one voice.
+   *
+   * Warm renders a list of texts ahead of time on a thread of its own. A text requested while
+   * it renders is waited for rather than synthesized twice.
+   */
+  class SpeechCache : public SpeechSynthesizer {
+  public:
+    struct Statistics {
+      std::size_t memory_hits, disk_hits, synthesized, failed, warmed;
+      std::size_t resident_bytes;
+    };
+
+    /**
+     * An empty directory keeps clips in memory only.
+     */
+    SpeechCache(SpeechSynthesizer &synthesizer, const std::string &directory, int sample_rate,
+                std::size_t capacity_bytes);
+
+    virtual ~SpeechCache();
+
+    virtual bool Synthesize(const std::string &text, AudioClip &clip) override;
+
+    /**
+     * Starts rendering texts in the background, reading those already on disk. Call once.
+     */
+    void Warm(std::vector<std::string> &&texts);
+
+    Statistics statistics() const;
+
+  private:
+    using Entry = std::pair<std::uint64_t, std::shared_ptr<const AudioClip>>;
+
+    std::shared_ptr<const AudioClip> Get(const std::string &text, bool warming);
+
+    std::shared_ptr<const AudioClip> Render(const std::string &text, bool warming);
+
+    void WarmLoop(std::vector<std::string> texts);
+
+  private:
+    SpeechSynthesizer &synthesizer;
+    std::string directory;
+    int sample_rate;
+    std::size_t capacity_bytes;
+    mutable std::mutex mutex;
+    std::condition_variable rendered;
+    std::list<Entry> entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries_by_key;
+    std::unordered_set<std::uint64_t> rendering;
+    Statistics totals;
+    std::atomic<bool> running;
+    std::thread thread;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__speechcache__) */
@@ -0,0 +1,111 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "checks.h"
+#include "hash.h"
+#include "speechsynthesizer.h"
+
+extern char **environ;
+
+namespace textengine {
+
+  namespace {
+
+    constexpr const char *kInputArgument = u8"%i";
+    constexpr const char *kOutputArgument = u8"%o";
+
+    constexpr const char *kInputTemplate = u8"/input-XXXXXX.txt";
+    constexpr const char *kInputSuffix = u8".txt";
+    constexpr const char *kOutputSuffix = u8".wav";
+
+    std::string TemporaryDirectory() {
+      const auto directory = std::getenv("TMPDIR");
+      return directory && *directory ? directory : "/tmp";
+    }
+
+    /** Creates a directory that only this user may use and returns its name. */
+    std::string CreatePrivateDirectory() {
+      auto name = TemporaryDirectory() + "/textengine-speech-XXXXXX";
+      CHECK_STATE(mkdtemp(&name[0]));
+      return name;
+    }
+
+  }  // namespace
+
+  CommandSpeechSynthesizer::CommandSpeechSynthesizer(const std::vector<std::string> &arguments)
+  : arguments(arguments), directory(CreatePrivateDirectory()) {}
+
+  CommandSpeechSynthesizer::~CommandSpeechSynthesizer() {
+    rmdir(directory.c_str());
+  }
+
+  bool CommandSpeechSynthesizer::Synthesize(const std::string &text, AudioClip &clip) {
+    // mkstemps picks a name no other call has, and the output takes the same one.
+    auto input = directory + kInputTemplate;
+    const auto file = mkstemps(&input[0], std::strlen(kInputSuffix));
+    if (-1 == file) {
+      return false;
+    }
+    const auto output = input.substr(0, input.size() - std::strlen(kInputSuffix)) + kOutputSuffix;
+    const auto stream = fdopen(file, "wb");
+    if (!stream) {
+      close(file);
+      std::remove(input.c_str());
+      return false;
+    }
+    std::fwrite(text.data(), 1, text.size(), stream);
+    std::fclose(stream);
+    std::vector<char *> argv;
+    for (const auto &argument : arguments) {
+      const auto &value = kInputArgument == argument ? input
+          : kOutputArgument == argument ? output : argument;
+      argv.push_back(const_cast<char *>(value.c_str()));
+    }
+    argv.push_back(nullptr);
+    pid_t child;
+    auto result = posix_spawnp(&child, argv.front(), nullptr, nullptr, argv.data(), environ);
+    if (!result) {
+      int status = 0;
+      pid_t waited;
+      do {
+        waited = waitpid(child, &status, 0);
+      } while (-1 == waited && EINTR == errno);
+      result = child == waited && WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+    const auto read = !result && ReadWave(output, clip);
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+    return read;
+  }
+
+  std::vector<std::string> CommandSpeechSynthesizer::DefaultArguments() {
+#ifdef __APPLE__
+    return {"say", "--rate=250", "--data-format=LEI16@22050", "-o", kOutputArgument,
+            "-f", kInputArgument};
+#else
+    return {"espeak", "-s", "250", "-w", kOutputArgument, "-f", kInputArgument};
+#endif
+  }
+
+  ClipSpeechSynthesizer::ClipSpeechSynthesizer(const std::string &directory)
+  : directory(directory) {}
+
+  bool ClipSpeechSynthesizer::Synthesize(const std::string &text, AudioClip &clip) {
+    return ReadWave(directory + "/" + FilenameFor(text), clip);
+  }
+
+  std::string ClipSpeechSynthesizer::FilenameFor(const std::string &text) {
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.wav",
+                  static_cast<unsigned long long>(HashBytes(0, text.data(), text.size())));
+    return name;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,71 @@
+#ifndef __textengine__speechsynthesizer__
+#define __textengine__speechsynthesizer__
+
+#include <string>
+#include <vector>
+
+#include "audioclip.h"
+#include "interface.h"
+
+namespace textengine {
+
+  /**
+   * Turns text into speech. Synthesize may block for as long as it takes; the audio engine
+   * calls it from a thread of its own.
+   */
+  class SpeechSynthesizer {
+    DECLARE_INTERFACE(SpeechSynthesizer);
+
+  public:
+    /**
+     * Replaces clip with text spoken and returns whether that succeeded.
+     */
+    virtual bool Synthesize(const std::string &text, AudioClip &clip) = 0;
+  };
+
+  /**
+   * Runs a local speech engine as a process per utterance. Arguments are passed to the program
+   * as they are, without a shell, except that an argument "%i" becomes the name of a file holding
+   * the text and "%o" the name of the WAVE file the engine should write. Since the text is never
+   * an argument, nothing in it can be taken for an option. Both files are created in a directory
+   * only this user can write to, so nobody else can put a link where the engine writes.
+   */
+  class CommandSpeechSynthesizer : public SpeechSynthesizer {
+  public:
+    explicit CommandSpeechSynthesizer(const std::vector<std::string> &arguments = DefaultArguments());
+
+    virtual ~CommandSpeechSynthesizer();
+
+    virtual bool Synthesize(const std::string &text, AudioClip &clip) override;
+
+    /**
+     * say on OS X and espeak elsewhere.
+     */
+    static std::vector<std::string> DefaultArguments();
+
+  private:
+    std::vector<std::string> arguments;
+    std::string directory;
+  };
+
+  /**
+   * Plays pre-rendered speech: the clip for some text is the WAVE file in directory named by
+   * the hexadecimal HashBytes of the text.
+   */
+  class ClipSpeechSynthesizer : public SpeechSynthesizer {
+  public:
+    explicit ClipSpeechSynthesizer(const std::string &directory);
+
+    virtual ~ClipSpeechSynthesizer() = default;
+
+    virtual bool Synthesize(const std::string &text, AudioClip &clip) override;
+
+    static std::string FilenameFor(const std::string &text);
+
+  private:
+    std::string directory;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__speechsynthesizer__) */
@@ -0,0 +1,66 @@
+#ifndef __textengine__spscqueue__
+#define __textengine__spscqueue__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace textengine {
+
+  /**
+   * A fixed-size ring for passing values from one producer thread to one consumer thread without
+   * locks, so that neither ever waits on the other. Capacity must be a power of two.
+   *
+   * Each side owns one index and only reads the other's, and padding keeps the two on separate
+   * cache lines so that they do not contend.
+   */
+  template <typename T, std::size_t Capacity>
+  class SpscQueue {
+    static_assert(Capacity && !(Capacity & (Capacity - 1)), "Capacity must be a power of two");
+
+  public:
+    SpscQueue() : head(), head_padding(), tail(), tail_padding(), values() {}
+
+    /**
+     * Returns false, leaving the queue as it was, if it is full. Producer only.
+     */
+    bool TryPush(const T &value) {
+      const auto back = tail.load(std::memory_order_relaxed);
+      if (back - head.load(std::memory_order_acquire) == Capacity) {
+        return false;
+      }
+      values[back & (Capacity - 1)] = value;
+      tail.store(back + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Returns false if the queue is empty. Consumer only.
+     */
+    bool TryPop(T &value) {
+      const auto front = head.load(std::memory_order_relaxed);
+      if (front == tail.load(std::memory_order_acquire)) {
+        return false;
+      }
+      value = values[front & (Capacity - 1)];
+      head.store(front + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool empty() const {
+      return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    std::atomic<std::size_t> head;
+    char head_padding[kCacheLineSize - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> tail;
+    char tail_padding[kCacheLineSize - sizeof(std::atomic<std::size_t>)];
+    std::array<T, Capacity> values;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__spscqueue__) */
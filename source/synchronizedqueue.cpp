@@ -5,6 +5,8 @@
 #include <string>
 
 #include "memory.h"
+#include "metrics.h"
+#include "profiler.h"
 #include "synchronizedqueue.h"
 
 namespace textengine {
@@ -113,32 +115,43 @@ namespace textengine {
   }
   
   void SynchronizedQueue::PushEntity(long id) {
+    PROFILE_SCOPE("queue push");
     std::lock_guard<std::mutex> lock(mutex);
     queue.emplace_back(new EntityMessage(id));
   }
   
   void SynchronizedQueue::PushMessages(std::vector<MixedMessage *> &&messages) {
+    PROFILE_SCOPE("queue push");
     std::lock_guard<std::mutex> lock(mutex);
     queue.emplace_back(new CompositeMessage(Unique(messages)));
   }
   
   void SynchronizedQueue::PushMovement(const glm::vec2 &position,
                                        const glm::vec2 &direction, const std::map<long, glm::vec2> &directions) {
+    PROFILE_SCOPE("queue push");
     std::lock_guard<std::mutex> lock(mutex);
     if (!queue.empty() && queue.back()->is_movement()) {
       queue.pop_back();
+      Metrics::Add(Metrics::kTelemetryDropped);
     }
     queue.emplace_back(new TelemetryMessage{position, direction, directions});
   }
 
   void SynchronizedQueue::PushReport(const std::string &report) {
+    PROFILE_SCOPE("queue push");
     std::lock_guard<std::mutex> lock(mutex);
     queue.emplace_back(new ReportMessage{report});
   }
   
   void SynchronizedQueue::PushText(const std::string &text) {
+    PROFILE_SCOPE("queue push");
     std::lock_guard<std::mutex> lock(mutex);
     queue.emplace_back(new TextMessage{text});
   }
 
+  std::size_t SynchronizedQueue::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+  }
+
 }  // namespace textengine
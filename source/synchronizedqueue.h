@@ -2,6 +2,7 @@
 #define __textengine__synchronizedqueue__
 
 #include <glm/glm.hpp>
+#include <cstddef>
 #include <deque>
 #include <map>
 #include <memory>
@@ -122,6 +123,8 @@ namespace textengine {
     
     void PushText(const std::string &text);
 
+    std::size_t size();
+
   private:
     std::mutex mutex;
     std::deque<std::unique_ptr<Message>> queue;
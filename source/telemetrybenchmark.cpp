@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <map>
+#include <picojson.h>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+#include "checks.h"
+#include "scene.h"
+#include "synchronizedqueue.h"
+#include "telemetrybenchmark.h"
+
+namespace textengine {
+
+  namespace {
+
+    /** Metres per second; a brisk walk. */
+    constexpr float kWalkingSpeed = 1.4f;
+
+    /** The time between the updater's ticks, each of which sends telemetry. */
+    constexpr float kTickSeconds = 0.016f;
+
+    /** The window and memory levels libwebsockets deflates with. */
+    constexpr int kWindowBits = 15;
+    constexpr int kMemoryLevel = 8;
+
+    /** The 00 00 ff ff that ends a flush, which permessage-deflate leaves off the wire. */
+    constexpr std::size_t kFlushMarkerSize = 4;
+
+    /** Compresses each message as the permessage-deflate extension does. */
+    class MessageDeflater {
+    public:
+      MessageDeflater(int level, bool context_takeover)
+      : stream(), context_takeover(context_takeover), output() {
+        CHECK_STATE(Z_OK == deflateInit2(&stream, level, Z_DEFLATED, -kWindowBits, kMemoryLevel,
+                                         Z_DEFAULT_STRATEGY));
+      }
+
+      ~MessageDeflater() {
+        deflateEnd(&stream);
+      }
+
+      /** Returns the size of message once compressed. */
+      std::size_t Deflate(const std::string &message) {
+        output.resize(deflateBound(&stream, message.size()) + 16);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(message.data()));
+        stream.avail_in = static_cast<uInt>(message.size());
+        stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+        stream.avail_out = static_cast<uInt>(output.size());
+        CHECK_STATE(Z_OK == deflate(&stream, Z_SYNC_FLUSH) && !stream.avail_in);
+        const auto size = output.size() - stream.avail_out - kFlushMarkerSize;
+        if (!context_takeover) {
+          deflateReset(&stream);
+        }
+        return size;
+      }
+
+    private:
+      z_stream stream;
+      bool context_takeover;
+      std::string output;
+    };
+
+    /**
+     * Writes the position and direction as floats, then a count and, for each item whose
+     * quantized direction differs from the last one written, the gap from the previous item's
+     * id as a varint and the direction as two 16-bit integers. The first message has them all.
+     */
+    class DeltaEncoder {
+    public:
+      DeltaEncoder() : last_sent() {}
+
+      std::string Encode(const TelemetryMessage &message) {
+        std::string result, entries;
+        AppendFloats(result, message.position);
+        AppendFloats(result, message.direction);
+        std::size_t count = 0;
+        long previous_id = 0;
+        for (const auto &entry : message.directions) {
+          const auto quantized = Quantize(entry.second);
+          const auto sent = last_sent.find(entry.first);
+          if (last_sent.end() != sent && quantized == sent->second) {
+            continue;
+          }
+          last_sent[entry.first] = quantized;
+          // Directions are in order of id, so the gaps are small and never negative.
+          AppendVarint(entries, entry.first - previous_id);
+          entries.append(reinterpret_cast<const char *>(&quantized), sizeof(quantized));
+          previous_id = entry.first;
+          ++count;
+        }
+        AppendVarint(result, count);
+        result.append(entries);
+        return result;
+      }
+
+    private:
+      static void AppendFloats(std::string &out, glm::vec2 value) {
+        out.append(reinterpret_cast<const char *>(&value.x), sizeof(value.x));
+        out.append(reinterpret_cast<const char *>(&value.y), sizeof(value.y));
+      }
+
+      static void AppendVarint(std::string &out, std::uint64_t value) {
+        for (; value >= 0x80; value >>= 7) {
+          out.push_back(static_cast<char>(value | 0x80));
+        }
+        out.push_back(static_cast<char>(value));
+      }
+
+      /** Both components of a unit vector as 16-bit integers, packed. */
+      static std::uint32_t Quantize(glm::vec2 direction) {
+        const auto x = static_cast<std::int16_t>(std::lround(direction.x * 32767.0f));
+        const auto y = static_cast<std::int16_t>(std::lround(direction.y * 32767.0f));
+        return static_cast<std::uint16_t>(x) | static_cast<std::uint32_t>(
+            static_cast<std::uint16_t>(y)) << 16;
+      }
+
+      std::unordered_map<long, std::uint32_t> last_sent;
+    };
+
+  }  // namespace
+
+  TelemetryBenchmark::TelemetryBenchmark(const Scene &scene, int deflate_level)
+  : scene(scene), deflate_level(deflate_level) {}
+
+  std::vector<TelemetryBenchmark::Result> TelemetryBenchmark::Run(std::size_t tick_count) {
+    enum {kJson, kDeflate, kDeflateNoTakeover, kDelta, kDeflateDelta};
+    std::vector<Result> results{
+      {"json", 0, 0, {}},
+      {"json, permessage-deflate", 0, 0, {}},
+      {"json, permessage-deflate without context takeover", 0, 0, {}},
+      {"binary delta", 0, 0, {}},
+      {"binary delta, permessage-deflate", 0, 0, {}}
+    };
+    MessageDeflater deflater(deflate_level, true), reset_deflater(deflate_level, false),
+        delta_deflater(deflate_level, true);
+    DeltaEncoder delta_encoder;
+    using Clock = std::chrono::high_resolution_clock;
+    const auto add = [&results] (int encoding, std::size_t bytes, Clock::duration encode) {
+      ++results[encoding].message_count;
+      results[encoding].bytes += bytes;
+      results[encoding].encode += encode;
+    };
+    const glm::vec2 direction(1.0f, 0.0f);
+    for (std::size_t tick = 0; tick < tick_count; ++tick) {
+      const auto position = direction * (kWalkingSpeed * kTickSeconds * tick);
+      std::map<long, glm::vec2> directions;
+      for (const auto &object : scene.objects) {
+        directions.insert({object.id, object.DirectionFrom(position)});
+      }
+      for (const auto &area : scene.areas) {
+        directions.insert({area.id, area.DistanceTo(position) > 0.0f
+                                    ? area.DirectionFrom(position) : glm::vec2()});
+      }
+      const TelemetryMessage message(position, direction, directions);
+
+      auto start = Clock::now();
+      std::ostringstream out;
+      out << message.ToJson();
+      const auto json = out.str();
+      const auto json_time = Clock::now() - start;
+      add(kJson, json.size(), json_time);
+
+      start = Clock::now();
+      auto size = deflater.Deflate(json);
+      add(kDeflate, size, json_time + (Clock::now() - start));
+
+      start = Clock::now();
+      size = reset_deflater.Deflate(json);
+      add(kDeflateNoTakeover, size, json_time + (Clock::now() - start));
+
+      start = Clock::now();
+      const auto delta = delta_encoder.Encode(message);
+      const auto delta_time = Clock::now() - start;
+      add(kDelta, delta.size(), delta_time);
+
+      start = Clock::now();
+      size = delta_deflater.Deflate(delta);
+      add(kDeflateDelta, size, delta_time + (Clock::now() - start));
+    }
+    return results;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,42 @@
+#ifndef __textengine__telemetrybenchmark__
+#define __textengine__telemetrybenchmark__
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace textengine {
+
+  class Scene;
+
+  /**
+   * Measures what the telemetry sent each tick costs on the wire, for a walk in a straight line
+   * from the origin through scene, under each way it could be encoded: the JSON text sent now,
+   * that text through permessage-deflate with and without context takeover, and a binary delta
+   * that sends only the directions that changed since the last tick, quantized to 16 bits.
+   */
+  class TelemetryBenchmark {
+  public:
+    struct Result {
+      std::string encoding;
+      std::size_t message_count, bytes;
+
+      /** Time to encode every message, compression included. */
+      std::chrono::duration<double, std::milli> encode;
+    };
+
+    TelemetryBenchmark(const Scene &scene, int deflate_level);
+
+    virtual ~TelemetryBenchmark() = default;
+
+    std::vector<Result> Run(std::size_t tick_count);
+
+  private:
+    const Scene &scene;
+    int deflate_level;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__telemetrybenchmark__) */
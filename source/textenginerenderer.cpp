@@ -1,4 +1,5 @@
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <functional>
 #include <imgui.h>
 #include <imguiRenderGL3.h>
@@ -7,6 +8,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <iomanip>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -15,6 +17,7 @@
 #include "controller.h"
 #include "gamestate.h"
 #include "mouse.h"
+#include "profiler.h"
 #include "textenginerenderer.h"
 
 namespace textengine {
@@ -94,16 +97,17 @@ namespace textengine {
   }
   
   void TextEngineRenderer::MaybeRebuildAttenuationShader() {
-    if (updater.GetCurrentState().selected_item) {
+    const auto selected_item = scene.Find(updater.GetCurrentState().selected_item);
+    if (selected_item) {
       std::set<textengine::Object *> objects, areas;
       for (auto &object : scene.objects) {
-        objects.insert(object.get());
+        objects.insert(&object);
       }
       for (auto &area : scene.areas) {
-        areas.insert(area.get());
+        areas.insert(&area);
       }
       const auto attenuation_shader_source = attenuation_template.AttenuationFragmentShaderSource(
-          updater.GetCurrentState().selected_item, objects, areas);
+          selected_item, objects, areas);
       std::hash<std::string> string_hash;
       const auto source_hash = string_hash(attenuation_shader_source);
       if (source_hash != attenuation_fragment_shader_source_hash) {
@@ -114,7 +118,7 @@ namespace textengine {
         attenuation_program.CompileAndLink();
         
         const auto attenuation3_shader_source = attenuation3_template.AttenuationFragmentShaderSource(
-            updater.GetCurrentState().selected_item, objects, areas);
+            selected_item, objects, areas);
         
         attenuation3_fragment_shader.Create(GL_FRAGMENT_SHADER, {attenuation3_shader_source});
         attenuation3_program.Create({&attenuation_vertex_shader, &attenuation3_fragment_shader});
@@ -153,24 +157,24 @@ namespace textengine {
 
     fill = glm::vec4(0.0f, 0.5f, 0.3f, 0.5f);
     for (const auto &area : scene.areas) {
-      if (area->invisible) {
+      if (area.invisible) {
         continue;
       }
-      if (Shape::kAxisAlignedBoundingBox == area->shape) {
-        DrawAxisAlignedBoundingBox(area->aabb);
+      if (Shape::kAxisAlignedBoundingBox == area.shape) {
+        DrawAxisAlignedBoundingBox(area.aabb);
       } else {
-        DrawCircle(area->aabb.center(), area->aabb.radius());
+        DrawCircle(area.aabb.center(), area.aabb.radius());
       }
     }
     fill = glm::vec4(1.0f, 0.0f, 0.0f, 0.5f);
     for (const auto &object : scene.objects) {
-      if (object->invisible) {
+      if (object.invisible) {
         continue;
       }
-      if (Shape::kAxisAlignedBoundingBox == object->shape) {
-        DrawAxisAlignedBoundingBox(object->aabb);
+      if (Shape::kAxisAlignedBoundingBox == object.shape) {
+        DrawAxisAlignedBoundingBox(object.aabb);
       } else {
-        DrawCircle(object->aabb.center(), object->aabb.radius());
+        DrawCircle(object.aabb.center(), object.aabb.radius());
       }	
     }
 
@@ -201,30 +205,31 @@ namespace textengine {
     
     if (edit) {
       MaybeRebuildAttenuationShader();
-      if (current_state.selected_item) {
+      const auto selected_item = scene.Find(current_state.selected_item);
+      if (selected_item) {
         attenuation3_program.Use();
         attenuation3_program.Uniforms({
           {u8"model_view_inverse", &inverse}
         });
-        const auto isaabb3 = Shape::kAxisAlignedBoundingBox == current_state.selected_item->shape;
+        const auto isaabb3 = Shape::kAxisAlignedBoundingBox == selected_item->shape;
         glUniform1i(attenuation3_program.GetUniformLocation(u8"selected_isaabb"), isaabb3);
-        if (Shape::kAxisAlignedBoundingBox == current_state.selected_item->shape) {
+        if (Shape::kAxisAlignedBoundingBox == selected_item->shape) {
           attenuation3_program.Uniforms({
-            {u8"selected_minimum_or_center", current_state.selected_item->aabb.minimum},
-            {u8"selected_maximum_or_radius", current_state.selected_item->aabb.maximum},
+            {u8"selected_minimum_or_center", selected_item->aabb.minimum},
+            {u8"selected_maximum_or_radius", selected_item->aabb.maximum},
           });
           CHECK_STATE(!glGetError());
         } else {
           attenuation3_program.Uniforms({
-            {u8"selected_minimum_or_center", current_state.selected_item->aabb.center()},
-            {u8"selected_maximum_or_radius", glm::vec2(current_state.selected_item->aabb.radius())},
+            {u8"selected_minimum_or_center", selected_item->aabb.center()},
+            {u8"selected_maximum_or_radius", glm::vec2(selected_item->aabb.radius())},
           });
           CHECK_STATE(!glGetError());
         }
         const auto attenuation3_coefficients = glm::vec3(
-            current_state.selected_item->base_attenuation,
-                current_state.selected_item->linear_attenuation,
-                    current_state.selected_item->quadratic_attenuation);
+            selected_item->base_attenuation,
+                selected_item->linear_attenuation,
+                    selected_item->quadratic_attenuation);
         attenuation3_program.Uniforms({
           {u8"selected_attenuation", attenuation3_coefficients},
         });
@@ -240,25 +245,25 @@ namespace textengine {
         attenuation_program.Uniforms({
           {u8"model_view_inverse", &inverse}
         });
-        const auto isaabb = Shape::kAxisAlignedBoundingBox == current_state.selected_item->shape;
+        const auto isaabb = Shape::kAxisAlignedBoundingBox == selected_item->shape;
         glUniform1i(attenuation_program.GetUniformLocation(u8"selected_isaabb"), isaabb);
-        if (Shape::kAxisAlignedBoundingBox == current_state.selected_item->shape) {
+        if (Shape::kAxisAlignedBoundingBox == selected_item->shape) {
           attenuation_program.Uniforms({
-            {u8"selected_minimum_or_center", current_state.selected_item->aabb.minimum},
-            {u8"selected_maximum_or_radius", current_state.selected_item->aabb.maximum},
+            {u8"selected_minimum_or_center", selected_item->aabb.minimum},
+            {u8"selected_maximum_or_radius", selected_item->aabb.maximum},
           });
           CHECK_STATE(!glGetError());
         } else {
           attenuation_program.Uniforms({
-            {u8"selected_minimum_or_center", current_state.selected_item->aabb.center()},
-            {u8"selected_maximum_or_radius", glm::vec2(current_state.selected_item->aabb.radius())},
+            {u8"selected_minimum_or_center", selected_item->aabb.center()},
+            {u8"selected_maximum_or_radius", glm::vec2(selected_item->aabb.radius())},
           });
           CHECK_STATE(!glGetError());
         }
         const auto attenuation_coefficients = glm::vec3(
-            current_state.selected_item->base_attenuation,
-                current_state.selected_item->linear_attenuation,
-                    current_state.selected_item->quadratic_attenuation);
+            selected_item->base_attenuation,
+                selected_item->linear_attenuation,
+                    selected_item->quadratic_attenuation);
         attenuation_program.Uniforms({
           {u8"selected_attenuation", attenuation_coefficients},
         });
@@ -285,28 +290,41 @@ namespace textengine {
       imguiBeginFrame(mouse_position.x, height - mouse_position.y, mouse_buttons, 0);
       
       for (auto &area : scene.areas) {
-        const glm::vec4 homogeneous = transform * glm::vec4(area->aabb.minimum.x, area->aabb.maximum.y, 0.0f, 1.0f);
+        const glm::vec4 homogeneous = transform * glm::vec4(area.aabb.minimum.x, area.aabb.maximum.y, 0.0f, 1.0f);
         const glm::vec2 transformed = homogeneous.xy() / homogeneous.w;
-        imguiDrawText(transformed.x, height - transformed.y, IMGUI_ALIGN_LEFT, area->name.c_str(), imguiRGBA(0, 0, 0));
+        imguiDrawText(transformed.x, height - transformed.y, IMGUI_ALIGN_LEFT, scene.areas.description(area).name.c_str(), imguiRGBA(0, 0, 0));
       }
       
       for (auto &object : scene.objects) {
-        const glm::vec4 homogeneous = transform * glm::vec4(object->aabb.minimum.x, object->aabb.maximum.y, 0.0f, 1.0f);
+        const glm::vec4 homogeneous = transform * glm::vec4(object.aabb.minimum.x, object.aabb.maximum.y, 0.0f, 1.0f);
         const glm::vec2 transformed = homogeneous.xy() / homogeneous.w;
-        imguiDrawText(transformed.x, height - transformed.y, IMGUI_ALIGN_LEFT, object->name.c_str(), imguiRGBA(0, 0, 0));
+        imguiDrawText(transformed.x, height - transformed.y, IMGUI_ALIGN_LEFT, scene.objects.description(object).name.c_str(), imguiRGBA(0, 0, 0));
       }
       
-      if (current_state.selected_item) {
+      const auto selected_item = scene.Find(current_state.selected_item);
+      if (selected_item) {
         std::ostringstream name, constant, linear, quadratic;
-        name << current_state.selected_item->name;
+        name << scene.FindDescription(current_state.selected_item)->name;
         imguiDrawText(10, height - 50, IMGUI_ALIGN_LEFT, name.str().c_str(), imguiRGBA(0, 0, 0));
-        constant << "c: " << current_state.selected_item->base_attenuation;
+        constant << "c: " << selected_item->base_attenuation;
         imguiDrawText(10, height - 75, IMGUI_ALIGN_LEFT, constant.str().c_str(), imguiRGBA(0, 0, 0));
-        linear << "l: " << current_state.selected_item->linear_attenuation;
+        linear << "l: " << selected_item->linear_attenuation;
         imguiDrawText(10, height - 100, IMGUI_ALIGN_LEFT, linear.str().c_str(), imguiRGBA(0, 0, 0));
-        quadratic << "q: " << current_state.selected_item->quadratic_attenuation << std::endl;
+        quadratic << "q: " << selected_item->quadratic_attenuation << std::endl;
         imguiDrawText(10, height - 125, IMGUI_ALIGN_LEFT, quadratic.str().c_str(), imguiRGBA(0, 0, 0));
       }
+
+      if (Profiler::enabled()) {
+        // Milliseconds spent in each scope over the last second, with the longest single run.
+        auto y = height - 50;
+        for (const auto &summary : Profiler::Summarize(std::chrono::seconds(1))) {
+          std::ostringstream line;
+          line << std::fixed << std::setprecision(2) << summary.name << ": " << summary.count
+               << " in " << summary.total.count() << " ms, max " << summary.maximum.count() << " ms";
+          imguiDrawText(width - 10, y, IMGUI_ALIGN_RIGHT, line.str().c_str(), imguiRGBA(0, 0, 0));
+          y -= 25;
+        }
+      }
       
       imguiEndFrame();
     }
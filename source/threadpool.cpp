@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "threadpool.h"
+
+namespace textengine {
+
+  ThreadPool::ThreadPool(std::size_t thread_count)
+  : queues(), threads(), mutex(), wake(), done(), function(), remaining(), generation(),
+    running(true) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      queues.emplace_back(new Queue());
+    }
+    for (std::size_t i = 1; i < thread_count; ++i) {
+      threads.emplace_back(&ThreadPool::Loop, this, i);
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  void ThreadPool::ParallelFor(
+      std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t, std::size_t)> &function) {
+    grain = std::max<std::size_t>(grain, 1);
+    const auto chunk_count = (count + grain - 1) / grain;
+    if (!chunk_count) {
+      return;
+    }
+    this->function = &function;
+    remaining = chunk_count;
+    for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      auto &queue = *queues[chunk * queues.size() / chunk_count];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.ranges.emplace_back(chunk * grain, std::min(chunk * grain + grain, count));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++generation;
+    }
+    wake.notify_all();
+    while (RunOne(0));
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] () {
+      return 0 == remaining;
+    });
+  }
+
+  std::size_t ThreadPool::size() const {
+    return queues.size();
+  }
+
+  void ThreadPool::Loop(std::size_t worker) {
+    auto seen = std::size_t();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait(lock, [this, seen] () {
+        return !running || generation != seen;
+      });
+      if (!running) {
+        return;
+      }
+      seen = generation;
+      lock.unlock();
+      while (RunOne(worker));
+      lock.lock();
+    }
+  }
+
+  bool ThreadPool::RunOne(std::size_t worker) {
+    Range range;
+    auto found = false;
+    for (std::size_t i = 0; i < queues.size() && !found; ++i) {
+      auto &queue = *queues[(worker + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.ranges.empty()) {
+        if (0 == i) {
+          range = queue.ranges.front();
+          queue.ranges.pop_front();
+        } else {
+          range = queue.ranges.back();
+          queue.ranges.pop_back();
+        }
+        found = true;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+    (*function)(range.first, range.second, worker);
+    if (1 == remaining.fetch_sub(1)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done.notify_all();
+    }
+    return true;
+  }
+
+}  // namespace textengine
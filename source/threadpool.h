@@ -0,0 +1,66 @@
+#ifndef __textengine__threadpool__
+#define __textengine__threadpool__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace textengine {
+
+  /**
+   * A fixed set of worker threads, for work that recurs every frame, where starting threads per
+   * call would cost more than the work, as well as for loading. Each worker has its own queue of
+   * ranges and steals from the back of the others' once its own runs dry.
+   */
+  class ThreadPool {
+  public:
+    /**
+     * Starts thread_count - 1 threads; the thread calling ParallelFor is worker zero.
+     */
+    explicit ThreadPool(std::size_t thread_count);
+
+    virtual ~ThreadPool();
+
+    /**
+     * Calls function(begin, end, worker) over [0, count) in chunks of at most grain items and
+     * returns once every chunk is done. A worker index is never used by two threads at once.
+     * Calls must not overlap or nest.
+     */
+    void ParallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t, std::size_t)> &function);
+
+    std::size_t size() const;
+
+  private:
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Range> ranges;
+    };
+
+    void Loop(std::size_t worker);
+
+    bool RunOne(std::size_t worker);
+
+  private:
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(std::size_t, std::size_t, std::size_t)> *function;
+    std::atomic<std::size_t> remaining;
+    std::size_t generation;
+    bool running;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__threadpool__) */
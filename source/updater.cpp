@@ -1,6 +1,8 @@
 #include <Box2D/Box2D.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #define GLM_FORCE_RADIANS
 #define GLM_SWIZZLE
 #include <glm/glm.hpp>
@@ -9,97 +11,92 @@
 #include <glm/gtx/string_cast.hpp>
 #include <limits>
 #include <map>
-#include <sstream>
+#include <random>
 #include <string>
 #include <tuple>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "ambienceplayer.h"
 #include "checks.h"
+#include "cuemixer.h"
 #include "gamestate.h"
+#include "hash.h"
 #include "input.h"
 #include "keyboard.h"
 #include "log.h"
+#include "messageselector.h"
 #include "mouse.h"
+#include "profiler.h"
+#include "proximityindex.h"
+#include "recorder.h"
 #include "scene.h"
 #include "synchronizedqueue.h"
 #include "updater.h"
+#include "worldstreamer.h"
 
 namespace textengine {
 
+  namespace {
+
+    /** The simulated time between ticks, matching the physics step. */
+    constexpr std::chrono::milliseconds kTickDuration(16);
+
+    /** How many of the loudest items a look describes. */
+    constexpr std::size_t kLookCount = 3;
+
+    /** Objects quieter than this make no sound, which keeps the number of cues down. */
+    constexpr float kAudibleGain = 0.01f;
+
+  }  // namespace
+
   Updater::Updater(int width, int height, SynchronizedQueue &reply_queue,
                    SynchronizedQueue &voice_queue, Log &playtest_log, Input &input, Mouse &mouse,
-                   Keyboard &keyboard, GameState &initial_state, Scene &scene)
+                   Keyboard &keyboard, GameState &initial_state, Scene &scene,
+                   WorldStreamer *world_streamer)
   : width(width), height(height), reply_queue(reply_queue), voice_queue(voice_queue),
   playtest_log(playtest_log), input(input), mouse(mouse), keyboard(keyboard),
-  current_state(initial_state), phrase_index(), scene(scene), model_view_projection() {}
+  current_state(initial_state), phrase_index(),
+  selector(SelectionPolicy::kUniform, std::random_device()()), scene(scene),
+  world_streamer(world_streamer), recorder(), ambience(), cues(), ticks(), message_digest(),
+  last_direction_time(), last_transmit_time(-kTickDuration), model_view_projection() {
+    describable.Build(scene, "describe");
+  }
 
   void Updater::BeginContact(b2Contact *contact) {
-    Object *area, *object;
+    Handle object;
     b2Body *player;
-    std::tie(area, object, player) = ResolveContact(contact);
-    if (player && area) {
-      inside.insert(area);
-      const auto enter = ChooseMessage(area->messages, "enter");
-      if (!enter.empty()) {
-        reply_queue.PushText(enter);
-        voice_queue.PushText(enter);
-      }
-    }
-    const auto now = std::chrono::high_resolution_clock::now();
-    if (player && object && now - last_touch_time[object] > std::chrono::seconds(2)) {
+    std::tie(object, player) = ResolveContact(contact);
+    const auto now = Now();
+    const auto last_touch = last_touch_time.find(object);
+    if (player && object && (last_touch_time.cend() == last_touch
+                             || now - last_touch->second > std::chrono::seconds(2))) {
       last_touch_time[object] = now;
-      const auto touch = ChooseMessage(object->messages, "touch");
+      const auto touch = ChooseMessage(scene.Messages(*scene.FindDescription(object)), "touch");
       if (!touch.empty()) {
-        reply_queue.PushMessages({
-          new EntityMessage{object->id},
-          new TextMessage{touch}
-        });
-        voice_queue.PushText(touch);
-      }
-    }
-  }
-
-  void Updater::EndContact(b2Contact *contact) {
-    Object *area, *object;
-    b2Body *player;
-    std::tie(area, object, player) = ResolveContact(contact);
-    if (player && area) {
-      const auto exit = ChooseMessage(area->messages, "exit");
-      if (!exit.empty()) {
-        reply_queue.PushText(exit);
-        voice_queue.PushText(exit);
+        Say(scene.Find(object)->id, touch);
       }
-      inside.erase(area);
     }
   }
 
-  std::tuple<Object *, Object *, b2Body *> Updater::ResolveContact(b2Contact *contact) const {
-    Object *area = nullptr, *object = nullptr;
+  std::pair<Handle, b2Body *> Updater::ResolveContact(b2Contact *contact) const {
+    Handle object{};
     b2Body *player = nullptr;
     if (current_state.player_body == contact->GetFixtureA()->GetBody()) {
       player = contact->GetFixtureA()->GetBody();
-      if (contact->GetFixtureB()->IsSensor()) {
-        area = reinterpret_cast<Object *>(contact->GetFixtureB()->GetBody()->GetUserData());
-      } else {
-        object = reinterpret_cast<Object *>(contact->GetFixtureB()->GetBody()->GetUserData());
-      }
+      object = Handle::FromUserData(contact->GetFixtureB()->GetUserData());
     }
     if (current_state.player_body == contact->GetFixtureB()->GetBody()) {
       player = contact->GetFixtureB()->GetBody();
-      if (contact->GetFixtureA()->IsSensor()) {
-        area = reinterpret_cast<Object *>(contact->GetFixtureA()->GetBody()->GetUserData());
-      } else {
-        object = reinterpret_cast<Object *>(contact->GetFixtureA()->GetBody()->GetUserData());
-      }
+      object = Handle::FromUserData(contact->GetFixtureA()->GetUserData());
     }
-    return std::make_tuple(area, object, player);
+    return std::make_pair(object, player);
   }
 
   std::string Updater::ChooseMessage(const MessageMap &messages, const std::string &name) {
     if (HasMessage(messages, name)) {
-      const auto index = index_distribution(generator) % messages.at(name)->size();
-      return *messages.at(name)->at(index);
+      return selector.Choose(*messages.at(name));
     } else {
       return "";
     }
@@ -109,8 +106,8 @@ namespace textengine {
     return messages.cend() != messages.find(name) && messages.at(name)->size();
   }
 
-  bool Updater::Inside(const std::unique_ptr<Object> &area) const {
-    return inside.cend() != inside.find(area.get());
+  std::uint64_t Updater::digest() const {
+    return message_digest;
   }
 
   GameState &Updater::GetCurrentState() {
@@ -131,48 +128,104 @@ namespace textengine {
     return transformed;
   }
   
+  std::chrono::milliseconds Updater::Now() const {
+    return static_cast<std::chrono::milliseconds::rep>(ticks) * kTickDuration;
+  }
+
+  InputFrame Updater::SampleInput() {
+    InputFrame frame;
+    frame.primary_axes = input.GetPrimaryAxes();
+    frame.secondary_axes = input.GetSecondaryAxes();
+    frame.look_velocity = input.GetLookVelocity();
+    frame.trigger_velocity = input.GetTriggerVelocity();
+    frame.trigger_pressure = input.GetTriggerPressure();
+    frame.select = mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_2);
+    frame.cursor = frame.select ? GetCursorPosition() : glm::vec2();
+    frame.deselect = keyboard.GetKeyVelocity(GLFW_KEY_BACKSPACE) > 0;
+    return frame;
+  }
+
+  void Updater::Say(const std::string &text) {
+    reply_queue.PushText(text);
+    voice_queue.PushText(text);
+    message_digest = HashBytes(message_digest, text.data(), text.size());
+  }
+
+  void Updater::Say(long id, const std::string &text) {
+    reply_queue.PushMessages({
+      new EntityMessage(id),
+      new TextMessage(text)
+    });
+    voice_queue.PushText(text);
+    message_digest = HashBytes(message_digest, &id, sizeof(id));
+    message_digest = HashBytes(message_digest, text.data(), text.size());
+  }
+
+  void Updater::Seed(std::uint64_t seed) {
+    selector.Seed(seed);
+  }
+
   void Updater::SetModelViewProjection(glm::mat4 model_view_projection) {
     Updater::model_view_projection = model_view_projection;
   }
 
+  void Updater::SetAmbiencePlayer(AmbiencePlayer *ambience) {
+    Updater::ambience = ambience;
+  }
+
+  void Updater::SetCueMixer(CueMixer *cues) {
+    Updater::cues = cues;
+  }
+
+  void Updater::SetRecorder(Recorder *recorder) {
+    Updater::recorder = recorder;
+  }
+
+  void Updater::SetSelectionPolicy(SelectionPolicy policy) {
+    selector.SetPolicy(policy);
+  }
+
   void Updater::Setup() {
     last_direction = Direction::kEast;
     current_state.world.SetContactListener(this);
   }
 
+  void Updater::Tick(const InputFrame &frame) {
+    Update(current_state, frame);
+    ++ticks;
+  }
+
   void Updater::Update() {
-    Update(current_state);
+    const auto frame = SampleInput();
+    if (recorder) {
+      recorder->Write(frame);
+    }
+    Tick(frame);
   }
 
-  void Updater::Update(GameState &current_state) {
-    const auto now = std::chrono::high_resolution_clock::now();
-    const auto offset = input.GetPrimaryAxes();
-    const auto offset2 = input.GetSecondaryAxes();
+  void Updater::Update(GameState &current_state, const InputFrame &frame) {
+    const auto now = Now();
+    const auto offset = frame.primary_axes;
+    const auto offset2 = frame.secondary_axes;
     
-    if (keyboard.GetKeyVelocity(GLFW_KEY_BACKSPACE) > 0) {
-      current_state.selected_item = nullptr;
+    if (frame.deselect) {
+      current_state.selected_item = Handle{};
     }
     
-    if (mouse.GetButtonVelocity(GLFW_MOUSE_BUTTON_2)) {
-      const auto cursor = GetCursorPosition();
-      std::unordered_set<Object *> candidates;
+    if (frame.select) {
+      const auto cursor = frame.cursor;
+      auto minimum = std::numeric_limits<float>::infinity();
+      Handle argmin{};
       for (auto &area : scene.areas) {
-        if (area->Contains(cursor)) {
-          candidates.insert(area.get());
+        if (area.Contains(cursor) && area.area() < minimum) {
+          minimum = area.area();
+          argmin = scene.areas.handle(area);
         }
       }
       for (auto &object : scene.objects) {
-        if (object->Contains(cursor)) {
-          candidates.insert(object.get());
-        }
-      }
-      auto minimum = std::numeric_limits<float>::infinity();
-      Object *argmin = nullptr;
-      for (auto candidate : candidates) {
-        const auto area = candidate->area();
-        if (area < minimum) {
-          minimum = area;
-          argmin = candidate;
+        if (object.Contains(cursor) && object.area() < minimum) {
+          minimum = object.area();
+          argmin = scene.objects.handle(object);
         }
       }
       if (argmin) {
@@ -187,82 +240,128 @@ namespace textengine {
                                                     current_state.previous_player_position);
     current_state.previous_player_position = position;
 
+    if (world_streamer) {
+      PROFILE_SCOPE("streaming");
+      world_streamer->Update(position);
+    }
+
+    entered.clear();
+    exited.clear();
+    {
+      PROFILE_SCOPE("areas");
+      current_state.areas.Update(scene, position, entered, exited);
+    }
+    for (const auto area : exited) {
+      const auto description = scene.FindDescription(area);
+      const auto exit = description ? ChooseMessage(scene.Messages(*description), "exit") : "";
+      if (!exit.empty()) {
+        Say(exit);
+      }
+    }
+    for (const auto area : entered) {
+      const auto enter = ChooseMessage(scene.Messages(*scene.FindDescription(area)), "enter");
+      if (!enter.empty()) {
+        Say(enter);
+      }
+    }
+    if (ambience && (!exited.empty() || !entered.empty())) {
+      for (const auto area : exited) {
+        ambient_areas.erase(std::remove_if(ambient_areas.begin(), ambient_areas.end(),
+                                           [area] (const std::pair<Handle, std::string> &entry) {
+                                             return area == entry.first;
+                                           }), ambient_areas.end());
+      }
+      for (const auto area : entered) {
+        const auto &filename = scene.FindDescription(area)->ambience;
+        if (!filename.empty()) {
+          ambient_areas.emplace_back(area, filename);
+        }
+      }
+      ambience->Play(ambient_areas.empty() ? "" : ambient_areas.back().second);
+    }
+
     constexpr auto kStepSize = 1.0f;
     if (current_state.accrued_distance > kStepSize) {
       current_state.accrued_distance -= kStepSize;
       // reply_queue.PushStep();
     }
     
-    if (now - last_transmit_time > std::chrono::milliseconds(16)) {
+    if (now - last_transmit_time >= kTickDuration) {
+      PROFILE_SCOPE("transmit");
       auto directions = std::map<long, glm::vec2>();
+      const auto angle = current_state.player_body->GetAngle();
+      const auto right = glm::vec2(std::sin(angle), -std::cos(angle));
       for (auto &object : scene.objects) {
-        directions.insert({object->id, object->DirectionFrom(position)});
+        const auto object_direction = object.DirectionFrom(position);
+        directions.insert({object.id, object_direction});
+        if (cues) {
+          const auto gain = 1.0f / std::max(1.0f, object.attenuation(position));
+          if (gain >= kAudibleGain) {
+            cues->Emit(object.id, gain, glm::dot(object_direction, right));
+          }
+        }
+      }
+      if (cues) {
+        cues->End();
       }
       for (auto &area : scene.areas) {
-        if (area->Contains(position)) {
-          directions.insert({area->id, glm::vec2()});
+        if (current_state.areas.Inside(scene.areas.handle(area))) {
+          directions.insert({area.id, glm::vec2()});
         } else {
-          directions.insert({area->id, area->DirectionFrom(position)});
+          directions.insert({area.id, area.DirectionFrom(position)});
         }
       }
-      reply_queue.PushMovement(position,
-                               glm::length(offset) > 0 ? glm::normalize(offset) : glm::vec2(),
-                               directions);
+      const auto direction = glm::length(offset) > 0 ? glm::normalize(offset) : glm::vec2();
+      reply_queue.PushMovement(position, direction, directions);
+      message_digest = HashBytes(message_digest, &position, sizeof(position));
+      message_digest = HashBytes(message_digest, &direction, sizeof(direction));
       last_transmit_time = now;
     }
 
-    if (input.GetLookVelocity() > 0) {
-      std::ostringstream out;
-      std::vector<Object *> nearby;
+    if (frame.look_velocity > 0) {
+      PROFILE_SCOPE("look");
       reply_queue.PushText("");
-      for (auto &area : scene.areas) {
-        if (Inside(area) && HasMessage(area->messages, "inside")) {
-          const auto inside = ChooseMessage(area->messages, "inside");
-          reply_queue.PushText(inside);
-          voice_queue.PushText(inside);
-        } else if (HasMessage(area->messages, "describe")) {
-          nearby.push_back(area.get());
-        }
-      }
-      for (auto &object : scene.objects) {
-        if (HasMessage(object->messages, "describe")) {
-          nearby.push_back(object.get());
+      // Areas the player stands in say what it is like inside rather than how they look.
+      const auto &inside_areas = current_state.areas.inside_areas();
+      std::vector<Handle> inside(inside_areas.cbegin(), inside_areas.cend());
+      std::sort(inside.begin(), inside.end(), [] (Handle a, Handle b) {
+        return a.index < b.index;
+      });
+      const auto says_inside = [this] (Handle area) {
+        const auto description = scene.FindDescription(area);
+        return description && scene.HasMessage(*description, "inside");
+      };
+      for (const auto area : inside) {
+        if (says_inside(area)) {
+          Say(ChooseMessage(scene.Messages(*scene.FindDescription(area)), "inside"));
         }
       }
-      auto compare = [position] (const Object *a, const Object *b) {
-        return a->attenuation(position) < b->attenuation(position);
-      };
-      auto nth = nearby.begin() + 3;
-      std::partial_sort(nearby.begin(), nth, nearby.end(), compare);
-      for (auto element = nearby.begin(); element < nth; ++element) {
-        const auto describe = ChooseMessage((*element)->messages, "describe");
-        reply_queue.PushMessages({
-          new EntityMessage((*element)->id),
-          new TextMessage(describe)
-        });
-        voice_queue.PushText(describe);
+      // The index is built once, so skip any item erased from the scene since.
+      describable.Nearest(position, kLookCount, [this, &current_state, &says_inside] (Handle item) {
+        return scene.Find(item) && (!current_state.areas.Inside(item) || !says_inside(item));
+      }, nearby);
+      for (const auto item : nearby) {
+        Say(scene.Find(item)->id, ChooseMessage(scene.Messages(*scene.FindDescription(item)),
+                                                "describe"));
       }
       reply_queue.PushText("");
 
     }
 
-    if (glm::length(offset) > 0.0 || input.GetTriggerVelocity() > 0.0) {
+    if (glm::length(offset) > 0.0 || frame.trigger_velocity > 0.0) {
+      PROFILE_SCOPE("movement");
       current_state.world.ClearForces();
       auto velocity = current_state.player_body->GetLinearVelocity();
 
       last_direction_time = now;
 
       const auto force = 200.0f * current_state.player_body->GetMass();
-      if (input.GetTriggerVelocity() > 0) {
-        const auto run = ChooseMessage(scene.messages_by_name, "run");
-        reply_queue.PushText(run);
-        voice_queue.PushText(run);
-      } else if (input.GetTriggerVelocity() < 0) {
-        const auto walk = ChooseMessage(scene.messages_by_name, "walk");
-        reply_queue.PushText(walk);
-        voice_queue.PushText(walk);
+      if (frame.trigger_velocity > 0) {
+        Say(ChooseMessage(scene.messages_by_name, "run"));
+      } else if (frame.trigger_velocity < 0) {
+        Say(ChooseMessage(scene.messages_by_name, "walk"));
       }
-      const auto max_velocity = glm::mix(1.38f, 5.81f, input.GetTriggerPressure()) / 2.0f;
+      const auto max_velocity = glm::mix(1.38f, 5.81f, frame.trigger_pressure) / 2.0f;
       current_state.player_body->ApplyForceToCenter(force * b2Vec2(offset.x, offset.y), true);
       auto target_angle = current_state.player_body->GetAngle();
       if (glm::length(offset2) > 0.1f) {
@@ -284,7 +383,7 @@ namespace textengine {
         velocity *= max_velocity;
         current_state.player_body->SetLinearVelocity(velocity);
       }
-      current_state.world.Step(dt, 8, 3);
+      current_state.Step(dt);
     }
     current_state.camera_position = glm::mix(current_state.camera_position, position + 2.5f * offset2, 2e-2f / 0.016f * dt);
   }
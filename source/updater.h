@@ -3,57 +3,114 @@
 
 #include <Box2D/Box2D.h>
 #include <chrono>
+#include <cstdint>
 #include <glm/glm.hpp>
-#include <random>
-#include <tuple>
+#include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "controller.h"
 #include "gamestate.h"
+#include "messageselector.h"
+#include "proximityindex.h"
 #include "scene.h"
 
 namespace textengine {
 
+  class AmbiencePlayer;
+  class CueMixer;
   class Input;
   class Keyboard;
   class Log;
   class Mouse;
+  class Recorder;
   class SynchronizedQueue;
-
+  class WorldStreamer;
+  struct InputFrame;
+
+  /**
+   * Runs the game one tick at a time. Time advances by a fixed tick rather than by the clock, and
+   * messages are chosen with a seeded generator, so a session is reproduced exactly by the same
+   * seed and input frames.
+   */
   class Updater : public Controller, public b2ContactListener {
   public:
     Updater(int width, int height, SynchronizedQueue &reply_queue, SynchronizedQueue &voice_queue,
             Log &playtest_log, Input &input, Mouse &mouse, Keyboard &keyboard,
-            GameState &initial_state, Scene &scene);
+            GameState &initial_state, Scene &scene, WorldStreamer *world_streamer = nullptr);
 
     virtual ~Updater() = default;
 
     virtual void BeginContact(b2Contact* contact) override;
 
-    virtual void EndContact(b2Contact* contact) override;
+    /**
+     * A running hash of the messages sent so far, to compare a replay against its recording.
+     */
+    std::uint64_t digest() const;
 
     virtual GameState &GetCurrentState();
     
     glm::vec2 GetCursorPosition() const;
+
+    /**
+     * Restarts the message generator. A recording stores the seed so a replay can reuse it.
+     */
+    void Seed(std::uint64_t seed);
+
+    /**
+     * Loops the ambience of the area most recently entered among those the player is inside,
+     * crossfading as areas are entered and exited, or stops doing so if null.
+     */
+    void SetAmbiencePlayer(AmbiencePlayer *ambience);
+
+    /**
+     * Sounds a cue for each object within earshot, panned by its direction from the player and
+     * gained by its attenuation, or stops doing so if null.
+     */
+    void SetCueMixer(CueMixer *cues);
+
+    /**
+     * Writes the input of every following Update to recorder, or stops recording if null.
+     */
+    void SetRecorder(Recorder *recorder);
+
+    void SetSelectionPolicy(SelectionPolicy policy);
     
     virtual void SetModelViewProjection(glm::mat4 model_view_projection);
 
     virtual void Setup() override;
 
+    /**
+     * Samples the input devices and runs a tick.
+     */
     virtual void Update() override;
 
+    /**
+     * Runs a tick with the given input instead of the devices', as a replay does.
+     */
+    void Tick(const InputFrame &frame);
+
   private:
-    void Update(GameState &current_state);
+    void Update(GameState &current_state, const InputFrame &frame);
+
+    std::chrono::milliseconds Now() const;
+
+    InputFrame SampleInput();
 
-    std::tuple<Object *, Object *, b2Body *> ResolveContact(b2Contact *contact) const;
+    /**
+     * Sends text to the prompt and the voice, and adds it to the digest.
+     */
+    void Say(const std::string &text);
+
+    void Say(long id, const std::string &text);
+
+    std::pair<Handle, b2Body *> ResolveContact(b2Contact *contact) const;
 
     std::string ChooseMessage(const MessageMap &messages, const std::string &name);
     
     bool HasMessage(const MessageMap &messages, const std::string &name);
 
-    bool Inside(const std::unique_ptr<Object> &area) const;
-
     enum class Direction {
       kNorth,
       kSouth,
@@ -70,15 +127,22 @@ namespace textengine {
     Keyboard &keyboard;
     GameState &current_state;
     int phrase_index;
-    std::random_device generator;
-    std::uniform_real_distribution<float> distribution;
-    std::uniform_int_distribution<> index_distribution;
+    MessageSelector selector;
     Scene &scene;
+    WorldStreamer *world_streamer;
+    Recorder *recorder;
+    AmbiencePlayer *ambience;
+    CueMixer *cues;
+    std::uint64_t ticks, message_digest;
 
     Direction last_direction;
-    std::chrono::high_resolution_clock::time_point last_direction_time, last_transmit_time;
-    std::unordered_map<Object *, std::chrono::high_resolution_clock::time_point> last_touch_time;
-    std::unordered_set<Object *> inside;
+    std::chrono::milliseconds last_direction_time, last_transmit_time;
+    std::unordered_map<Handle, std::chrono::milliseconds, HandleHash> last_touch_time;
+    std::vector<Handle> entered, exited, nearby;
+
+    /** The areas with ambience that the player is inside, in the order they were entered. */
+    std::vector<std::pair<Handle, std::string>> ambient_areas;
+    ProximityIndex describable;
     
     glm::mat4 model_view_projection;
   };
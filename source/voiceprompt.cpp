@@ -1,25 +1,46 @@
-#include <cstdlib>
+#include <chrono>
+#include <thread>
 
+#include "audioengine.h"
 #include "synchronizedqueue.h"
 #include "voiceprompt.h"
 
 namespace textengine {
   
-  VoicePrompt::VoicePrompt(SynchronizedQueue &voice_queue) : voice_queue(voice_queue) {}
+  namespace {
+    
+    /** The queue cannot be waited on, so an empty one is checked again after this long. */
+    constexpr auto kPollInterval = std::chrono::milliseconds(10);
+    
+  }  // namespace
+  
+  VoicePrompt::VoicePrompt(SynchronizedQueue &voice_queue, AudioEngine &audio_engine)
+  : voice_queue(voice_queue), audio_engine(audio_engine), running(), thread() {}
+  
+  VoicePrompt::~VoicePrompt() {
+    running = false;
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
   
   void VoicePrompt::Loop() {
-    while (true) {
-      if (voice_queue.HasMessage()) {
-        const auto message = voice_queue.PopMessage();
-        const auto text = dynamic_cast<TextMessage *>(message.get());
-        std::system(("say --rate=250 \"" + text->text + "\"").c_str());
+    while (running) {
+      if (!voice_queue.HasMessage()) {
+        std::this_thread::sleep_for(kPollInterval);
+        continue;
+      }
+      const auto message = voice_queue.PopMessage();
+      const auto text = dynamic_cast<TextMessage *>(message.get());
+      if (text) {
+        audio_engine.Speak(text->text);
       }
     }
   }
 
   void VoicePrompt::Run() {
+    running = true;
     thread = std::thread(&VoicePrompt::Loop, this);
-    thread.detach();
   }
   
 }
@@ -1,19 +1,24 @@
 #ifndef __textengine__voiceprompt__
 #define __textengine__voiceprompt__
 
+#include <atomic>
 #include <thread>
 
 #include "prompt.h"
 
 namespace textengine {
   
+  class AudioEngine;
   class SynchronizedQueue;
   
+  /**
+   * Hands the text messages sent to voice_queue to an audio engine to speak.
+   */
   class VoicePrompt : public Prompt {
   public:
-    VoicePrompt(SynchronizedQueue &voice_queue);
+    VoicePrompt(SynchronizedQueue &voice_queue, AudioEngine &audio_engine);
     
-    virtual ~VoicePrompt() = default;
+    virtual ~VoicePrompt();
     
     virtual void Run() override;
     
@@ -22,6 +27,8 @@ namespace textengine {
     
   private:
     SynchronizedQueue &voice_queue;
+    AudioEngine &audio_engine;
+    std::atomic<bool> running;
     std::thread thread;
   };
   
@@ -1,18 +1,92 @@
 #include <ApplicationServices/ApplicationServices.h>
 #include <CoreFoundation/CFBundle.h>
 #include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
 
 #include "checks.h"
+#include "hash.h"
 #include "log.h"
+#include "metrics.h"
+#include "profiler.h"
 #include "synchronizedqueue.h"
 #include "websocketprompt.h"
 
 namespace textengine {
 
+  namespace {
+
+    constexpr int kGzipLevel = 9;
+
+    /** Deflate's window bits, plus sixteen for a gzip header and trailer. */
+    constexpr int kGzipWindowBits = 15 + 16;
+
+    std::string Gzip(const std::string &data) {
+      z_stream stream{};
+      CHECK_STATE(Z_OK == deflateInit2(&stream, kGzipLevel, Z_DEFLATED, kGzipWindowBits, 8,
+                                       Z_DEFAULT_STRATEGY));
+      std::string result(deflateBound(&stream, data.size()), '\0');
+      stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+      stream.avail_in = static_cast<uInt>(data.size());
+      stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+      stream.avail_out = static_cast<uInt>(result.size());
+      CHECK_STATE(Z_STREAM_END == deflate(&stream, Z_FINISH));
+      result.resize(stream.total_out);
+      deflateEnd(&stream);
+      return result;
+    }
+
+    /** A permessage-deflate statistic, exported summed over protocols. */
+    struct DeflateTotal {
+      const char *name, *help;
+      unsigned long long lws_ext_pm_deflate_stats::*total;
+      double scale;
+    };
+
+    constexpr DeflateTotal kDeflateTotals[] = {
+      {"textengine_websocket_deflate_messages_total", "Messages compressed before sending.",
+       &lws_ext_pm_deflate_stats::tx_messages, 1.0},
+      {"textengine_websocket_deflate_bytes_in_total", "Bytes of messages before compression.",
+       &lws_ext_pm_deflate_stats::tx_bytes_in, 1.0},
+      {"textengine_websocket_deflate_bytes_out_total", "Bytes of messages after compression.",
+       &lws_ext_pm_deflate_stats::tx_bytes_out, 1.0},
+      {"textengine_websocket_deflate_seconds_total", "Time spent compressing messages.",
+       &lws_ext_pm_deflate_stats::tx_usecs, 1e-6},
+      {"textengine_websocket_inflate_bytes_in_total", "Bytes of compressed messages received.",
+       &lws_ext_pm_deflate_stats::rx_bytes_in, 1.0},
+      {"textengine_websocket_inflate_bytes_out_total",
+       "Bytes of compressed messages received, once inflated.",
+       &lws_ext_pm_deflate_stats::rx_bytes_out, 1.0},
+      {"textengine_websocket_inflate_seconds_total", "Time spent inflating messages received.",
+       &lws_ext_pm_deflate_stats::rx_usecs, 1e-6}
+    };
+
+    /** The value of a request header, or empty if it was not sent. */
+    std::string Header(libwebsocket *wsi, lws_token_indexes token) {
+      const auto length = lws_hdr_total_length(wsi, token);
+      if (length <= 0) {
+        return std::string();
+      }
+      std::string value(length + 1, '\0');
+      lws_hdr_copy(wsi, &value[0], length + 1, token);
+      value.resize(length);
+      return value;
+    }
+
+  }  // namespace
+
+  Resource::Resource(const std::string &path, const std::string &content_type)
+  : path(path), content_type(content_type), body(), gzipped_body(), etag(), loaded() {}
+
   libwebsocket_protocols WebSocketPrompt::kProtocols[] = {
     {
       "http-only",
@@ -64,14 +138,42 @@ namespace textengine {
   WebSocketPrompt::WebSocketPrompt(SynchronizedQueue &reply_queue,
                                    const std::string &prompt,
                                    Log &log)
-  : reply_queue(reply_queue), prompt(prompt), log(log), thread(), context() {
+  : reply_queue(reply_queue), prompt(prompt), log(log), thread(), context(), client_count(),
+    compressed(), deflate_options(), extensions(), send_buffer() {
     instance = this;
+    Metrics::Watch("textengine_websocket_clients", "Connected websocket clients.", [this] () {
+      return client_count.load();
+    });
+    // Exported while serving /metrics, on the service thread that counts them.
+    for (const auto &total : kDeflateTotals) {
+      Metrics::WatchTotal(total.name, total.help, [this, &total] () {
+        double sum = 0.0;
+        for (const auto &options : deflate_options) {
+          sum += options.stats.*total.total;
+        }
+        return sum * total.scale;
+      });
+    }
   }
 
   WebSocketPrompt::~WebSocketPrompt() {
     instance = nullptr;
   }
 
+  void WebSocketPrompt::Compress(const std::string &protocol, int level, int window_bits,
+                                 bool context_takeover) {
+    for (std::size_t i = 0; i < kProtocolCount; ++i) {
+      if (protocol == kProtocols[i].name) {
+        compressed[i] = true;
+        deflate_options[i].level = level;
+        deflate_options[i].window_bits = window_bits;
+        deflate_options[i].no_context_takeover = !context_takeover;
+        return;
+      }
+    }
+    FAIL("no protocol " + protocol);
+  }
+
   int WebSocketPrompt::HttpCallback(libwebsocket_context *context,
                                    libwebsocket *wsi,
                                    enum libwebsocket_callback_reasons reason,
@@ -81,13 +183,16 @@ namespace textengine {
     switch (reason) {
       case LWS_CALLBACK_HTTP: {
         const std::string url_path = reinterpret_cast<const char *>(in);
-        if (resource_map.cend() == resource_map.find(url_path)) {
+        if (kMetricsPath == url_path) {
+          // Sent whole, so the connection closes as it would after a file.
+          ServeMetrics(wsi);
           return -1;
         }
-        const auto &resource = resource_map[url_path];
-        std::cout << "serving " << resource.path << " (" << resource.content_type << ")" << std::endl;
-        if (libwebsockets_serve_http_file(context, wsi,
-                                          resource.path.c_str(), resource.content_type.c_str())) {
+        const auto resource = resource_map.find(url_path);
+        if (resource_map.cend() == resource || !resource->second.loaded) {
+          return -1;
+        }
+        if (ServeResource(context, wsi, resource->second)) {
           return -1;
         }
         break;
@@ -96,6 +201,12 @@ namespace textengine {
         return -1;
         break;
       }
+      case LWS_CALLBACK_CONFIRM_EXTENSION_OKAY: {
+        // Nonzero refuses: the deflate-frame drafts, and anything on protocols left uncompressed.
+        const auto protocol = libwebsockets_get_protocol(wsi);
+        return !instance || !protocol || !instance->compressed[protocol->protocol_index] ||
+            kPermessageDeflate != std::string(reinterpret_cast<const char *>(in));
+      }
       default:
         break;
     }
@@ -112,17 +223,32 @@ namespace textengine {
       return -1;
     }
     switch (reason) {
+      case LWS_CALLBACK_ESTABLISHED:
+        ++instance->client_count;
+        break;
+      case LWS_CALLBACK_CLOSED:
+        --instance->client_count;
+        break;
       case LWS_CALLBACK_SERVER_WRITEABLE: {
         const std::unique_ptr<picojson::value> response = instance->HandleResponse();
         if (response) {
+          PROFILE_SCOPE("websocket send");
           std::ostringstream out;
           out << *response;
-          const std::string json = out.str();
-          instance->log.LogMessage(json);
-          unsigned char buffer[LWS_SEND_BUFFER_PRE_PADDING + 8 * 4096 + LWS_SEND_BUFFER_POST_PADDING];
+          std::string json = out.str();
+          // Telemetry for a big scene runs to hundreds of kilobytes.
+          auto &buffer = instance->send_buffer;
+          buffer.resize(LWS_SEND_BUFFER_PRE_PADDING + json.size() + LWS_SEND_BUFFER_POST_PADDING);
           unsigned char *p = &buffer[LWS_SEND_BUFFER_PRE_PADDING];
           std::copy(json.begin(), json.end(), p);
-          CHECK_STATE(!libwebsocket_write(wsi, p, json.size(), LWS_WRITE_TEXT));
+          const auto size = json.size();
+          instance->log.LogMessage(std::move(json));
+          if (libwebsocket_write(wsi, p, size, LWS_WRITE_TEXT)) {
+            // The client went away partway through; closes its connection alone.
+            return -1;
+          }
+          Metrics::Add(Metrics::kMessagesSent);
+          Metrics::Add(Metrics::kBytesSent, size);
         }
         break;
       }
@@ -141,12 +267,90 @@ namespace textengine {
     }
   }
 
+  void WebSocketPrompt::LoadResources() {
+    std::size_t loaded = 0, bytes = 0, sent_bytes = 0;
+    for (auto &entry : resource_map) {
+      auto &resource = entry.second;
+      std::ifstream in(resource.path, std::ios_base::binary);
+      resource.body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      resource.loaded = !in.bad() && in.is_open();
+      if (!resource.loaded) {
+        std::cout << "could not read " << resource.path << std::endl;
+        continue;
+      }
+      char etag[24];
+      std::snprintf(etag, sizeof(etag), "\"%016llx\"", static_cast<unsigned long long>(
+          HashBytes(0, resource.body.data(), resource.body.size())));
+      resource.etag = etag;
+      resource.gzipped_body = Gzip(resource.body);
+      if (resource.gzipped_body.size() >= resource.body.size()) {
+        resource.gzipped_body.clear();
+      }
+      ++loaded;
+      bytes += resource.body.size();
+      sent_bytes += resource.gzipped_body.empty() ? resource.body.size()
+                                                  : resource.gzipped_body.size();
+    }
+    std::cout << "cached " << loaded << " resources: " << bytes / 1024 << " KB, "
+        << sent_bytes / 1024 << " KB with gzip" << std::endl;
+  }
+
+  int WebSocketPrompt::ServeResource(libwebsocket_context *context, libwebsocket *wsi,
+                                     const Resource &resource) {
+    std::ostringstream headers;
+    const auto if_none_match = Header(wsi, WSI_TOKEN_HTTP_IF_NONE_MATCH);
+    if (std::string::npos != if_none_match.find(resource.etag) || "*" == if_none_match) {
+      headers << "HTTP/1.0 304 Not Modified\x0d\x0aServer: libwebsockets\x0d\x0a"
+          << "ETag: " << resource.etag << "\x0d\x0a\x0d\x0a";
+      auto header_text = headers.str();
+      libwebsocket_write(wsi, reinterpret_cast<unsigned char *>(&header_text[0]),
+                         header_text.size(), LWS_WRITE_HTTP);
+      // Done, like a file that has been sent.
+      return 1;
+    }
+    const auto gzip = !resource.gzipped_body.empty() &&
+        std::string::npos != Header(wsi, WSI_TOKEN_HTTP_ACCEPT_ENCODING).find("gzip");
+    const auto &body = gzip ? resource.gzipped_body : resource.body;
+    // No-cache has the browser revalidate every time, which costs a 304 while nothing changes.
+    headers << "HTTP/1.0 200 OK\x0d\x0aServer: libwebsockets\x0d\x0a"
+        << "Content-Type: " << resource.content_type << "\x0d\x0a"
+        << "Content-Length: " << body.size() << "\x0d\x0a"
+        << "ETag: " << resource.etag << "\x0d\x0a"
+        << "Cache-Control: no-cache\x0d\x0aVary: Accept-Encoding\x0d\x0a"
+        << (gzip ? "Content-Encoding: gzip\x0d\x0a" : "") << "\x0d\x0a";
+    const auto header_text = headers.str();
+    return libwebsockets_serve_http_memory(
+        context, wsi, header_text.c_str(), header_text.size(),
+        reinterpret_cast<const unsigned char *>(body.data()), body.size());
+  }
+
+  void WebSocketPrompt::ServeMetrics(libwebsocket *wsi) {
+    const auto body = Metrics::Export();
+    std::ostringstream out;
+    out << "HTTP/1.0 200 OK\x0d\x0aServer: libwebsockets\x0d\x0a"
+        << "Content-Type: text/plain; version=0.0.4\x0d\x0a"
+        << "Content-Length: " << body.size() << "\x0d\x0a\x0d\x0a" << body;
+    const auto response = out.str();
+    std::vector<unsigned char> buffer(LWS_SEND_BUFFER_PRE_PADDING + response.size() +
+                                      LWS_SEND_BUFFER_POST_PADDING);
+    std::copy(response.begin(), response.end(), &buffer[LWS_SEND_BUFFER_PRE_PADDING]);
+    libwebsocket_write(wsi, &buffer[LWS_SEND_BUFFER_PRE_PADDING], response.size(),
+                       LWS_WRITE_HTTP);
+  }
+
   void WebSocketPrompt::Loop() {
+    // Only permessage-deflate, tuned per protocol by the options it is given.
+    for (auto extension = libwebsocket_get_internal_extensions(); extension->name; ++extension) {
+      if (kPermessageDeflate == std::string(extension->name)) {
+        extensions[0] = *extension;
+        extensions[0].per_context_private_data = deflate_options.data();
+      }
+    }
     lws_context_creation_info context_creation_info = {
       8888,
       nullptr,
       kProtocols,
-      libwebsocket_get_internal_extensions(),
+      extensions,
       nullptr,
       nullptr,
       nullptr,
@@ -183,6 +387,7 @@ namespace textengine {
   }
 
   void WebSocketPrompt::Run() {
+    LoadResources();
     thread = std::thread(&WebSocketPrompt::Loop, this);
     thread.detach();
   }
@@ -1,12 +1,16 @@
 #ifndef __textengine__websocketprompt__
 #define __textengine__websocketprompt__
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <libwebsockets.h>
 #include <memory>
 #include <picojson.h>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "prompt.h"
 
@@ -16,7 +20,13 @@ namespace textengine {
   class SynchronizedQueue;
   
   struct Resource {
+    Resource(const std::string &path, const std::string &content_type);
+
     std::string path, content_type;
+
+    /** Filled in by Run. The gzipped body is empty unless it is smaller. */
+    std::string body, gzipped_body, etag;
+    bool loaded;
   };
 
   class WebSocketPrompt : public Prompt {
@@ -25,6 +35,13 @@ namespace textengine {
 
     virtual ~WebSocketPrompt();
 
+    /**
+     * Offers permessage-deflate to clients of protocol, at a zlib level with a window of
+     * 2^window_bits bytes, kept from one message to the next given context takeover. Protocols
+     * not named here are sent uncompressed. Call before Run.
+     */
+    void Compress(const std::string &protocol, int level, int window_bits, bool context_takeover);
+
     void Run();
     
     static std::unordered_map<std::string, Resource> resource_map;
@@ -34,6 +51,8 @@ namespace textengine {
     static constexpr const char *kApplicationOpenTypeFont = u8"application/vnd.ms-opentype";
     static constexpr const char *kApplicationTrueTypeFont = u8"application/x-font-ttf";
     static constexpr const char *kImagePng = u8"image/png";
+    static constexpr const char *kMetricsPath = u8"/metrics";
+    static constexpr const char *kPermessageDeflate = u8"permessage-deflate";
     static constexpr const char *kTextHtml = u8"text/html";
     
     static int HttpCallback(libwebsocket_context *context,
@@ -50,22 +69,50 @@ namespace textengine {
                                           void *in,
                                           size_t length);
 
-    static libwebsocket_protocols kProtocols[];
+    static constexpr std::size_t kProtocolCount = 2;
+
+    static libwebsocket_protocols kProtocols[kProtocolCount + 1];
 
     static WebSocketPrompt *instance;
 
     void HandleRequest(picojson::value &message);
 
+    /**
+     * Reads every resource into memory, with its ETag and gzipped body.
+     */
+    static void LoadResources();
+
     std::unique_ptr<picojson::value> HandleResponse();
 
     void Loop();
 
+    /**
+     * Writes the current metrics as the whole response.
+     */
+    static void ServeMetrics(libwebsocket *wsi);
+
+    /**
+     * Starts sending resource, or sends a 304 if the client has it already. Returns what
+     * libwebsockets_serve_http_memory does: nonzero once the connection is done with.
+     */
+    static int ServeResource(libwebsocket_context *context, libwebsocket *wsi,
+                             const Resource &resource);
+
   private:
     SynchronizedQueue &reply_queue;
     const std::string &prompt;
     Log &log;
     std::thread thread;
     libwebsocket_context *context;
+    std::atomic<int> client_count;
+
+    /** By protocol index. The statistics in the options are counted by the service thread. */
+    std::array<bool, kProtocolCount> compressed;
+    std::array<lws_ext_pm_deflate_options, kProtocolCount> deflate_options;
+    libwebsocket_extension extensions[2];
+
+    /** Reused for each message sent, with the padding libwebsockets writes frame headers into. */
+    std::vector<unsigned char> send_buffer;
   };
 
 }  // namespace textengine
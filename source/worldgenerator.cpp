@@ -0,0 +1,183 @@
+#define STB_PERLIN_IMPLEMENTATION
+#include <stb_perlin.h>
+#undef STB_PERLIN_IMPLEMENTATION
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pcg32.h"
+#include "threadpool.h"
+#include "worldgenerator.h"
+
+namespace textengine {
+
+  namespace {
+
+    constexpr std::size_t kItemsPerChunk = 1024;
+
+    /** Metres between neighbouring items. */
+    constexpr float kCellSize = 4.0f;
+
+    /** How far items may stray from the centres of their cells, as a fraction of a cell. */
+    constexpr float kJitter = 0.3f;
+
+    /** Terrain changes over about this many metres; areas and objects clump at half of it. */
+    constexpr float kTerrainScale = 96.0f;
+
+    /** Noise above this makes an area rather than an object: about a quarter of items. */
+    constexpr float kAreaThreshold = 0.15f;
+
+    /** No solid object closer than this to the origin, so that the player starts free. */
+    constexpr float kClearingRadius = 6.0f;
+
+    struct Terrain {
+      const char *name;
+      const char *objects[4];
+      const char *areas[3];
+    };
+
+    constexpr Terrain kTerrains[] = {
+      {"marsh", {"sunken log", "reed bed", "heron's nest", "rotting stump"},
+       {"bog", "shallow pool", "mudflat"}},
+      {"meadow", {"hay bale", "fence post", "standing stone", "beehive"},
+       {"clearing", "flower patch", "sheep track"}},
+      {"forest", {"oak", "pine", "fallen log", "woodpile"},
+       {"glade", "thicket", "fern hollow"}},
+      {"hills", {"boulder", "cairn", "outcrop", "shepherd's hut"},
+       {"ridge", "scree slope", "hilltop"}}
+    };
+
+    constexpr const char *kAdjectives[] = {
+      "old", "mossy", "weathered", "crooked", "tall", "small", "broken", "lonely"
+    };
+
+    constexpr std::pair<const char *, const char *> kGlobalMessages[] = {
+      {"east", "You head to the east."},
+      {"look", "You look around."},
+      {"north", "You head to the north."},
+      {"run", "You start to run."},
+      {"south", "You head south."},
+      {"stop looking", "You return to your thoughts."},
+      {"walk", "You walk."},
+      {"west", "You go to the west."}
+    };
+
+    template <typename T, std::size_t N>
+    constexpr std::size_t Size(const T (&)[N]) {
+      return N;
+    }
+
+    float Uniform(Pcg32 &generator, float minimum, float maximum) {
+      return minimum + (maximum - minimum) * (generator() / 4294967296.0f);
+    }
+
+    /** The noun phrase with "a" or "an" before it. */
+    std::string Indefinite(const std::string &phrase) {
+      return (std::string("aeiou").find(phrase[0]) == std::string::npos ? "a " : "an ") + phrase;
+    }
+
+    void AddMessage(MessageMap &messages, const std::string &key, std::string &&text) {
+      auto &list = messages[key];
+      if (!list) {
+        list.reset(new MessageList());
+      }
+      list->emplace_back(new std::string(std::move(text)));
+    }
+
+  }  // namespace
+
+  WorldGenerator::WorldGenerator(std::uint64_t seed) : statistics(), seed(seed) {}
+
+  Scene WorldGenerator::Generate(std::size_t item_count, ThreadPool &pool) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(item_count)));
+    // stb_perlin repeats every 256 units on each axis, so the seed picks one of many slices,
+    // off the lattice where the noise is always zero.
+    const auto offset = glm::vec2((seed >> 8) % 256, (seed >> 16) % 256);
+    const auto slice = seed % 256 + 0.5f;
+    const Pcg32 generator(seed);
+    std::vector<Object> objects_out(item_count);
+    std::vector<ObjectDescription> descriptions_out(item_count);
+    std::vector<Kind> kinds(item_count);
+    pool.ParallelFor(item_count, kItemsPerChunk, [&] (std::size_t begin, std::size_t end,
+                                                      std::size_t) {
+      auto chunk_generator = generator.Stream(begin / kItemsPerChunk);
+      for (auto i = begin; i < end; ++i) {
+        const auto cell = glm::vec2(i % side, i / side) - glm::vec2(side / 2.0f - 0.5f);
+        const auto jitter = glm::vec2(Uniform(chunk_generator, -kJitter, kJitter),
+                                      Uniform(chunk_generator, -kJitter, kJitter));
+        const auto position = (cell + jitter) * kCellSize;
+        const auto sample = offset + position / kTerrainScale;
+        const auto elevation = stb_perlin_noise3(sample.x, sample.y, slice);
+        const auto clumping = stb_perlin_noise3(2.0f * sample.x, 2.0f * sample.y, slice + 0.25f);
+        const auto terrain_index = std::min<std::size_t>(
+            static_cast<std::size_t>(std::max(0.0f, (elevation + 0.5f) * Size(kTerrains))),
+            Size(kTerrains) - 1);
+        const auto &terrain = kTerrains[terrain_index];
+        const auto area = clumping > kAreaThreshold || glm::length(position) < kClearingRadius;
+        const std::string adjective = kAdjectives[chunk_generator.Below(Size(kAdjectives))];
+        const auto where = std::string(" in the ") + terrain.name + ".";
+        auto &object = objects_out[i];
+        auto &description = descriptions_out[i];
+        object.id = static_cast<long>(i);
+        object.invisible = false;
+        object.base_attenuation = 0.0f;
+        object.linear_attenuation = 0.0f;
+        object.quadratic_attenuation = 1.0f;
+        if (area) {
+          const auto half_extent = glm::vec2(Uniform(chunk_generator, 1.0f, 5.0f),
+                                             Uniform(chunk_generator, 1.0f, 5.0f));
+          object.shape = Shape::kAxisAlignedBoundingBox;
+          object.aabb = AxisAlignedBoundingBox{position - half_extent, position + half_extent};
+          description.name =
+              adjective + " " + terrain.areas[chunk_generator.Below(Size(terrain.areas))];
+          AddMessage(description.messages, "describe",
+                     "There is " + Indefinite(description.name) + where);
+          AddMessage(description.messages, "enter", "You enter the " + description.name + ".");
+          AddMessage(description.messages, "exit", "You leave the " + description.name + ".");
+          AddMessage(description.messages, "inside", "You are in the " + description.name + ".");
+        } else {
+          object.shape = chunk_generator.Below(3) ? Shape::kCircle : Shape::kAxisAlignedBoundingBox;
+          const auto radius = Uniform(chunk_generator, 0.3f, 1.2f);
+          object.aabb = AxisAlignedBoundingBox{position - glm::vec2(radius),
+                                               position + glm::vec2(radius)};
+          description.name =
+              adjective + " " + terrain.objects[chunk_generator.Below(Size(terrain.objects))];
+          AddMessage(description.messages, "describe",
+                     "There stands " + Indefinite(description.name) + where);
+          AddMessage(description.messages, "describe",
+                     "You sense " + Indefinite(description.name) + " nearby.");
+          AddMessage(description.messages, "touch",
+                     "You brush against the " + description.name + ".");
+        }
+        kinds[i] = area ? Kind::kArea : Kind::kObject;
+      }
+    });
+    const auto generated = std::chrono::high_resolution_clock::now();
+
+    MessageMap messages;
+    for (const auto &message : kGlobalMessages) {
+      AddMessage(messages, message.first, message.second);
+    }
+    Scene scene(item_count, std::move(messages));
+    const auto area_count = static_cast<std::size_t>(
+        std::count(kinds.cbegin(), kinds.cend(), Kind::kArea));
+    scene.Reserve(area_count, item_count - area_count);
+    for (std::size_t i = 0; i < item_count; ++i) {
+      scene.Insert(kinds[i], std::move(objects_out[i]), std::move(descriptions_out[i]));
+    }
+    statistics.area_count = area_count;
+    statistics.object_count = item_count - area_count;
+    statistics.generate = generated - start;
+    statistics.insert = std::chrono::high_resolution_clock::now() - generated;
+    return scene;
+  }
+
+}  // namespace textengine
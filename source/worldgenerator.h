@@ -0,0 +1,45 @@
+#ifndef __textengine__worldgenerator__
+#define __textengine__worldgenerator__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "scene.h"
+
+namespace textengine {
+
+  class ThreadPool;
+
+  /**
+   * Makes scenes of any size for benchmarking, the same every time for the same seed and item
+   * count.
+   *
+   * Items sit one to a cell of a square grid, jittered. Perlin noise picks each place's terrain,
+   * which sets the names and messages of what is found there, and whether a cell holds an area
+   * or an object. The player starts at the origin, which is kept clear of solid objects.
+   * Chunks of cells are generated in parallel, each from its own random stream, so the result
+   * does not depend on how the work is scheduled.
+   */
+  class WorldGenerator {
+  public:
+    struct Statistics {
+      std::size_t area_count, object_count;
+      std::chrono::duration<double, std::milli> generate, insert;
+    };
+
+    explicit WorldGenerator(std::uint64_t seed);
+
+    virtual ~WorldGenerator() = default;
+
+    Scene Generate(std::size_t item_count, ThreadPool &pool);
+
+    Statistics statistics;
+
+  private:
+    std::uint64_t seed;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__worldgenerator__) */
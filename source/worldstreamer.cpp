@@ -0,0 +1,305 @@
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "checks.h"
+#include "gamestate.h"
+#include "scene.h"
+#include "worldstreamer.h"
+
+namespace textengine {
+
+  namespace {
+
+    /**
+     * The trees are rebuilt once the items added since the last rebuild are at least this share
+     * of those resident, so streaming in a chunk now and then does not cost a rebuild each time.
+     */
+    constexpr std::size_t kRebuildDivisor = 4;
+
+    std::int64_t MakeKey(std::int32_t x, std::int32_t y) {
+      return static_cast<std::int64_t>(x) << 32 | static_cast<std::uint32_t>(y);
+    }
+
+  }  // namespace
+
+  WorldStreamer::WorldStreamer(Scene &scene, GameState &state, float chunk_size,
+                               float load_radius, float unload_radius,
+                               std::size_t bodies_per_update)
+  : scene(scene), state(state), chunk_size(chunk_size), load_radius(load_radius),
+    unload_radius(unload_radius), overhang(), bodies_per_update(bodies_per_update),
+    resident_items(), items_since_rebuild(),
+    chunks(), resident(), pending(), mutex(), condition(), requests(), ready(),
+    unused_bodies(), running(), thread() {
+    CHECK_STATE(chunk_size > 0);
+    CHECK_STATE(unload_radius > load_radius);
+    for (auto store : {&scene.areas, &scene.objects}) {
+      for (auto &object : *store) {
+        const auto key = KeyOf(object.aabb.center());
+        auto inserted = chunks.emplace(key, Chunk{object.aabb, {}, State::kUnloaded, 0, 0});
+        auto &chunk = inserted.first->second;
+        chunk.bounds.minimum = glm::min(chunk.bounds.minimum, object.aabb.minimum);
+        chunk.bounds.maximum = glm::max(chunk.bounds.maximum, object.aabb.maximum);
+        chunk.items.push_back(store->handle(object));
+      }
+    }
+    for (const auto &chunk : chunks) {
+      const auto cell = chunk_size * glm::vec2(static_cast<std::int32_t>(chunk.first >> 32),
+                                               static_cast<std::int32_t>(chunk.first));
+      const auto spill = glm::max(cell - chunk.second.bounds.minimum,
+                                  chunk.second.bounds.maximum - (cell + chunk_size));
+      overhang = std::max({overhang, spill.x, spill.y});
+    }
+  }
+
+  WorldStreamer::~WorldStreamer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+    condition.notify_one();
+    if (thread.joinable()) {
+      thread.join();
+    }
+    std::move(ready.begin(), ready.end(), std::back_inserter(pending));
+    for (auto &batch : pending) {
+      Discard(batch);
+    }
+    for (const auto body : unused_bodies) {
+      state.DestroyDetachedBody(body);
+    }
+  }
+
+  void WorldStreamer::LoadAround(glm::vec2 position) {
+    for (const auto key : NearbyKeys(position)) {
+      auto &chunk = chunks.at(key);
+      if (State::kLoaded != chunk.state && DistanceTo(chunk, position) <= load_radius) {
+        auto batch = Gather(key, ++chunk.request);
+        chunk.state = State::kLoading;
+        resident.insert(key);
+        auto budget = batch.items.size();
+        Apply(batch, budget);
+      }
+    }
+    MaybeRebuildTrees();
+  }
+
+  void WorldStreamer::Run() {
+    running = true;
+    thread = std::thread(&WorldStreamer::Loop, this);
+  }
+
+  void WorldStreamer::Update(glm::vec2 position) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::move(ready.begin(), ready.end(), std::back_inserter(pending));
+      ready.clear();
+    }
+    auto budget = bodies_per_update;
+    auto loaded = false;
+    while (!pending.empty() && budget) {
+      loaded = Apply(pending.front(), budget) || loaded;
+      if (pending.front().next == pending.front().items.size()) {
+        pending.pop_front();
+      }
+    }
+    if (loaded) {
+      MaybeRebuildTrees();
+    }
+
+    for (auto key = resident.begin(); key != resident.end();) {
+      auto &chunk = chunks.at(*key);
+      if (DistanceTo(chunk, position) > unload_radius) {
+        Unload(chunk);
+        key = resident.erase(key);
+      } else {
+        ++key;
+      }
+    }
+
+    std::vector<std::pair<std::int64_t, unsigned int>> wanted;
+    for (const auto key : NearbyKeys(position)) {
+      auto &chunk = chunks.at(key);
+      if (State::kUnloaded == chunk.state && DistanceTo(chunk, position) <= load_radius) {
+        chunk.state = State::kLoading;
+        resident.insert(key);
+        wanted.emplace_back(key, ++chunk.request);
+      }
+    }
+    if (!wanted.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.insert(requests.end(), wanted.begin(), wanted.end());
+      }
+      condition.notify_one();
+    }
+  }
+
+  std::size_t WorldStreamer::chunk_count() const {
+    return chunks.size();
+  }
+
+  std::size_t WorldStreamer::item_count() const {
+    return resident_items;
+  }
+
+  std::size_t WorldStreamer::loaded_chunk_count() const {
+    return std::count_if(chunks.cbegin(), chunks.cend(),
+                         [] (const std::pair<const std::int64_t, Chunk> &chunk) {
+      return State::kLoaded == chunk.second.state;
+    });
+  }
+
+  bool WorldStreamer::Apply(Batch &batch, std::size_t &budget) {
+    auto &chunk = chunks.at(batch.key);
+    if (State::kLoading != chunk.state || batch.request != chunk.request) {
+      Discard(batch);
+      return false;
+    }
+    for (; batch.next < batch.items.size() && budget; ++batch.next, --budget) {
+      auto &item = batch.items[batch.next];
+      if (item.body) {
+        state.AttachBody(item.handle, item.body);
+        item.body = nullptr;
+      } else {
+        state.CreateBody(item.handle, item.object, item.is_area);
+      }
+      ++chunk.resident_items;
+      ++resident_items;
+      ++items_since_rebuild;
+    }
+    if (batch.next == batch.items.size()) {
+      chunk.state = State::kLoaded;
+      return true;
+    }
+    return false;
+  }
+
+  void WorldStreamer::Discard(Batch &batch) {
+    std::vector<b2Body *> bodies;
+    for (; batch.next < batch.items.size(); ++batch.next) {
+      auto &item = batch.items[batch.next];
+      if (item.body) {
+        bodies.push_back(item.body);
+        item.body = nullptr;
+      }
+    }
+    FreeLater(bodies);
+  }
+
+  float WorldStreamer::DistanceTo(const Chunk &chunk, glm::vec2 position) const {
+    return glm::length(glm::max(glm::abs(chunk.bounds.center() - position)
+                                - chunk.bounds.half_extent(), glm::vec2()));
+  }
+
+  void WorldStreamer::FreeLater(const std::vector<b2Body *> &bodies) {
+    if (!bodies.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        unused_bodies.insert(unused_bodies.end(), bodies.begin(), bodies.end());
+      }
+      condition.notify_one();
+    }
+  }
+
+  WorldStreamer::Batch WorldStreamer::Gather(std::int64_t key, unsigned int request) const {
+    Batch batch{key, request, {}, 0};
+    const auto &items = chunks.at(key).items;
+    batch.items.reserve(items.size());
+    for (const auto handle : items) {
+      const auto object = scene.Find(handle);
+      if (object) {
+        const auto is_area = scene.IsArea(handle);
+        batch.items.push_back(Item{
+          handle, *object, is_area, is_area ? nullptr : state.CreateDetachedBody(handle, *object)
+        });
+      }
+    }
+    return batch;
+  }
+
+  std::int64_t WorldStreamer::KeyOf(glm::vec2 position) const {
+    const auto cell = glm::floor(position / chunk_size);
+    return MakeKey(static_cast<std::int32_t>(cell.x), static_cast<std::int32_t>(cell.y));
+  }
+
+  void WorldStreamer::Loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+      condition.wait(lock, [this] () {
+        return !running || !requests.empty() || !unused_bodies.empty();
+      });
+      if (!unused_bodies.empty()) {
+        std::vector<b2Body *> bodies;
+        bodies.swap(unused_bodies);
+        lock.unlock();
+        for (const auto body : bodies) {
+          state.DestroyDetachedBody(body);
+        }
+        lock.lock();
+      }
+      while (running && !requests.empty()) {
+        const auto request = requests.front();
+        requests.pop_front();
+        lock.unlock();
+        auto batch = Gather(request.first, request.second);
+        lock.lock();
+        ready.push_back(std::move(batch));
+      }
+    }
+  }
+
+  void WorldStreamer::MaybeRebuildTrees() {
+    if (items_since_rebuild && items_since_rebuild * kRebuildDivisor >= resident_items) {
+      state.RebuildTrees();
+      items_since_rebuild = 0;
+    }
+  }
+
+  std::vector<std::int64_t> WorldStreamer::NearbyKeys(glm::vec2 position) const {
+    const auto reach = load_radius + overhang;
+    const auto minimum = glm::floor((position - reach) / chunk_size);
+    const auto maximum = glm::floor((position + reach) / chunk_size);
+    std::vector<std::int64_t> keys;
+    const auto cells = glm::compMul(maximum - minimum + 1.0f);
+    if (cells > chunks.size()) {
+      for (const auto &chunk : chunks) {
+        keys.push_back(chunk.first);
+      }
+      return keys;
+    }
+    for (auto x = minimum.x; x <= maximum.x; ++x) {
+      for (auto y = minimum.y; y <= maximum.y; ++y) {
+        const auto key = MakeKey(static_cast<std::int32_t>(x), static_cast<std::int32_t>(y));
+        if (chunks.count(key)) {
+          keys.push_back(key);
+        }
+      }
+    }
+    return keys;
+  }
+
+  void WorldStreamer::Unload(Chunk &chunk) {
+    std::vector<b2Body *> bodies;
+    for (const auto handle : chunk.items) {
+      const auto body = state.DetachBody(handle);
+      if (body) {
+        bodies.push_back(body);
+      }
+      const auto description = scene.FindDescription(handle);
+      if (description) {
+        scene.EvictMessages(*description);
+      }
+    }
+    FreeLater(bodies);
+    resident_items -= chunk.resident_items;
+    chunk.resident_items = 0;
+    chunk.state = State::kUnloaded;
+  }
+
+}  // namespace textengine
@@ -0,0 +1,140 @@
+#ifndef __textengine__worldstreamer__
+#define __textengine__worldstreamer__
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "handle.h"
+#include "scene.h"
+
+namespace textengine {
+
+  class GameState;
+
+  /**
+   * Keeps Box2D bodies only for the part of a scene near the player. Items are bucketed into
+   * square chunks by the center of their bounding box; a chunk is loaded once its bounds come
+   * within load_radius of the player and unloaded once they are farther than unload_radius, so
+   * a player standing on a boundary does not make chunks thrash.
+   *
+   * A background thread gathers the items of requested chunks and builds their bodies outside the
+   * world, and frees the bodies of unloaded chunks. Adding bodies to and removing them from the
+   * world still happens in Update, at most bodies_per_update at a time.
+   */
+  class WorldStreamer {
+  public:
+    WorldStreamer(Scene &scene, GameState &state, float chunk_size, float load_radius,
+                  float unload_radius, std::size_t bodies_per_update);
+
+    virtual ~WorldStreamer();
+
+    /**
+     * Synchronously loads every chunk within load_radius of position.
+     */
+    void LoadAround(glm::vec2 position);
+
+    void Run();
+
+    void Update(glm::vec2 position);
+
+    std::size_t chunk_count() const;
+
+    /**
+     * The number of items that currently have a body, or for areas, are tracked.
+     */
+    std::size_t item_count() const;
+
+    std::size_t loaded_chunk_count() const;
+
+  private:
+    enum class State {
+      kUnloaded,
+      kLoading,
+      kLoaded
+    };
+
+    struct Chunk {
+      AxisAlignedBoundingBox bounds;
+      std::vector<Handle> items;
+      State state;
+      unsigned int request;
+      std::size_t resident_items;
+    };
+
+    struct Item {
+      Handle handle;
+      Object object;
+      bool is_area;
+      b2Body *body;
+    };
+
+    struct Batch {
+      std::int64_t key;
+      unsigned int request;
+      std::vector<Item> items;
+      std::size_t next;
+    };
+
+    /**
+     * Adds up to budget of the batch's items to the world and returns whether that finished
+     * loading its chunk.
+     */
+    bool Apply(Batch &batch, std::size_t &budget);
+
+    /**
+     * Skips the rest of a batch, freeing the bodies built for its remaining items.
+     */
+    void Discard(Batch &batch);
+
+    float DistanceTo(const Chunk &chunk, glm::vec2 position) const;
+
+    /**
+     * Hands bodies detached from the world on to the background thread to free.
+     */
+    void FreeLater(const std::vector<b2Body *> &bodies);
+
+    Batch Gather(std::int64_t key, unsigned int request) const;
+
+    std::int64_t KeyOf(glm::vec2 position) const;
+
+    void Loop();
+
+    /**
+     * Rebuilds the world's trees once enough items have been added since the last rebuild.
+     */
+    void MaybeRebuildTrees();
+
+    std::vector<std::int64_t> NearbyKeys(glm::vec2 position) const;
+
+    void Unload(Chunk &chunk);
+
+  private:
+    Scene &scene;
+    GameState &state;
+    float chunk_size, load_radius, unload_radius, overhang;
+    std::size_t bodies_per_update, resident_items, items_since_rebuild;
+    std::unordered_map<std::int64_t, Chunk> chunks;
+    std::unordered_set<std::int64_t> resident;
+    std::deque<Batch> pending;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::pair<std::int64_t, unsigned int>> requests;
+    std::deque<Batch> ready;
+    std::vector<b2Body *> unused_bodies;
+    bool running;
+    std::thread thread;
+  };
+
+}  // namespace textengine
+
+#endif /* defined(__textengine__worldstreamer__) */